@@ -9,6 +9,33 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+/* ======================== ビルド構成 ======================== */
+/* CMake の RPG_WITH_* で 0 にしたモジュールはソースごとリンクせず、
+ * プラグイン関数も登録しない。下の容量 (RPG_MAX_* など) も -D で上書きできる。
+ * ワールドスケジューラはバトルとダイアログの両方があるときだけ入る。 */
+#ifndef RPG_WITH_BATTLE
+#define RPG_WITH_BATTLE 1   /* バトル/ダメージ式/撃破確率/パーティ AI/コマンドキュー */
+#endif
+#ifndef RPG_WITH_DIALOG
+#define RPG_WITH_DIALOG 1   /* メッセージウィンドウ */
+#endif
+#ifndef RPG_WITH_SHOP
+#define RPG_WITH_SHOP   1   /* ショップ/取引 */
+#endif
+#ifndef RPG_WITH_NOVEL
+#define RPG_WITH_NOVEL  1   /* ノベル表示状態/バックログ/シナリオ */
+#endif
+#if RPG_WITH_NOVEL && !RPG_WITH_DIALOG
+#error "RPG_WITH_NOVEL には RPG_WITH_DIALOG が必要"
+#endif
+/* 1 にするとダメージ式と AI の採点を固定小数点 (1/10000 単位) で計算し、
+ * バトルの計算から浮動小数点をなくす。最適化フラグや CPU が違っても
+ * 同じシードなら同じ結果になる (ロックステップ/リプレイ検証用)。 */
+#ifndef RPG_DETERMINISTIC
+#define RPG_DETERMINISTIC 0
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,14 +76,29 @@ typedef struct {
     bool    used;
 } RPG_Skill;
 
+#ifndef RPG_MAX_ACTORS
 #define RPG_MAX_ACTORS  64
+#endif
+#if RPG_MAX_ACTORS < 1 || RPG_MAX_ACTORS > 255
+#error "RPG_MAX_ACTORS は 1〜255 (セッション/パーティは id を 8bit で持つ)"
+#endif
+#ifndef RPG_MAX_ITEMS
 #define RPG_MAX_ITEMS   256
+#endif
+#if RPG_MAX_ITEMS < 1 || RPG_MAX_ITEMS > 65535
+#error "RPG_MAX_ITEMS は 1〜65535 (セッションの装備/所持品と名前索引は id を 16bit で持つ)"
+#endif
+#ifndef RPG_MAX_SKILLS
 #define RPG_MAX_SKILLS  128
+#endif
 
 /* ── アクター DB ────────────────────────────────────────*/
 /** アクター登録/更新。id = 1〜MAX_ACTORS。 */
 void       rpg_actor_set(int id, const RPG_Actor* a);
+/** 書き換え用。差分/状態ハッシュ上は取得した時点で汚れ扱いになる。 */
 RPG_Actor* rpg_actor_get(int id);
+/** 読み取り専用 (汚れ印を付けない)。判定や表示だけならこちらを使う。 */
+const RPG_Actor* rpg_actor_peek(int id);
 /** アクターを初期化して登録 */
 void       rpg_actor_init(int id, const char* name,
                            int hp, int mp, int atk, int def, int spd);
@@ -73,8 +115,33 @@ RPG_Skill* rpg_skill_get(int id);
 void       rpg_skill_init(int id, const char* name, const char* desc,
                            int mp_cost, int power, int target);
 
+/* ── 二次索引 ──────────────────────────────────────────*/
+/* rpg_item_set/init, rpg_skill_set/init で差分更新される。
+ * rpg_item_get/rpg_skill_get で得たポインタ経由で種別/価格/名前/対象/MP を
+ * 書き換えた場合は、続けて rpg_db_reindex() を呼ぶこと。
+ * 一覧系は条件に合う id を out に最大 max 件書き、書いた件数を返す。 */
+#define RPG_INDEX_KINDS 16   /* 種別/対象 0〜15 はビット集合で引く (範囲外は走査) */
+
+/** 種別が type のアイテム (id 昇順) */
+int  rpg_item_find_by_type(int type, int* out, int max);
+/** 価格が [min_price, max_price] のアイテム (価格昇順)。type < 0 で全種別。 */
+int  rpg_item_find_by_price(int type, int min_price, int max_price, int* out, int max);
+/** 名前が一致するアイテム id (同名は最小 id)。なければ 0。 */
+int  rpg_item_find_by_name(const char* name);
+/** 対象が target のスキル (id 昇順) */
+int  rpg_skill_find_by_target(int target, int* out, int max);
+/** 消費 MP が [min_mp, max_mp] のスキル (MP 昇順)。target < 0 で全対象。 */
+int  rpg_skill_find_by_mp(int target, int min_mp, int max_mp, int* out, int max);
+/** 索引を DB から作り直す */
+void rpg_db_reindex(void);
+
 /* ======================== インベントリ ======================== */
+#ifndef RPG_MAX_INVENTORY
 #define RPG_MAX_INVENTORY 64
+#endif
+#if RPG_MAX_INVENTORY < 1 || RPG_MAX_INVENTORY > 65535
+#error "RPG_MAX_INVENTORY は 1〜65535 (セッションは件数を 16bit で持つ)"
+#endif
 
 void rpg_inventory_add(int item_id, int count);
 void rpg_inventory_remove(int item_id, int count);
@@ -82,6 +149,8 @@ int  rpg_inventory_count(int item_id);
 bool rpg_inventory_has(int item_id);
 /** 全インベントリを列挙。out_item_ids/out_counts に書き込み、件数を返す。 */
 int  rpg_inventory_list(int* out_item_ids, int* out_counts, int max);
+/** インベントリを空にする。 */
+void rpg_inventory_clear(void);
 
 /* ======================== バトル ======================== */
 
@@ -128,20 +197,92 @@ RPG_BattleState  rpg_battle_check(RPG_Battle* b);
 /** 次のターン (order by spd)。行動するactor_idを返す。 */
 int              rpg_battle_next_actor(RPG_Battle* b);
 
-/** ダメージ計算 (ATK vs DEF; 乱数あり)。 */
+/** ダメージ計算 (ATK vs DEF; 乱数あり)。揺らぎは ±base/10 (切り捨て)。 */
 int rpg_calc_damage(int atk, int def);
+/** バトルの乱数 (ダメージの揺らぎ・敵の狙い・レベルアップ・式の rand/vary) の
+ *  シード。同じシードなら環境によらず同じ系列。未設定なら最初の使用時に時刻で決める。 */
+void rpg_battle_seed(uint64_t seed);
+
+/* ── ダメージ式 ────────────────────────────────────────*/
+/* 式の文法は src/eng_formula.c の先頭を参照。
+ * 例: "vary(max(a.atk*4 - t.def*2, 1), 10)" (rpg_calc_damage と同じ) */
+typedef struct RPG_Formula RPG_Formula;
+
+/** 式をバイトコードにコンパイルする。失敗時は NULL、err に位置と理由。 */
+RPG_Formula* rpg_formula_compile(const char* src, char* err, size_t err_len);
+void         rpg_formula_free(RPG_Formula* f);
+/** 評価する。a/t は NULL なら全ステータス 0 扱い。 */
+double       rpg_formula_eval(const RPG_Formula* f, const RPG_Actor* a,
+                              const RPG_Actor* t, int power);
+/** 同じ攻撃者から n 体の対象への値をまとめて評価する。 */
+void         rpg_formula_eval_batch(const RPG_Formula* f, const RPG_Actor* a,
+                                    const RPG_Actor* const* targets, int n,
+                                    int power, double* out);
+/** 定数に畳み込まれた式なら true と値 */
+bool         rpg_formula_constant(const RPG_Formula* f, double* value);
+/** 命令数 */
+int          rpg_formula_length(const RPG_Formula* f);
+
+/** バトルで使う式を設定する。skill_id = 0 は通常攻撃 (自前の式を持たない
+ *  スキルにも使う)。src が NULL/"" なら解除。構文エラーは false。 */
+bool               rpg_damage_formula_set(int skill_id, const char* src);
+/** skill_id に効く式 (なければ通常攻撃の式, それもなければ NULL) */
+const RPG_Formula* rpg_damage_formula_get(int skill_id);
+/** 式 (未設定なら rpg_calc_damage) でダメージを求める。0 未満は 0。 */
+int  rpg_damage_compute(const RPG_Actor* a, const RPG_Actor* t, int skill_id);
+/** 乱数項を平均に置き換えたダメージ (AI の見積もり用。非線形な式では近似)。 */
+double rpg_damage_expected(const RPG_Actor* a, const RPG_Actor* t, int skill_id);
+void rpg_damage_compute_batch(const RPG_Actor* a, const RPG_Actor* const* targets,
+                              int n, int skill_id, int* out);
+
+/* ── ダメージ分布 / 撃破確率 ────────────────────────────*/
+/* rpg_damage_compute の乱数項をすべて列挙して厳密な分布を求める
+ * (乱数の剰余の偏りは無視して一様とみなす)。 */
+#define RPG_PMF_MAX_OUTCOMES (1L << 20)   /* 乱数の組み合わせの上限 */
+
+/** ダメージ分布。p[i] = P(ダメージ == min + i)。 */
+typedef struct {
+    int     min;
+    int     len;
+    double* p;
+} RPG_DamagePMF;
+
+/** 分布を求める (out->p は確保される)。組み合わせが多すぎると false。 */
+bool   rpg_damage_pmf(const RPG_Actor* a, const RPG_Actor* t, int skill_id, RPG_DamagePMF* out);
+void   rpg_damage_pmf_free(RPG_DamagePMF* pmf);
+/** P(ダメージ >= dmg) */
+double rpg_damage_pmf_at_least(const RPG_DamagePMF* pmf, int dmg);
+double rpg_damage_pmf_mean(const RPG_DamagePMF* pmf);
+/** 同じ分布の攻撃を hits 回受けて合計が hp 以上になる確率 */
+double rpg_kill_probability(const RPG_DamagePMF* hit, int hp, int hits);
+/**
+ * attackers[n] が毎ターン skills[n] (NULL なら通常攻撃) で target_id を攻撃したとき、
+ * out[k] = k+1 ターン目の終わりまでに倒している確率。攻撃側の MP や行動順、
+ * 状態異常は考えない。書いたターン数を返す (分布を求められなければ 0)。
+ */
+int    rpg_kill_curve(const int* attackers, const int* skills, int n,
+                      int target_id, int turns, double* out);
 
 /** 経験値獲得・レベルアップ処理。 */
 void rpg_gain_exp(int actor_id, int exp);
 
 /* ======================== ダイアログ ======================== */
 
-#define RPG_MSG_MAX_LEN 512
-#define RPG_MSG_QUEUE   16
+#ifndef RPG_MSG_QUEUE
+#define RPG_MSG_QUEUE     16    /* メッセージヘッダーの初期容量 (満杯時は倍に拡張) */
+#endif
+#ifndef RPG_DIALOG_CHUNK
+#define RPG_DIALOG_CHUNK  4096  /* 文字列アリーナ 1 チャンクのバイト数 */
+#endif
+
+/** 文字列アリーナのチャンク (eng_dialog.c 内部)。 */
+typedef struct RPG_DialogChunk RPG_DialogChunk;
 
+/** メッセージヘッダー。本文/話者はアリーナ内の文字列を指す。 */
 typedef struct {
-    char    text[RPG_MSG_MAX_LEN];
-    char    speaker[64];
+    const char*      text;          /* 本文 (NUL 終端) */
+    const char*      speaker;       /* 話者名 (NUL 終端) */
+    RPG_DialogChunk* chunk;         /* 本文/話者を格納しているチャンク */
     int     char_pos;      /* 現在表示文字数 */
     int     total_chars;   /* 総文字数 */
     float   timer;         /* 文字送りタイマー */
@@ -150,13 +291,30 @@ typedef struct {
 } RPG_DialogMsg;
 
 typedef struct {
-    RPG_DialogMsg queue[RPG_MSG_QUEUE];
-    int head, tail, count;
+    RPG_DialogMsg*   queue;       /* ヘッダーのリングバッファ (cap 件) */
+    int head, tail, count, cap;
+    RPG_DialogChunk* chunk_head;  /* 最古のチャンク */
+    RPG_DialogChunk* chunk_tail;  /* 書き込み中のチャンク */
+    RPG_DialogChunk* chunk_free;  /* 再利用待ちのチャンク */
 } RPG_Dialog;
 
+/** 空のダイアログとして初期化する (メモリは最初の追加時に確保)。 */
 void rpg_dialog_init(RPG_Dialog* d);
-/** メッセージをキューに追加。 */
+/** 全メッセージを破棄する。確保済みのメモリは再利用のため保持する。 */
+void rpg_dialog_clear(RPG_Dialog* d);
+/** 確保したメモリを全て解放する。以後は rpg_dialog_init 直後と同じ状態。 */
+void rpg_dialog_free(RPG_Dialog* d);
+/** メッセージをキューに追加。長さ・件数の上限は無い。 */
 void rpg_dialog_push(RPG_Dialog* d, const char* text, const char* speaker);
+/** n 件をまとめて追加。speakers は NULL 可。追加できた件数を返す。 */
+int  rpg_dialog_push_batch(RPG_Dialog* d, const char* const* texts,
+                           const char* const* speakers, int n);
+/**
+ * 改行区切りのテキストを 1 行 1 メッセージとして追加する。
+ * "話者\t本文" の行はタブの前を話者名とし、それ以外は default_speaker を使う。
+ * 追加できた件数を返す。
+ */
+int  rpg_dialog_push_lines(RPG_Dialog* d, const char* block, const char* default_speaker);
 /** 更新。dt=デルタ時間。 */
 void rpg_dialog_update(RPG_Dialog* d, float dt);
 /** 表示速度を変数で設定 (秒/文字)。 */
@@ -170,21 +328,123 @@ bool rpg_dialog_empty(const RPG_Dialog* d);
 
 /* ======================== フラグ・変数 ======================== */
 
+#ifndef RPG_MAX_FLAGS
 #define RPG_MAX_FLAGS 256
+#endif
+#ifndef RPG_MAX_VARS
 #define RPG_MAX_VARS  256
+#endif
+#if RPG_MAX_FLAGS < 1 || RPG_MAX_FLAGS > 65535 || RPG_MAX_VARS < 1 || RPG_MAX_VARS > 65535
+#error "RPG_MAX_FLAGS / RPG_MAX_VARS は 1〜65535 (セッションは件数を 16bit で持つ)"
+#endif
+#ifndef RPG_KEY_LEN
 #define RPG_KEY_LEN   64
+#endif
 
 void  rpg_flag_set(const char* key, bool val);
 bool  rpg_flag_get(const char* key);
+/** フラグが書き換わる (ロードを含む) たびに増える更新番号。 */
+uint32_t rpg_flag_version(void);
 void  rpg_var_set(const char* key, double val);
 double rpg_var_get(const char* key);
 
+/* ── 変更監視 ──────────────────────────────────────────*/
+/* フラグ/変数のキー (末尾 '*' で前方一致) やアクターの hp/alive/status を
+ * 監視し、変わったものだけを rpg_watch_drain で 1 フレームに 1 回取り出す。 */
+#ifndef RPG_MAX_WATCHES
+#define RPG_MAX_WATCHES 64
+#endif
+#ifndef RPG_WATCH_QUEUE
+#define RPG_WATCH_QUEUE 256   /* 取り出し前に溜められるイベント数 (あふれたら RESET) */
+#endif
+
+typedef enum {
+    RPG_WATCH_FLAG  = 0,
+    RPG_WATCH_VAR   = 1,
+    RPG_WATCH_ACTOR = 2,
+    RPG_WATCH_RESET = 3,   /* ロード/復元/あふれ: 監視対象を読み直すこと */
+} RPG_WatchKind;
+
+typedef struct {
+    int           watch_id;           /* RESET は 0 */
+    RPG_WatchKind kind;
+    int           actor_id;           /* ACTOR のみ */
+    char          key[RPG_KEY_LEN];   /* フラグ/変数のキー。ACTOR は "hp" / "alive" / "status" */
+    double        old_value;          /* 前回取り出した時点の値 (フラグ/alive は 0/1) */
+    double        new_value;
+} RPG_WatchEvent;
+
+/** 監視を登録し id (1〜, 満杯なら 0) を返す。 */
+int  rpg_watch_flag(const char* pattern);
+int  rpg_watch_var(const char* pattern);
+int  rpg_watch_actor(int actor_id);
+void rpg_watch_remove(int id);
+void rpg_watch_clear(void);
+/** 溜まったイベントを古い順に out[max] へ取り出し、件数を返す。
+ *  同じキーの変更は 1 件にまとめ、元の値に戻ったものは返さない。 */
+int  rpg_watch_drain(RPG_WatchEvent* out, int max);
+/** 取り出し待ちのフラグ/変数イベント数 (アクターは取り出し時に調べる) */
+int  rpg_watch_pending(void);
+
+/* ======================== クエスト ======================== */
+
+/**
+ * 出現条件/完了条件を持つクエスト。条件はフラグ/変数/アイテム数/
+ * パーティ在籍/他クエストの状態の式 (文法は src/eng_quest.c の先頭) で、
+ * 入力が変わったクエストだけを評価し直す。状態はセーブ/スナップショットに入る。
+ * 例: rpg_quest_define(2, "竜退治", "done:1 && item:7 >= 1", "flag:dragon_dead");
+ */
+#ifndef RPG_MAX_QUESTS
+#define RPG_MAX_QUESTS 512
+#endif
+#if RPG_MAX_QUESTS < 1 || RPG_MAX_QUESTS > 65535
+#error "RPG_MAX_QUESTS は 1〜65535 (セッションは id を 16bit で持つ)"
+#endif
+
+typedef enum {
+    RPG_QUEST_LOCKED    = 0,
+    RPG_QUEST_AVAILABLE = 1,
+    RPG_QUEST_ACTIVE    = 2,
+    RPG_QUEST_COMPLETED = 3,
+} RPG_QuestState;
+
+/** id = 1〜RPG_MAX_QUESTS。空の出現条件は常に真、空の完了条件は
+ *  rpg_quest_complete でのみ完了。構文エラーは false (stderr に理由)。 */
+bool           rpg_quest_define(int id, const char* name,
+                                const char* available_if, const char* complete_if);
+void           rpg_quest_clear(void);
+RPG_QuestState rpg_quest_state(int id);
+const char*    rpg_quest_name(int id);
+/** AVAILABLE → ACTIVE */
+bool           rpg_quest_start(int id);
+/** AVAILABLE/ACTIVE → COMPLETED (完了条件を待たずに) */
+bool           rpg_quest_complete(int id);
+/** 入力が変わったクエストの条件を評価し、状態が変わった件数を返す。 */
+int            rpg_quest_update(void);
+/** 前回の呼び出し以降に state になったクエスト id を out[max] に書き、件数を返す
+ *  (先に rpg_quest_update する)。 */
+int            rpg_quest_newly(RPG_QuestState state, int* out, int max);
+/** 条件を評価した回数の累計 (計測用) */
+uint64_t       rpg_quest_evaluations(void);
+
 /* ======================== セーブ/ロード ======================== */
 
-#define RPG_SAVE_SLOTS 9
+#define RPG_SAVE_SLOTS     9    /* 旧形式のスロット数 (カタログ移行時にだけ参照) */
+#define RPG_SAVE_LOCATION  64
+
+/** セーブ一覧の 1 件 (カタログに保存される要約)。 */
+typedef struct {
+    int      slot;
+    int64_t  timestamp;                    /* セーブ時刻 (UNIX 秒) */
+    uint32_t playtime;                     /* プレイ時間 (秒) */
+    int      gold;
+    int      party_count;
+    int      party_level[RPG_PARTY_MAX];
+    char     location[RPG_SAVE_LOCATION];
+} RPG_SaveInfo;
 
 /**
- * スロットにデータをセーブ。
+ * スロット (0 以上の任意の番号) にデータをセーブ。
  * data_type に応じて以下を自動シリアライズ:
  *   "actor"  : RPG_Actorデータ (id_start〜id_end)
  *   "item"   : RPG_Item DB
@@ -206,6 +466,245 @@ bool rpg_save_exists(int slot);
 /** セーブデータを削除。 */
 void rpg_save_delete(int slot);
 
+/**
+ * セーブ時にブロック単位の圧縮 (LZ4 相当、外部依存なし) をかけるか。既定は無効。
+ * 圧縮の有無はセーブデータのヘッダーに記録されるので、どちらの設定でも読める。
+ */
+void rpg_save_set_compress(bool on);
+bool rpg_save_get_compress(void);
+
+/**
+ * セーブと同じ形式をファイル以外へ出し入れする。
+ * 書き出しは小さなブロック単位で RPG_WriteFn に渡され、一時ファイルや
+ * 全体の中間コピーは作らない。RPG_ReadFn は要求バイト数を返せなければ失敗扱い。
+ */
+typedef bool   (*RPG_WriteFn)(void* ctx, const void* data, size_t size);
+typedef size_t (*RPG_ReadFn)(void* ctx, void* data, size_t size);
+bool   rpg_save_stream(RPG_WriteFn write, void* ctx);
+bool   rpg_load_stream(RPG_ReadFn read, void* ctx);
+/**
+ * buf (容量 cap) に書き出し、必要なバイト数を返す (0=失敗)。
+ * 戻り値が cap を超えた場合は buf の内容は不完全。buf=NULL でサイズだけ求められる。
+ */
+size_t rpg_serialize(void* buf, size_t cap);
+bool   rpg_deserialize(const void* buf, size_t size);
+
+/** 次のセーブでカタログに記録する場所名/プレイ時間 (秒)。 */
+void rpg_save_set_location(const char* location);
+void rpg_save_set_playtime(uint32_t seconds);
+
+/**
+ * セーブ一覧。catalog.dat を 1 回読むだけで全スロットの要約が得られる。
+ * 一覧はスロット番号の昇順。
+ */
+int                 rpg_save_catalog_count(void);
+const RPG_SaveInfo* rpg_save_catalog_get(int index);
+const RPG_SaveInfo* rpg_save_info(int slot);
+/** カタログをディスクから読み直す (他プロセスがセーブした場合など)。 */
+bool                rpg_save_catalog_reload(void);
+
+/* ======================== スナップショット (メモリ上) ======================== */
+
+#define RPG_SNAPSHOT_PAGE         4096   /* 共有単位 (バイト) */
+#ifndef RPG_SNAPSHOT_HISTORY
+#define RPG_SNAPSHOT_HISTORY      16     /* 既定の保持数 */
+#endif
+#define RPG_SNAPSHOT_HISTORY_MAX  256
+
+/**
+ * アクター/インベントリ/ゴールド/パーティ/習得スキル/フラグ/変数を
+ * メモリ上に保存し id (1〜) を返す (0=失敗)。直前のスナップショットから
+ * 変化したページだけをコピーする。保持数を超えると古いものから捨てる。
+ */
+int    rpg_snapshot_take(void);
+/** スナップショット id の状態に戻す (履歴は残る)。 */
+bool   rpg_snapshot_restore(int id);
+/** steps 個前 (1=最新) のスナップショットに戻し、それより新しいものを捨てる。 */
+bool   rpg_snapshot_undo(int steps);
+void   rpg_snapshot_drop(int id);
+void   rpg_snapshot_clear(void);
+void   rpg_snapshot_set_limit(int n);
+int    rpg_snapshot_count(void);
+/** back 個前 (0=最新) のスナップショット id (0=なし)。 */
+int    rpg_snapshot_id(int back);
+/** スナップショットが確保しているページの総バイト数。 */
+size_t rpg_snapshot_bytes(void);
+
+/* ======================== 状態差分 (観戦/レプリケーション) ======================== */
+
+/**
+ * スナップショットと同じ状態を RPG_DELTA_BLOCK バイトのブロック単位で追跡し、
+ * tick ごとに変わったブロックだけを小さなバイナリ差分にする。
+ * 送信側: rpg_delta_begin → (毎 tick) 状態を変更 → rpg_delta_commit →
+ * 受信者ごとに確認済みの tick を渡して rpg_delta_encode。
+ * 受信側: rpg_delta_apply し、rpg_delta_applied_tick を確認応答として返す。
+ * RPG_Actor* を保持して後から書き換えた場合は、もう一度 rpg_actor_get を
+ * 呼ぶか確定前に取り直すこと (汚れ印は取得時に付く)。
+ */
+#define RPG_DELTA_BLOCK   32    /* 追跡単位 (バイト) */
+#define RPG_DELTA_HISTORY 64    /* since として使える直近の tick 数 */
+
+/** 追跡を始める (現在の状態が tick 1)。 */
+bool     rpg_delta_begin(void);
+void     rpg_delta_end(void);
+/** 汚れたブロックを確定して tick を進める。変わったブロック数 (追跡中でなければ -1)。 */
+int      rpg_delta_commit(void);
+/** 確定済みの最新 tick (追跡中でなければ 0)。 */
+uint32_t rpg_delta_tick(void);
+/** since から最新 tick までの差分を buf (容量 cap) に書き、バイト数を返す。
+ *  buf = NULL なら必要なバイト数、容量不足は 0。since = 0 や履歴より
+ *  古い tick には全状態を書く。 */
+size_t   rpg_delta_encode(uint32_t since, void* buf, size_t cap);
+/** 差分を適用する。壊れている/レイアウトが違う/間の tick が抜けていれば
+ *  何も変えずに false。 */
+bool     rpg_delta_apply(const void* buf, size_t len);
+/** 受信側で最後に適用した差分の tick */
+uint32_t rpg_delta_applied_tick(void);
+
+/* ======================== 状態ハッシュ (デシンク検出) ======================== */
+
+/**
+ * 状態差分と同じ対象 (アクター/インベントリ/ゴールド/習得スキル/パーティ/
+ * フラグ/変数) の 64bit ハッシュ。レコード (アクター 1 人、フラグ 1 件など)
+ * ごとのハッシュの和で、変わったレコードだけ計算し直す。
+ * 最初の呼び出しで全体を計算して追跡を始める。同じビルド同士で比べること。
+ */
+uint64_t rpg_state_hash(void);
+/** レコードごとのハッシュを out[max] に書き、レコード数を返す (out = NULL 可)。 */
+int      rpg_state_hash_records(uint64_t* out, int max);
+/** 相手のレコードハッシュと比べ、違うレコード番号を out[max] に書いて件数を返す
+ *  (レコード数が違えば -1)。 */
+int      rpg_state_hash_diff(const uint64_t* theirs, int n, int* out, int max);
+/** レコード番号の説明 ("actor 3 (勇者)", "flag 12 (door_open)", "gold" など) */
+bool     rpg_state_hash_describe(int record, char* buf, size_t n);
+/** デバッグ用: 全レコードを計算し直し、汚れ印なしで書き換えられたレコードを
+ *  stderr に出して直す。件数を返す。 */
+int      rpg_state_hash_check(void);
+
+/* ======================== セッション (サーバー向け) ======================== */
+
+/**
+ * 1 プレイヤー分の可変状態 (アクターの HP/MP/経験値/ステータス/状態異常/装備、
+ * 習得スキル、インベントリ、ゴールド、パーティ、フラグ、変数) を狭い整数型で
+ * まとめたもの。名前や説明などの不変データは DB 側で全セッション共有。
+ * ダイアログ/バックログ/シナリオは含まない。
+ */
+typedef struct RPG_Session RPG_Session;
+
+/** 現在のワールドからセッションを作る (atk/def/spd/luk/level が int16 を超えると NULL)。 */
+RPG_Session* rpg_session_capture(void);
+/** セッションの状態をワールドへ展開する。 */
+bool         rpg_session_activate(const RPG_Session* s);
+void         rpg_session_free(RPG_Session* s);
+size_t       rpg_session_bytes(const RPG_Session* s);
+
+/* ======================== ワールドスケジューラ (サーバー向け) ======================== */
+
+/**
+ * 独立した多数のワールド (RPG_Session + ダイアログ + バトル) を抱え、
+ * rpg_sched_tick のたびにスレッドプールで 1 フレームずつ進める。
+ * ダイアログの文字送りはワールドごとに並列に走るが、ステータス/敵 AI/
+ * オートセーブはエンジン本体のワールドを借りるので 1 ワールドずつ直列になる。
+ * ワールドの追加/削除/操作は tick の外 (呼び出しスレッド) で行うこと。
+ */
+#define RPG_SCHED_MAX_WORLDS  256
+#define RPG_SCHED_MAX_WORKERS 64
+#define RPG_SCHED_LAT_WINDOW  256   /* レイテンシ統計に使う直近の tick 数 */
+
+typedef struct RPG_Scheduler RPG_Scheduler;
+
+/** ターン処理の後にエンジンのワールドを借りた状態で呼ばれる (任意)。 */
+typedef void (*RPG_WorldFn)(void* ud, int world, float dt);
+
+typedef struct {
+    uint64_t ticks;
+    uint64_t last_ns, p50_ns, p99_ns, max_ns;   /* tick 全体の所要時間 */
+    uint64_t world_runs;    /* 実行したワールド数の累計 */
+    uint64_t world_skips;   /* 遅れのため間引いた回数の累計 */
+    uint64_t steals;        /* 他のワーカーから盗んだ回数の累計 */
+    int      behind;        /* 現在間引き中のワールド数 */
+} RPG_SchedStats;
+
+/** workers = 呼び出しスレッドを含むスレッド数 (1 ならスレッドを作らない)。 */
+RPG_Scheduler* rpg_sched_create(int workers);
+void           rpg_sched_destroy(RPG_Scheduler* s);
+/** セッションを引き取ってワールドを作る。ワールド番号 (満杯なら -1)。 */
+int            rpg_sched_add_world(RPG_Scheduler* s, RPG_Session* session);
+void           rpg_sched_remove_world(RPG_Scheduler* s, int world);
+RPG_Dialog*    rpg_sched_world_dialog(RPG_Scheduler* s, int world);
+RPG_Battle*    rpg_sched_world_battle(RPG_Scheduler* s, int world);
+/** ステータス/敵 AI を turn_ticks tick ごとに進める (既定 1)。 */
+void           rpg_sched_world_turns(RPG_Scheduler* s, int world, int turn_ticks);
+/** every tick ごとに slot へオートセーブ (every <= 0 で無効)。遅れている間は見送る。 */
+void           rpg_sched_world_autosave(RPG_Scheduler* s, int world, int slot, int every);
+void           rpg_sched_world_hook(RPG_Scheduler* s, int world, RPG_WorldFn fn, void* ud);
+/** 担当ワーカーを固定する (worker < 0 で解除)。固定中は他から盗まれない。 */
+void           rpg_sched_world_pin(RPG_Scheduler* s, int world, int worker);
+/** ワールドをエンジンへ展開する / 変更を取り込む (tick の外でプレイヤー操作を反映する)。 */
+bool           rpg_sched_world_enter(RPG_Scheduler* s, int world);
+bool           rpg_sched_world_leave(RPG_Scheduler* s, int world);
+/** 1 ワールドあたりの予算 (ns)。超えたワールドは実行間隔を倍々に間引く (0 で無効)。 */
+void           rpg_sched_set_budget(RPG_Scheduler* s, uint64_t ns);
+/** 全ワールドを dt 秒進める。終わるまで戻らない。呼び出し前のワールドは復元される。 */
+bool           rpg_sched_tick(RPG_Scheduler* s, float dt);
+void           rpg_sched_stats(const RPG_Scheduler* s, RPG_SchedStats* out);
+
+/* ======================== バトルコマンドキュー (スレッド間) ======================== */
+
+/**
+ * ネットワークスレッドなどからバトルの行動を積み、バトルを持つスレッドが
+ * rpg_cmdq_drain で順番に適用する。適用結果は結果キューに入り、
+ * rpg_cmdq_poll で読み出す。どちらもロックフリー。
+ * push は任意のスレッドから、drain はバトルを持つ 1 スレッドから、
+ * poll は 1 スレッドから呼ぶこと。
+ */
+#define RPG_CMDQ_DEFAULT 1024   /* capacity <= 0 のときの容量 (2 の冪に切り上げ) */
+
+typedef struct RPG_CmdQueue RPG_CmdQueue;
+
+typedef struct {
+    uint32_t tag;          /* 呼び出し側の識別子 (結果にそのまま返る) */
+    int      actor_id;
+    int      act;          /* RPG_ActionType */
+    int      target_id;
+    int      param;
+} RPG_BattleCmd;
+
+typedef struct {
+    uint32_t        tag;
+    int             actor_id;
+    int             target_id;
+    bool            applied;   /* バトル終了後/存在しないアクターなら false */
+    int             damage;
+    int             turn;
+    RPG_BattleState state;     /* 適用後のバトル状態 */
+    char            msg[128];
+} RPG_BattleResult;
+
+RPG_CmdQueue* rpg_cmdq_create(int capacity);
+void          rpg_cmdq_destroy(RPG_CmdQueue* q);
+int           rpg_cmdq_capacity(const RPG_CmdQueue* q);
+/** 満杯なら false (待たない)。 */
+bool          rpg_cmdq_push(RPG_CmdQueue* q, const RPG_BattleCmd* cmd);
+/** 積まれた順に最大 max 件 (<= 0 で全件) 適用し、件数を返す。
+ *  結果キューが満杯になったらそこで止める。 */
+int           rpg_cmdq_drain(RPG_CmdQueue* q, RPG_Battle* b, int max);
+/** 結果を 1 件取り出す。なければ false。 */
+bool          rpg_cmdq_poll(RPG_CmdQueue* q, RPG_BattleResult* out);
+/** 満杯で push が断られた回数の累計 */
+uint64_t      rpg_cmdq_rejected(const RPG_CmdQueue* q);
+
+/* ======================== メモリ使用量 ======================== */
+
+typedef struct {
+    const char* name;    /* "actors", "flags", "backlog", "sessions" など */
+    size_t      bytes;
+} RPG_MemUsage;
+
+/** サブシステムごとの使用量を out[max] に書き込み、件数を返す。 */
+int    rpg_memory_report(RPG_MemUsage* out, int max);
+size_t rpg_memory_total(void);
+
 /* ======================== ゴールド ======================== */
 
 int  rpg_gold_get(void);
@@ -218,9 +717,69 @@ bool rpg_gold_spend(int amount);        /* 所持金が足りない場合 false
 /** ゴールドでアイテムを購入 (インベントリに追加)。足りない場合 false。 */
 bool rpg_shop_buy(int item_id, int count);
 
-/** インベントリのアイテムを売却 (買値の半額)。所持していない場合 false。 */
+/** インベントリのアイテムを売却 (買値の半額、未登録アイテムは 0)。所持していない場合 false。 */
 bool rpg_shop_sell(int item_id, int count);
 
+/* ======================== 取引 (トランザクション) ======================== */
+
+#ifndef RPG_TXN_MAX_OPS
+#define RPG_TXN_MAX_OPS 64
+#endif
+
+typedef enum {
+    RPG_TXN_BUY         = 0,   /* item_id を count 個購入 */
+    RPG_TXN_SELL        = 1,   /* item_id を count 個売却 (買値の半額) */
+    RPG_TXN_GOLD        = 2,   /* amount だけ所持金を増減 */
+    RPG_TXN_ITEM_ADD    = 3,   /* item_id を count 個入手 */
+    RPG_TXN_ITEM_REMOVE = 4,   /* item_id を count 個失う */
+} RPG_TxnOpType;
+
+typedef enum {
+    RPG_TXN_OK            = 0,
+    RPG_TXN_ERR_ARG       = 1,   /* 不正な個数/アイテム ID */
+    RPG_TXN_ERR_NO_ITEM   = 2,   /* 未登録アイテム */
+    RPG_TXN_ERR_GOLD      = 3,   /* 所持金不足 */
+    RPG_TXN_ERR_STOCK     = 4,   /* 所持数不足 */
+    RPG_TXN_ERR_CAPACITY  = 5,   /* インベントリ満杯 */
+    RPG_TXN_ERR_OVERFLOW  = 6,   /* 所持金/所持数が int を超える */
+    RPG_TXN_ERR_TOO_MANY  = 7,   /* 操作数が RPG_TXN_MAX_OPS を超えた */
+} RPG_TxnResult;
+
+typedef struct {
+    RPG_TxnOpType type;
+    int           item_id;
+    int           count;
+    int64_t       amount;
+} RPG_TxnOp;
+
+/** 複数の売買/ゴールド/在庫操作をまとめて検証・適用する取引。 */
+typedef struct {
+    RPG_TxnOp     ops[RPG_TXN_MAX_OPS];
+    int           count;
+    RPG_TxnResult error;        /* 直近の検証結果 */
+    int           error_index;  /* 失敗した操作の位置 (-1=なし) */
+} RPG_Txn;
+
+void rpg_txn_begin(RPG_Txn* t);
+/** 操作を積む。積めなければ false (t->error に理由)。 */
+bool rpg_txn_buy(RPG_Txn* t, int item_id, int count);
+bool rpg_txn_sell(RPG_Txn* t, int item_id, int count);
+bool rpg_txn_gold(RPG_Txn* t, int64_t amount);
+bool rpg_txn_item_add(RPG_Txn* t, int item_id, int count);
+bool rpg_txn_item_remove(RPG_Txn* t, int item_id, int count);
+/**
+ * 現在の所持金/インベントリに対して全操作を先頭から順に検証する。
+ * 途中で所持金や所持数が負になる、最終状態でインベントリが溢れる、
+ * 値が int を超える場合は失敗。状態は変更しない。
+ */
+RPG_TxnResult rpg_txn_validate(RPG_Txn* t);
+/** 検証に通れば全操作を適用する。失敗時は何も変更しない。 */
+RPG_TxnResult rpg_txn_commit(RPG_Txn* t);
+/** 積んだ操作を破棄する。 */
+void rpg_txn_rollback(RPG_Txn* t);
+/** 取引全体での所持金の増減 (検証はしない)。 */
+int64_t rpg_txn_gold_delta(const RPG_Txn* t);
+
 /* ======================== スキル習得/忘却 ======================== */
 
 /** アクターがスキルを習得する (skill_id % 64 の bit マスクで管理)。 */
@@ -260,7 +819,9 @@ int        rpg_status_tick(int actor_id);
 
 /* ======================== 選択肢 ======================== */
 
+#ifndef RPG_MAX_CHOICES
 #define RPG_MAX_CHOICES 8
+#endif
 
 typedef struct {
     char choices[RPG_MAX_CHOICES][64];
@@ -302,6 +863,13 @@ void rpg_equip_apply_stats(int actor_id);
 
 /* ======================== パーティ管理 (v1.3.0) ======================== */
 
+#ifndef RPG_PARTY_MGR_MAX
+#define RPG_PARTY_MGR_MAX 8
+#endif
+#if RPG_PARTY_MGR_MAX < 1 || RPG_PARTY_MGR_MAX > 255
+#error "RPG_PARTY_MGR_MAX は 1〜255 (セッションは人数を 8bit で持つ)"
+#endif
+
 /** パーティの全メンバーをクリアする。 */
 void rpg_party_clear(void);
 /** アクターをパーティに追加 (最大8人)。成功時true。 */
@@ -330,6 +898,45 @@ bool rpg_item_use(int actor_id, int item_id);
 /** 敵 enemy_id が生存パーティメンバーをランダムに攻撃する。戻り値: ダメージ量。 */
 int rpg_battle_enemy_auto_action(RPG_Battle* b, int enemy_id);
 
+/* ======================== パーティ AI (オートバトル) ======================== */
+
+/**
+ * 合法な行動 (通常攻撃 / 習得済みの攻撃スキル / 回復アイテム / 防御) を
+ * 重み付きの効用で採点し、パーティ全員の行動を一度に決める。
+ * 前のメンバーの行動で見込まれる敵 HP・味方 HP・アイテム数の変化を
+ * 後のメンバーの採点に反映するので、同じ敵への過剰攻撃や重複回復を避ける。
+ */
+typedef struct {
+    float damage;     /* 与ダメージ 1 あたり (残り HP を超える分は数えない) */
+    float kill;       /* 倒せる見込みの行動への加点 */
+    float focus;      /* 減っている敵ほど damage を増やす倍率 */
+    float heal;       /* 回復量 1 あたり (最大 HP を超える分は数えない) */
+    float low_hp;     /* 減っている味方ほど heal を増やす倍率 */
+    float revive;     /* 戦闘不能の味方を起こす加点 */
+    float mp_cost;    /* 消費 MP 1 あたりの減点 */
+    float item_cost;  /* アイテム 1 個あたりの減点 */
+    float defend;     /* 防御の点数 */
+} RPG_AIWeights;
+
+typedef struct {
+    int            actor_id;
+    RPG_ActionType act;
+    int            target_id;
+    int            param;      /* スキル id / アイテム id */
+    float          score;
+} RPG_AIChoice;
+
+void rpg_ai_default_weights(RPG_AIWeights* w);
+void rpg_ai_set_weights(const RPG_AIWeights* w);
+void rpg_ai_get_weights(RPG_AIWeights* w);
+/** 重みを 1 つ設定する (name = "damage" "kill" "focus" "heal" "low_hp"
+ *  "revive" "mp_cost" "item_cost" "defend")。未知の名前は false。 */
+bool rpg_ai_set_weight(const char* name, float value);
+/** 行動できる (生存中で麻痺していない) パーティ全員の行動を決めて out に書く。件数を返す。 */
+int  rpg_ai_plan(const RPG_Battle* b, RPG_AIChoice* out, int max);
+/** rpg_ai_plan の結果を順に実行する。実行した行動数を返す。 */
+int  rpg_ai_party_turn(RPG_Battle* b);
+
 /* ======================== ビジュアルノベル (v1.3.0) ======================== */
 
 /** 背景画像パスを設定/取得する。 */
@@ -354,11 +961,150 @@ bool  rpg_novel_get_skip(void);
 void  rpg_novel_set_auto_delay(float seconds);
 float rpg_novel_get_auto_delay(void);
 
-/** バックログ管理 (直近 16 件)。 */
+/**
+ * バックログ (追記専用・件数上限なし)。
+ * 取得した文字列は次にバックログ関数を呼ぶまで有効。
+ */
+typedef struct {
+    const char* speaker;
+    const char* text;
+} RPG_BacklogLine;
+
 void        rpg_novel_backlog_push(const char* speaker, const char* text);
 int         rpg_novel_backlog_count(void);
 const char* rpg_novel_backlog_speaker(int i);  /* i=0 が最古 */
 const char* rpg_novel_backlog_text(int i);
+/** i 番目の話者/本文を同時に取得する。範囲外なら false。 */
+bool        rpg_novel_backlog_get(int i, const char** speaker, const char** text);
+/** start から最大 n 件を out に取得し、取得件数を返す (ページ表示用)。 */
+int         rpg_novel_backlog_range(int start, int n, RPG_BacklogLine* out);
+/**
+ * 話者/本文に needle を含む行を from から探す。
+ * dir>=0 で新しい方へ、dir<0 で古い方へ。from<0 は端から。見つからなければ -1。
+ */
+int         rpg_novel_backlog_find(const char* needle, int from, int dir);
+/** 全件を破棄する。 */
+void        rpg_novel_backlog_clear(void);
+/**
+ * 古いチャンクを path へ退避し、直近 resident_chunks 個 (+書き込み中) だけを
+ * メモリに残す。path=NULL/"" で退避を止め、全件をメモリへ戻す。
+ */
+bool        rpg_novel_backlog_set_spill(const char* path, int resident_chunks);
+
+/* ======================== 抽選テーブル (エンカウント/ドロップ) ======================== */
+
+#ifndef RPG_MAX_TABLES
+#define RPG_MAX_TABLES  64
+#endif
+#ifndef RPG_TABLE_ROWS
+#define RPG_TABLE_ROWS  64
+#endif
+#if RPG_TABLE_ROWS < 1 || RPG_TABLE_ROWS > 64
+#error "RPG_TABLE_ROWS は 1〜64 (有効行を 64bit マスクで持つ)"
+#endif
+
+typedef enum {
+    RPG_ROW_NONE    = 0,   /* 何も起きない */
+    RPG_ROW_ENEMIES = 1,   /* 敵グループ (エンカウント) */
+    RPG_ROW_ITEM    = 2,   /* アイテム min〜max 個 */
+    RPG_ROW_GOLD    = 3,   /* ゴールド min〜max */
+} RPG_TableRowKind;
+
+/**
+ * 行の追加。id = 1〜RPG_MAX_TABLES、weight は正の整数。
+ * flag を指定するとそのフラグが真のときだけ有効 ("!キー" で偽のとき)。
+ * 戻り値: 行番号 (-1=失敗)。
+ */
+int  rpg_table_add_enemies(int id, int weight, const int* enemies /* 0終端 */, const char* flag);
+int  rpg_table_add_item(int id, int weight, int item_id, int min, int max, const char* flag);
+int  rpg_table_add_gold(int id, int weight, int min, int max, const char* flag);
+int  rpg_table_add_none(int id, int weight, const char* flag);
+void rpg_table_clear(int id);
+int  rpg_table_row_count(int id);
+RPG_TableRowKind rpg_table_row_kind(int id, int row);
+/** 抽選用乱数のシード (検証の再現用)。 */
+void rpg_table_seed(uint64_t seed);
+/** 1 回抽選して行番号を返す (O(1))。有効行が無ければ -1。 */
+int  rpg_table_roll(int id);
+/** n 回抽選し、行ごとの当選回数を out_hits[行数] に書き込む。行数を返す。 */
+int  rpg_table_roll_batch(int id, int n, int* out_hits);
+/** 抽選し、敵グループの行なら party (0終端) と戦うバトルを b に初期化する。行番号を返す。 */
+int  rpg_encounter_roll(int id, RPG_Battle* b, const int* party);
+/** rolls 回抽選し、アイテムをインベントリへ、ゴールドを所持金へ加える。入手アイテム総数を返す。 */
+int  rpg_loot_apply(int id, int rolls, int* out_gold);
+
+/* ======================== シナリオ (バイトコード) ======================== */
+
+/** コンパイル済みシナリオ (eng_scenario.c 内部)。 */
+typedef struct RPG_Scenario RPG_Scenario;
+
+/** rpg_scenario_run の戻り値: どの入力待ちで止まったか */
+typedef enum {
+    RPG_SCN_ERROR       = -1,
+    RPG_SCN_END         = 0,   /* @end / 末尾に到達 */
+    RPG_SCN_WAIT_MSG    = 1,   /* メッセージ表示中 (ダイアログが空になったら再実行) */
+    RPG_SCN_WAIT_CHOICE = 2,   /* 選択肢の選択待ち (選択後に再実行) */
+    RPG_SCN_WAIT_INPUT  = 3,   /* @wait による入力待ち (入力後に再実行) */
+} RPG_ScenarioState;
+
+/**
+ * シナリオテキストをバイトコードへコンパイルする。
+ * 失敗時は NULL を返し、err に "N 行目: 理由" を書き込む。
+ */
+RPG_Scenario* rpg_scenario_compile(const char* src, char* err, size_t errlen);
+/** ファイルから読み込んでコンパイルする。 */
+RPG_Scenario* rpg_scenario_load(const char* path, char* err, size_t errlen);
+void          rpg_scenario_free(RPG_Scenario* sc);
+/** 先頭へ戻す。 */
+void          rpg_scenario_reset(RPG_Scenario* sc);
+/** ラベルへ移動する。ラベルが無ければ false。 */
+bool          rpg_scenario_goto(RPG_Scenario* sc, const char* label);
+/** 現在位置 (セーブ用) の取得と復元。 */
+uint32_t      rpg_scenario_tell(const RPG_Scenario* sc);
+bool          rpg_scenario_seek(RPG_Scenario* sc, uint32_t pc);
+/**
+ * 次の入力待ちまで実行する。ダイアログ・選択肢メニュー・ノベルの
+ * 背景/立ち絵・フラグ/変数・バックログを直接更新する。
+ * スキップモード中はメッセージをバックログへ積むだけで選択肢まで進む。
+ */
+RPG_ScenarioState rpg_scenario_run(RPG_Scenario* sc, RPG_Dialog* d, RPG_ChoiceMenu* m);
+
+/* ======================== プロファイル ======================== */
+
+#define RPG_PROF_BUCKETS 40   /* log2 ヒストグラムのバケット数 */
+
+/** 計測対象を登録して ID を返す。name は静的な文字列であること。 */
+int      rpg_prof_register(const char* name);
+/** 計測の開始/停止。停止中は rpg_prof_record を呼ばない想定。 */
+void     rpg_prof_enable(bool on);
+bool     rpg_prof_enabled(void);
+/** 現在時刻 (ティック)。rpg_prof_record には差分を渡す。 */
+uint64_t rpg_prof_now(void);
+/** 単調時計 (ns)。 */
+uint64_t rpg_prof_clock_ns(void);
+void     rpg_prof_record(int id, uint64_t ticks);
+/** 全計測値をゼロに戻す。 */
+void     rpg_prof_reset(void);
+/** 合計時間の降順で表を標準出力へ表示する。 */
+void     rpg_prof_print(void);
+/** 集計結果をヒストグラム付き JSON で書き出す。 */
+bool     rpg_prof_write_json(const char* path);
+
+/* ======================== トレース ======================== */
+
+#ifndef RPG_TRACE_RING
+#define RPG_TRACE_RING 4096   /* スレッドごとに保持するスパン数 */
+#endif
+
+/** スパン記録の開始/停止。 */
+void     rpg_trace_enable(bool on);
+bool     rpg_trace_enabled(void);
+/** スパン開始。無効時は 0 を返し、対応する rpg_trace_end は何もしない。 */
+uint64_t rpg_trace_begin(void);
+/** スパン終了。name は静的な文字列であること。 */
+void     rpg_trace_end(const char* name, uint64_t begin);
+/** 未出力のスパンを Chrome trace JSON として書き出す。 */
+bool     rpg_trace_write(const char* path);
 
 #ifdef __cplusplus
 }
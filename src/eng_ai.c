@@ -0,0 +1,243 @@
+/**
+ * src/eng_ai.c — パーティのオートバトル AI (効用スコア方式)
+ *
+ * 各メンバーについて、通常攻撃・習得済みの攻撃スキル (対象 0/1)・
+ * 回復アイテム・防御の全候補を RPG_AIWeights で採点し、最高点を選ぶ。
+ * ダメージは rpg_damage_expected (乱数項を平均にした見積もり) を使うので
+ * 1 候補あたり式を 1 回評価するだけで済む。
+ *
+ * 計画 (rpg_ai_plan) では前のメンバーの行動で見込まれる敵/味方の HP と
+ * アイテム数を AIState に反映してから次のメンバーを採点する。
+ * 実行 (rpg_ai_party_turn) は 1 人ずつ実際の状態から選び直して実行する。
+ *
+ * RPG_DETERMINISTIC では採点を固定小数点で行う (下の「点数」)。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define AI_DEFAULT_WEIGHTS {                          \
+    .damage = 1.0f, .kill = 50.0f, .focus = 0.5f,     \
+    .heal = 1.2f, .low_hp = 1.0f, .revive = 200.0f,   \
+    .mp_cost = 2.0f, .item_cost = 10.0f, .defend = 0.0f }
+
+static RPG_AIWeights g_weights = AI_DEFAULT_WEIGHTS;
+
+void rpg_ai_default_weights(RPG_AIWeights* w) {
+    if (w) *w = (RPG_AIWeights)AI_DEFAULT_WEIGHTS;
+}
+void rpg_ai_set_weights(const RPG_AIWeights* w) { if (w) g_weights = *w; }
+void rpg_ai_get_weights(RPG_AIWeights* w)       { if (w) *w = g_weights; }
+
+bool rpg_ai_set_weight(const char* name, float value) {
+    static const struct { const char* name; size_t off; } k_names[] = {
+        { "damage",    offsetof(RPG_AIWeights, damage) },
+        { "kill",      offsetof(RPG_AIWeights, kill) },
+        { "focus",     offsetof(RPG_AIWeights, focus) },
+        { "heal",      offsetof(RPG_AIWeights, heal) },
+        { "low_hp",    offsetof(RPG_AIWeights, low_hp) },
+        { "revive",    offsetof(RPG_AIWeights, revive) },
+        { "mp_cost",   offsetof(RPG_AIWeights, mp_cost) },
+        { "item_cost", offsetof(RPG_AIWeights, item_cost) },
+        { "defend",    offsetof(RPG_AIWeights, defend) },
+    };
+    if (!name) return false;
+    for (size_t i = 0; i < sizeof(k_names) / sizeof(k_names[0]); ++i) {
+        if (strcmp(name, k_names[i].name) != 0) continue;
+        *(float*)((char*)&g_weights + k_names[i].off) = value;
+        return true;
+    }
+    return false;
+}
+
+/* ── 点数 ───────────────────────────────────────────────*/
+#if RPG_DETERMINISTIC
+/* 1/10000 単位の int64。float のままだと FMA への縮約などで同点付近の大小が
+ * ビルドごとに入れ替わり、選ぶ行動が変わる。積の端数は -∞ 方向に切り捨て、
+ * 比は 0 方向、大きすぎる値は ±2^60 に飽和させる (4 項の和まであふれない)。 */
+typedef int64_t AIScore;
+#define AI_ONE ((AIScore)10000)
+#define AI_MAX ((AIScore)1 << 60)
+
+static inline AIScore ai_sat(AIScore v) { return v > AI_MAX ? AI_MAX : v < -AI_MAX ? -AI_MAX : v; }
+
+/* 重み (最も近い 1/10000、±2^31/10000 で打ち切り) */
+static AIScore ai_w(float w) {
+    if (w != w) return 0;
+    double q = (double)w * 10000.0;   /* float の積は double で正確 */
+    if (q >  0x1p31) q =  0x1p31;
+    if (q < -0x1p31) q = -0x1p31;
+    return (AIScore)llround(q);
+}
+static inline AIScore ai_scale(AIScore w, int n) { return ai_sat(w * n); }   /* |w| <= 2^31 */
+static AIScore ai_mul(AIScore x, AIScore y) {
+    AIScore p;
+    if (__builtin_mul_overflow(x, y, &p)) return (x < 0) != (y < 0) ? -AI_MAX : AI_MAX;
+    AIScore q = p / AI_ONE;
+    return ai_sat(p % AI_ONE < 0 ? q - 1 : q);
+}
+static inline AIScore ai_ratio(int num, int den) { return (AIScore)num * AI_ONE / den; }
+static inline float   ai_to_float(AIScore v)     { return (float)((double)v / AI_ONE); }
+#else
+typedef float AIScore;
+#define AI_ONE 1.0f
+
+static inline AIScore ai_w(float w)                 { return w; }
+static inline AIScore ai_scale(AIScore w, int n)    { return w * (float)n; }
+static inline AIScore ai_mul(AIScore x, AIScore y)  { return x * y; }
+static inline AIScore ai_ratio(int num, int den)    { return (float)num / (float)den; }
+static inline float   ai_to_float(AIScore v)        { return v; }
+#endif
+
+/* ── 見込みの状態 ───────────────────────────────────────*/
+typedef struct {
+    int enemy[RPG_PARTY_MAX], enemy_hp[RPG_PARTY_MAX], n_enemy;
+    int ally[RPG_PARTY_MAX],  ally_hp[RPG_PARTY_MAX],  n_ally;
+    int item[RPG_MAX_INVENTORY], item_count[RPG_MAX_INVENTORY], n_item;   /* 回復アイテムのみ */
+    int skill[RPG_MAX_SKILLS], n_skill;                                   /* 攻撃スキルのみ */
+} AIState;
+
+typedef struct {
+    RPG_AIChoice c;
+    int          slot;     /* enemy[] / ally[] / item[] の添字 */
+    int          amount;   /* 見込みのダメージ/回復量 */
+    int          item_slot;
+    AIScore      score;    /* 比較に使う点数 (c.score はその float 表示) */
+} AIPick;
+
+static void state_load(AIState* s, const RPG_Battle* b) {
+    memset(s, 0, sizeof(*s));
+    for (int i = 0; i < b->enemy_size; ++i) {
+        const RPG_Actor* e = rpg_actor_peek(b->enemy[i]);
+        s->enemy[s->n_enemy]      = b->enemy[i];
+        s->enemy_hp[s->n_enemy++] = (e && e->alive) ? e->hp : 0;
+    }
+    for (int i = 0; i < b->party_size; ++i) {
+        const RPG_Actor* a = rpg_actor_peek(b->party[i]);
+        s->ally[s->n_ally]      = b->party[i];
+        s->ally_hp[s->n_ally++] = (a && a->alive) ? a->hp : 0;
+    }
+    int ids[RPG_MAX_INVENTORY], counts[RPG_MAX_INVENTORY];
+    int n = rpg_inventory_list(ids, counts, RPG_MAX_INVENTORY);
+    for (int i = 0; i < n; ++i) {
+        const RPG_Item* it = rpg_item_get(ids[i]);
+        if (!it || it->type != 0 || it->effect <= 0 || counts[i] <= 0) continue;
+        s->item[s->n_item]         = ids[i];
+        s->item_count[s->n_item++] = counts[i];
+    }
+    /* 対象 2/3 のスキルもバトルでは相手にダメージを与えるだけなので候補にしない */
+    s->n_skill  = rpg_skill_find_by_target(0, s->skill, RPG_MAX_SKILLS);
+    s->n_skill += rpg_skill_find_by_target(1, s->skill + s->n_skill, RPG_MAX_SKILLS - s->n_skill);
+}
+
+static void consider(AIPick* best, const AIPick* p) {
+    if (p->score > best->score) *best = *p;
+}
+
+static AIPick choose(const AIState* s, int actor_id) {
+    const RPG_AIWeights* w = &g_weights;
+    const AIScore w_damage = ai_w(w->damage), w_kill = ai_w(w->kill), w_focus = ai_w(w->focus);
+    const AIScore w_heal = ai_w(w->heal), w_low_hp = ai_w(w->low_hp), w_revive = ai_w(w->revive);
+    const AIScore w_mp_cost = ai_w(w->mp_cost), w_item_cost = ai_w(w->item_cost);
+    const RPG_Actor* a = rpg_actor_peek(actor_id);
+    AIPick best = { { actor_id, RPG_ACT_DEFEND, actor_id, 0, w->defend }, -1, 0, -1, ai_w(w->defend) };
+    if (!a) return best;
+
+    /* 攻撃: 通常攻撃 + スキル × 生存中の敵 */
+    for (int j = 0; j < s->n_enemy; ++j) {
+        int hp = s->enemy_hp[j];
+        const RPG_Actor* e = rpg_actor_peek(s->enemy[j]);
+        if (hp <= 0 || !e) continue;
+        AIScore focus = AI_ONE + (e->max_hp > 0 ? ai_mul(w_focus, ai_ratio(e->max_hp - hp, e->max_hp)) : 0);
+        for (int k = -1; k < s->n_skill; ++k) {
+            int sid = k < 0 ? 0 : s->skill[k];
+            int mp  = 0;
+            if (sid) {
+                const RPG_Skill* sk = rpg_skill_get(sid);
+                if (!sk || !rpg_actor_has_skill(actor_id, sid) || a->mp < sk->mp_cost) continue;
+                mp = sk->mp_cost;
+            }
+            int dmg = (int)rpg_damage_expected(a, e, sid);
+            int eff = dmg < hp ? dmg : hp;
+            AIPick p = { { actor_id, sid ? RPG_ACT_SKILL : RPG_ACT_ATTACK, s->enemy[j], sid, 0 }, j, dmg, -1, 0 };
+            p.score = ai_mul(ai_scale(w_damage, eff), focus) + (dmg >= hp ? w_kill : 0) - ai_scale(w_mp_cost, mp);
+            consider(&best, &p);
+        }
+    }
+
+    /* 回復アイテム × 味方 */
+    for (int i = 0; i < s->n_item; ++i) {
+        if (s->item_count[i] <= 0) continue;
+        const RPG_Item* it = rpg_item_get(s->item[i]);
+        for (int j = 0; j < s->n_ally; ++j) {
+            const RPG_Actor* t = rpg_actor_peek(s->ally[j]);
+            if (!t || t->max_hp <= 0) continue;
+            int hp = s->ally_hp[j], missing = t->max_hp - hp;
+            if (missing <= 0) continue;
+            int gain = it->effect < missing ? it->effect : missing;
+            AIPick p = { { actor_id, RPG_ACT_ITEM, s->ally[j], s->item[i], 0 }, j, gain, i, 0 };
+            p.score = ai_mul(ai_scale(w_heal, gain), AI_ONE + ai_mul(w_low_hp, ai_ratio(missing, t->max_hp)))
+                    + (hp <= 0 ? w_revive : 0) - w_item_cost;
+            consider(&best, &p);
+        }
+    }
+    best.c.score = ai_to_float(best.score);
+    return best;
+}
+
+static void state_apply(AIState* s, const AIPick* p) {
+    switch (p->c.act) {
+    case RPG_ACT_ATTACK:
+    case RPG_ACT_SKILL:
+        s->enemy_hp[p->slot] -= p->amount;
+        if (s->enemy_hp[p->slot] < 0) s->enemy_hp[p->slot] = 0;
+        break;
+    case RPG_ACT_ITEM:
+        s->ally_hp[p->slot] += p->amount;
+        s->item_count[p->item_slot]--;
+        break;
+    default:
+        break;
+    }
+}
+
+static bool can_act(int actor_id) {
+    const RPG_Actor* a = rpg_actor_peek(actor_id);
+    return a && a->alive && !(a->status & RPG_STATUS_PARALYZE);
+}
+
+/* ── 計画/実行 ──────────────────────────────────────────*/
+int rpg_ai_plan(const RPG_Battle* b, RPG_AIChoice* out, int max) {
+    if (!b || !out || max <= 0 || b->state != RPG_BATTLE_RUNNING) return 0;
+    uint64_t tr = rpg_trace_begin();
+    AIState s;
+    state_load(&s, b);
+    int n = 0;
+    for (int i = 0; i < b->party_size && n < max; ++i) {
+        if (!can_act(b->party[i])) continue;
+        AIPick p = choose(&s, b->party[i]);
+        state_apply(&s, &p);
+        out[n++] = p.c;
+    }
+    rpg_trace_end("rpg_ai_plan", tr);
+    return n;
+}
+
+int rpg_ai_party_turn(RPG_Battle* b) {
+    if (!b) return 0;
+    uint64_t tr = rpg_trace_begin();
+    int done = 0;
+    AIState s;
+    for (int i = 0; i < b->party_size && b->state == RPG_BATTLE_RUNNING; ++i) {
+        if (!can_act(b->party[i])) continue;
+        state_load(&s, b);
+        AIPick p = choose(&s, b->party[i]);
+        rpg_battle_do_action(b, p.c.actor_id, p.c.act, p.c.target_id, p.c.param);
+        done++;
+    }
+    rpg_trace_end("rpg_ai_party_turn", tr);
+    return done;
+}
@@ -0,0 +1,286 @@
+/**
+ * src/eng_backlog.c — ビジュアルノベル用バックログ
+ *
+ * 追記専用。各行は "話者\0本文\0" としてチャンクに詰めて格納し、
+ * 行番号 → (チャンク, オフセット) の索引だけを配列で持つ。
+ * 退避ファイルを設定すると、古いチャンクはファイルへ書き出して
+ * メモリから外し、参照時に小さなキャッシュへ読み戻す。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BACKLOG_CHUNK  65536  /* 1 チャンクのバイト数 (超える行は専用チャンク) */
+#define BACKLOG_CACHE  4      /* 退避チャンクの読み戻しキャッシュ数 */
+
+typedef struct {
+    char*    data;      /* 常駐時のデータ (退避中は NULL) */
+    uint32_t used, cap;
+    long     file_off;  /* 退避先オフセット (-1=未退避) */
+} BacklogChunk;
+
+typedef struct { uint32_t chunk, off; } BacklogRef;
+
+typedef struct {
+    int   chunk;        /* -1=空き */
+    char* data;
+    unsigned stamp;     /* LRU 用 */
+} BacklogCache;
+
+static BacklogChunk* g_chunks = NULL;
+static int           g_chunk_count = 0, g_chunk_cap = 0;
+static BacklogRef*   g_refs = NULL;
+static int           g_ref_count = 0, g_ref_cap = 0;
+
+static FILE*        g_spill = NULL;
+static char         g_spill_path[256];
+static int          g_spill_resident = 0;   /* 常駐させておく満杯チャンク数 */
+static int          g_spill_next = 0;       /* 次に退避するチャンク番号 */
+static BacklogCache g_cache[BACKLOG_CACHE] = {
+    { -1, NULL, 0 }, { -1, NULL, 0 }, { -1, NULL, 0 }, { -1, NULL, 0 },
+};
+static unsigned     g_cache_clock = 0;
+
+/* ── チャンク読み出し ────────────────────────────────────*/
+static void cache_drop_all(void) {
+    for (int i = 0; i < BACKLOG_CACHE; ++i) {
+        free(g_cache[i].data);
+        g_cache[i].data  = NULL;
+        g_cache[i].chunk = -1;
+    }
+}
+
+/* チャンク ci のデータを返す。pin_from 以降に使われたキャッシュは追い出さない。 */
+static const char* chunk_data(int ci, unsigned pin_from) {
+    BacklogChunk* c = &g_chunks[ci];
+    if (c->data) return c->data;
+    BacklogCache* victim = NULL;
+    for (int i = 0; i < BACKLOG_CACHE; ++i) {
+        if (g_cache[i].chunk == ci) {
+            g_cache[i].stamp = ++g_cache_clock;
+            return g_cache[i].data;
+        }
+    }
+    for (int i = 0; i < BACKLOG_CACHE; ++i) {
+        BacklogCache* e = &g_cache[i];
+        if (e->chunk >= 0 && pin_from && e->stamp >= pin_from) continue;
+        if (!victim || e->chunk < 0 || (victim->chunk >= 0 && e->stamp < victim->stamp))
+            victim = e;
+    }
+    if (!victim || !g_spill) return NULL;
+    char* buf = realloc(victim->data, c->used ? c->used : 1);
+    if (!buf) return NULL;
+    victim->data  = buf;
+    victim->chunk = -1;
+    if (fseek(g_spill, c->file_off, SEEK_SET) != 0 ||
+        fread(buf, 1, c->used, g_spill) != c->used) {
+        fprintf(stderr, "[eng_rpg] バックログ読み戻し失敗\n");
+        return NULL;
+    }
+    victim->chunk = ci;
+    victim->stamp = ++g_cache_clock;
+    return buf;
+}
+
+/* ── 退避 ───────────────────────────────────────────────*/
+static void spill_old_chunks(void) {
+    if (!g_spill) return;
+    /* 最新チャンク (書き込み中) と直近 g_spill_resident 個は常駐のまま */
+    while (g_spill_next < g_chunk_count - 1 - g_spill_resident) {
+        BacklogChunk* c = &g_chunks[g_spill_next];
+        if (c->data) {
+            if (fseek(g_spill, 0, SEEK_END) != 0) return;
+            long off = ftell(g_spill);
+            if (off < 0 || fwrite(c->data, 1, c->used, g_spill) != c->used) {
+                fprintf(stderr, "[eng_rpg] バックログ退避失敗\n");
+                return;
+            }
+            c->file_off = off;
+            free(c->data);
+            c->data = NULL;
+        }
+        g_spill_next++;
+    }
+}
+
+bool rpg_novel_backlog_set_spill(const char* path, int resident_chunks) {
+    /* 退避済みチャンクを全てメモリへ戻してから切り替える */
+    for (int i = 0; i < g_chunk_count; ++i) {
+        BacklogChunk* c = &g_chunks[i];
+        if (c->data) continue;
+        const char* src = chunk_data(i, 0);
+        char* buf = src ? malloc(c->used ? c->used : 1) : NULL;
+        if (!buf) return false;
+        memcpy(buf, src, c->used);
+        c->data = buf;
+        c->file_off = -1;
+    }
+    cache_drop_all();
+    if (g_spill) { fclose(g_spill); g_spill = NULL; }
+    g_spill_next = 0;
+    if (!path || !*path) return true;
+    snprintf(g_spill_path, sizeof(g_spill_path), "%s", path);
+    g_spill = fopen(g_spill_path, "w+b");
+    if (!g_spill) {
+        fprintf(stderr, "[eng_rpg] バックログ退避ファイルを開けない: %s\n", path);
+        return false;
+    }
+    g_spill_resident = resident_chunks < 0 ? 0 : resident_chunks;
+    spill_old_chunks();
+    return true;
+}
+
+/* ── 追記 ───────────────────────────────────────────────*/
+static bool backlog_append(const char* speaker, size_t slen, const char* text, size_t tlen) {
+    size_t need = slen + 1 + tlen + 1;
+    if (need > UINT32_MAX) return false;
+    if (g_ref_count >= g_ref_cap) {
+        int cap = g_ref_cap ? g_ref_cap * 2 : 256;
+        BacklogRef* r = realloc(g_refs, sizeof(*r) * (size_t)cap);
+        if (!r) return false;
+        g_refs = r; g_ref_cap = cap;
+    }
+    BacklogChunk* c = g_chunk_count ? &g_chunks[g_chunk_count - 1] : NULL;
+    if (!c || !c->data || c->cap - c->used < need) {
+        if (g_chunk_count >= g_chunk_cap) {
+            int cap = g_chunk_cap ? g_chunk_cap * 2 : 16;
+            BacklogChunk* cs = realloc(g_chunks, sizeof(*cs) * (size_t)cap);
+            if (!cs) return false;
+            g_chunks = cs; g_chunk_cap = cap;
+        }
+        uint32_t cap = need > BACKLOG_CHUNK ? (uint32_t)need : BACKLOG_CHUNK;
+        char* data = malloc(cap);
+        if (!data) return false;
+        c = &g_chunks[g_chunk_count++];
+        c->data = data; c->used = 0; c->cap = cap; c->file_off = -1;
+        spill_old_chunks();
+    }
+    char* p = c->data + c->used;
+    memcpy(p, speaker, slen);          p[slen] = '\0';
+    memcpy(p + slen + 1, text, tlen);  p[slen + 1 + tlen] = '\0';
+    g_refs[g_ref_count].chunk = (uint32_t)(g_chunk_count - 1);
+    g_refs[g_ref_count].off   = c->used;
+    g_ref_count++;
+    c->used += (uint32_t)need;
+    return true;
+}
+
+void rpg_novel_backlog_push(const char* speaker, const char* text) {
+    if (!speaker) speaker = "";
+    if (!text)    text    = "";
+    if (!backlog_append(speaker, strlen(speaker), text, strlen(text)))
+        fprintf(stderr, "[eng_rpg] バックログ確保失敗\n");
+}
+
+void rpg_novel_backlog_clear(void) {
+    for (int i = 0; i < g_chunk_count; ++i) free(g_chunks[i].data);
+    free(g_chunks); g_chunks = NULL; g_chunk_count = g_chunk_cap = 0;
+    free(g_refs);   g_refs   = NULL; g_ref_count   = g_ref_cap   = 0;
+    cache_drop_all();
+    g_spill_next = 0;
+    if (g_spill) {
+        /* 退避ファイルは中身を捨てて使い続ける */
+        fclose(g_spill);
+        g_spill = fopen(g_spill_path, "w+b");
+    }
+}
+
+/* ── 参照 ───────────────────────────────────────────────*/
+int rpg_novel_backlog_count(void) { return g_ref_count; }
+
+/* 常駐しているバイト数 (退避済みチャンクは除く) */
+size_t rpg_novel_backlog_bytes(void) {
+    size_t n = sizeof(*g_chunks) * (size_t)g_chunk_cap + sizeof(*g_refs) * (size_t)g_ref_cap;
+    for (int i = 0; i < g_chunk_count; ++i)
+        if (g_chunks[i].data) n += g_chunks[i].cap;
+    for (int i = 0; i < BACKLOG_CACHE; ++i)
+        if (g_cache[i].data && g_cache[i].chunk >= 0) n += g_chunks[g_cache[i].chunk].used;
+    return n;
+}
+
+static bool backlog_entry(int i, unsigned pin_from, const char** speaker, const char** text) {
+    const char* base = chunk_data((int)g_refs[i].chunk, pin_from);
+    if (!base) return false;
+    *speaker = base + g_refs[i].off;
+    *text    = *speaker + strlen(*speaker) + 1;
+    return true;
+}
+
+bool rpg_novel_backlog_get(int i, const char** speaker, const char** text) {
+    if (i < 0 || i >= g_ref_count || !speaker || !text) return false;
+    return backlog_entry(i, 0, speaker, text);
+}
+
+const char* rpg_novel_backlog_speaker(int i) {
+    const char *s, *t;
+    return rpg_novel_backlog_get(i, &s, &t) ? s : "";
+}
+const char* rpg_novel_backlog_text(int i) {
+    const char *s, *t;
+    return rpg_novel_backlog_get(i, &s, &t) ? t : "";
+}
+
+int rpg_novel_backlog_range(int start, int n, RPG_BacklogLine* out) {
+    if (!out || n <= 0 || start < 0 || start >= g_ref_count) return 0;
+    if (n > g_ref_count - start) n = g_ref_count - start;
+    unsigned pin = g_cache_clock + 1;
+    int got = 0;
+    for (; got < n; ++got) {
+        if (!backlog_entry(start + got, pin, &out[got].speaker, &out[got].text)) break;
+    }
+    return got;
+}
+
+int rpg_novel_backlog_find(const char* needle, int from, int dir) {
+    if (!needle || !*needle || g_ref_count == 0) return -1;
+    int step = dir < 0 ? -1 : 1;
+    if (from < 0) from = step > 0 ? 0 : g_ref_count - 1;
+    for (int i = from; i >= 0 && i < g_ref_count; i += step) {
+        const char *s, *t;
+        if (!backlog_entry(i, 0, &s, &t)) return -1;
+        if (strstr(t, needle) || strstr(s, needle)) return i;
+    }
+    return -1;
+}
+
+/* ── セーブデータ ────────────────────────────────────────*/
+/* 形式: uint32 件数, 以降 [uint32 話者長][uint32 本文長][話者][本文] */
+bool rpg_novel_backlog_write(bool (*put)(void* ctx, const void* p, size_t n), void* ctx) {
+    uint32_t n = (uint32_t)g_ref_count;
+    if (!put(ctx, &n, sizeof(n))) return false;
+    for (int i = 0; i < g_ref_count; ++i) {
+        const char *s, *t;
+        if (!backlog_entry(i, 0, &s, &t)) return false;
+        uint32_t len[2] = { (uint32_t)strlen(s), (uint32_t)strlen(t) };
+        if (!put(ctx, len, sizeof(len)) ||
+            !put(ctx, s, len[0]) ||
+            !put(ctx, t, len[1])) return false;
+    }
+    return true;
+}
+
+bool rpg_novel_backlog_read(size_t (*get)(void* ctx, void* p, size_t n), void* ctx) {
+    uint32_t n;
+    if (get(ctx, &n, sizeof(n)) != sizeof(n)) return false;
+    rpg_novel_backlog_clear();
+    char*  buf = NULL;
+    size_t cap = 0;
+    bool   ok  = true;
+    for (uint32_t i = 0; i < n && ok; ++i) {
+        uint32_t len[2];
+        if (get(ctx, len, sizeof(len)) != sizeof(len)) { ok = false; break; }
+        size_t total = (size_t)len[0] + len[1];
+        if (total > cap) {
+            char* nb = realloc(buf, total ? total : 1);
+            if (!nb) { ok = false; break; }
+            buf = nb; cap = total;
+        }
+        if (get(ctx, buf, total) != total) { ok = false; break; }
+        ok = backlog_append(buf, len[0], buf + len[0], len[1]);
+    }
+    free(buf);
+    return ok;
+}
@@ -9,20 +9,31 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <limits.h>
 
 /* ── 乱数ヘルパー ────────────────────────────────────────*/
-static bool g_rand_init = false;
+/* rand() は libc ごとに系列が違うので splitmix64 (eng_table.c と同じ) を使う */
+static uint64_t g_rng = 0;   /* 0 = 未設定 */
+
+void rpg_battle_seed(uint64_t seed) { g_rng = seed ? seed : 1; }
+
 static int rpg_rand(int lo, int hi) {
-    if (!g_rand_init) { srand((unsigned)time(NULL)); g_rand_init = true; }
+    if (!g_rng) g_rng = (uint64_t)time(NULL) | 1;
     if (lo >= hi) return lo;
-    return lo + rand() % (hi - lo + 1);
+    uint64_t z = (g_rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return lo + (int)(z % (uint64_t)((int64_t)hi - lo + 1));
 }
+/* eng_formula.c から (rand / vary) */
+int rpg_battle_rand(int lo, int hi) { return rpg_rand(lo, hi); }
 
 /* ── ダメージ計算 ────────────────────────────────────────*/
 int rpg_calc_damage(int atk, int def) {
     int base = atk * 4 - def * 2;
     if (base < 1) base = 1;
-    int var = (int)(base * 0.1f);
+    int var = base / 10;
     return base + rpg_rand(-var, var);
 }
 
@@ -32,9 +43,10 @@ void rpg_gain_exp(int actor_id, int exp) {
     if (!a) return;
     a->exp += exp;
     while (a->exp >= a->next_exp) {
+        uint64_t tr = rpg_trace_begin();
         a->exp -= a->next_exp;
         a->level++;
-        a->next_exp = (int)(a->next_exp * 1.5f);
+        a->next_exp = a->next_exp <= INT_MAX / 3 * 2 ? a->next_exp + a->next_exp / 2 : INT_MAX;   /* ×1.5 */
         /* レベルアップでステータス上昇 */
         int gain_hp = 10 + rpg_rand(0, 10);
         int gain_mp = 5  + rpg_rand(0, 5);
@@ -46,6 +58,7 @@ void rpg_gain_exp(int actor_id, int exp) {
         a->def++;
         a->spd    += rpg_rand(0, 1);
         printf("[RPG] %s Lv.%d → Lv.%d!\n", a->name, a->level-1, a->level);
+        rpg_trace_end("rpg_gain_exp.levelup", tr);
     }
 }
 
@@ -73,6 +86,7 @@ void rpg_battle_do_action(RPG_Battle* b, int actor_id,
     RPG_Actor* actor = rpg_actor_get(actor_id);
     RPG_Actor* target = rpg_actor_get(target_id);
     if (!actor) return;
+    uint64_t tr = rpg_trace_begin();
 
     b->last_actor_id  = actor_id;
     b->last_target_id = target_id;
@@ -85,7 +99,7 @@ void rpg_battle_do_action(RPG_Battle* b, int actor_id,
             break;
         }
         {
-            int dmg = rpg_calc_damage(actor->atk, target->def);
+            int dmg = rpg_damage_compute(actor, target, 0);
             b->last_damage = dmg;
             target->hp -= dmg;
             if (target->hp <= 0) { target->hp = 0; target->alive = false; }
@@ -105,7 +119,7 @@ void rpg_battle_do_action(RPG_Battle* b, int actor_id,
             }
             actor->mp -= sk->mp_cost;
             if (target && target->alive) {
-                int dmg = rpg_calc_damage(actor->atk + sk->power, target->def);
+                int dmg = rpg_damage_compute(actor, target, param);
                 b->last_damage = dmg;
                 target->hp -= dmg;
                 if (target->hp <= 0) { target->hp = 0; target->alive = false; }
@@ -145,6 +159,7 @@ void rpg_battle_do_action(RPG_Battle* b, int actor_id,
     }
 
     rpg_battle_check(b);
+    rpg_trace_end("rpg_battle_do_action", tr);
 }
 
 /* ── 生存チェック ────────────────────────────────────────*/
@@ -152,11 +167,11 @@ RPG_BattleState rpg_battle_check(RPG_Battle* b) {
     if (!b || b->state != RPG_BATTLE_RUNNING) return b ? b->state : RPG_BATTLE_RUNNING;
     bool party_alive = false, enemy_alive = false;
     for (int i = 0; i < b->party_size; ++i) {
-        RPG_Actor* a = rpg_actor_get(b->party[i]);
+        const RPG_Actor* a = rpg_actor_peek(b->party[i]);
         if (a && a->alive) { party_alive = true; break; }
     }
     for (int i = 0; i < b->enemy_size; ++i) {
-        RPG_Actor* a = rpg_actor_get(b->enemy[i]);
+        const RPG_Actor* a = rpg_actor_peek(b->enemy[i]);
         if (a && a->alive) { enemy_alive = true; break; }
     }
     if (!party_alive) b->state = RPG_BATTLE_LOSE;
@@ -170,13 +185,13 @@ int rpg_battle_next_actor(RPG_Battle* b) {
     int best_id = 0, best_spd = -1;
     /* 全参加者から生存者最高速を選択 */
     for (int i = 0; i < b->party_size; ++i) {
-        RPG_Actor* a = rpg_actor_get(b->party[i]);
+        const RPG_Actor* a = rpg_actor_peek(b->party[i]);
         if (a && a->alive && a->spd > best_spd) {
             best_spd = a->spd; best_id = b->party[i];
         }
     }
     for (int i = 0; i < b->enemy_size; ++i) {
-        RPG_Actor* a = rpg_actor_get(b->enemy[i]);
+        const RPG_Actor* a = rpg_actor_peek(b->enemy[i]);
         if (a && a->alive && a->spd > best_spd) {
             best_spd = a->spd; best_id = b->enemy[i];
         }
@@ -190,20 +205,20 @@ int rpg_battle_next_actor(RPG_Battle* b) {
  * 戻り値: ダメージ量 (0=実行不可)。 */
 int rpg_battle_enemy_auto_action(RPG_Battle* b, int enemy_id) {
     if (!b || b->state != RPG_BATTLE_RUNNING) return 0;
-    RPG_Actor* attacker = rpg_actor_get(enemy_id);
+    const RPG_Actor* attacker = rpg_actor_peek(enemy_id);
     if (!attacker || !attacker->alive) return 0;
 
     /* 生存パーティメンバーを収集 */
     int alive_party[RPG_PARTY_MAX];
     int alive_count = 0;
     for (int i = 0; i < b->party_size; i++) {
-        RPG_Actor* a = rpg_actor_get(b->party[i]);
+        const RPG_Actor* a = rpg_actor_peek(b->party[i]);
         if (a && a->alive) alive_party[alive_count++] = b->party[i];
     }
     if (alive_count == 0) return 0;
 
     /* ランダムにターゲット選択 */
-    int target_id = alive_party[rand() % alive_count];
+    int target_id = alive_party[rpg_rand(0, alive_count - 1)];
     rpg_battle_do_action(b, enemy_id, RPG_ACT_ATTACK, target_id, 0);
     return b->last_damage;
 }
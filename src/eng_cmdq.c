@@ -0,0 +1,154 @@
+/**
+ * src/eng_cmdq.c — スレッド間のバトルコマンドキュー (ロックフリー)
+ *
+ * 入力側は複数の生産者 / 単一の消費者の有界リング。各セルが seq を持ち、
+ * 生産者は tail を CAS で進めて取ったセルに書き込んでから seq を公開する
+ * (Vyukov 方式)。消費者はバトルを持つスレッドだけなので head は普通に進める。
+ *
+ * 出力側 (結果) は単一生産者 / 単一消費者のリング。rpg_cmdq_drain が
+ * 1 コマンドを適用するたびに 1 件書き込む。結果リングが満杯なら
+ * そこで適用を止めるので、コマンドも結果も失われない。
+ *
+ * head と tail は別のキャッシュラインに置き、互いの書き込みで
+ * ラインを奪い合わないようにしている。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CMDQ_LINE 64
+
+typedef struct {
+    _Atomic size_t seq;
+    RPG_BattleCmd  cmd;
+} CmdCell;
+
+struct RPG_CmdQueue {
+    size_t   mask;
+    CmdCell* in;
+    RPG_BattleResult* out;
+
+    char           pad0[CMDQ_LINE];
+    _Atomic size_t in_tail;     /* 生産者が CAS で進める */
+    char           pad1[CMDQ_LINE - sizeof(size_t)];
+    size_t         in_head;     /* 消費者 (drain) のみ */
+    char           pad2[CMDQ_LINE - sizeof(size_t)];
+    _Atomic size_t out_tail;    /* drain のみ書く */
+    char           pad3[CMDQ_LINE - sizeof(size_t)];
+    _Atomic size_t out_head;    /* poll のみ書く */
+    char           pad4[CMDQ_LINE - sizeof(size_t)];
+    _Atomic uint64_t rejected;  /* 満杯で push できなかった回数 */
+};
+
+RPG_CmdQueue* rpg_cmdq_create(int capacity) {
+    if (capacity <= 0) capacity = RPG_CMDQ_DEFAULT;
+    size_t cap = 2;
+    while (cap < (size_t)capacity) cap <<= 1;
+    RPG_CmdQueue* q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->in  = malloc(sizeof(*q->in) * cap);
+    q->out = malloc(sizeof(*q->out) * cap);
+    if (!q->in || !q->out) { free(q->in); free(q->out); free(q); return NULL; }
+    q->mask = cap - 1;
+    for (size_t i = 0; i < cap; ++i) atomic_init(&q->in[i].seq, i);
+    atomic_init(&q->in_tail, 0);
+    atomic_init(&q->out_tail, 0);
+    atomic_init(&q->out_head, 0);
+    atomic_init(&q->rejected, 0);
+    return q;
+}
+
+void rpg_cmdq_destroy(RPG_CmdQueue* q) {
+    if (!q) return;
+    free(q->in);
+    free(q->out);
+    free(q);
+}
+
+int rpg_cmdq_capacity(const RPG_CmdQueue* q) { return q ? (int)(q->mask + 1) : 0; }
+
+/* ── 入力 (任意のスレッド) ──────────────────────────────*/
+bool rpg_cmdq_push(RPG_CmdQueue* q, const RPG_BattleCmd* cmd) {
+    if (!q || !cmd) return false;
+    size_t pos = atomic_load_explicit(&q->in_tail, memory_order_relaxed);
+    for (;;) {
+        CmdCell* c = &q->in[pos & q->mask];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->in_tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                c->cmd = *cmd;
+                atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+                return true;
+            }
+            /* 失敗時は pos が最新の tail に更新されている */
+        } else if (diff < 0) {
+            /* 1 周前のセルがまだ消費されていない = 満杯 */
+            atomic_fetch_add_explicit(&q->rejected, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->in_tail, memory_order_relaxed);
+        }
+    }
+}
+
+/* ── 適用 (バトルを持つスレッド) ────────────────────────*/
+int rpg_cmdq_drain(RPG_CmdQueue* q, RPG_Battle* b, int max) {
+    if (!q || !b) return 0;
+    if (max <= 0) max = (int)(q->mask + 1);
+    uint64_t tr = rpg_trace_begin();
+    size_t out_tail = atomic_load_explicit(&q->out_tail, memory_order_relaxed);
+    size_t out_head = atomic_load_explicit(&q->out_head, memory_order_acquire);
+    int done = 0;
+    while (done < max) {
+        if (out_tail - out_head > q->mask) {
+            out_head = atomic_load_explicit(&q->out_head, memory_order_acquire);
+            if (out_tail - out_head > q->mask) break;   /* 結果が読まれるまで待つ */
+        }
+        CmdCell* c = &q->in[q->in_head & q->mask];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        if (seq != q->in_head + 1) break;               /* 空 (または書き込み中) */
+        RPG_BattleCmd cmd = c->cmd;
+        atomic_store_explicit(&c->seq, q->in_head + q->mask + 1, memory_order_release);
+        q->in_head++;
+
+        RPG_BattleResult* r = &q->out[out_tail & q->mask];
+        r->tag       = cmd.tag;
+        r->actor_id  = cmd.actor_id;
+        r->target_id = cmd.target_id;
+        r->applied   = b->state == RPG_BATTLE_RUNNING && rpg_actor_peek(cmd.actor_id) != NULL;
+        if (r->applied) {
+            rpg_battle_do_action(b, cmd.actor_id, (RPG_ActionType)cmd.act, cmd.target_id, cmd.param);
+            rpg_battle_check(b);
+            r->damage = b->last_damage;
+            memcpy(r->msg, b->last_msg, sizeof(r->msg));
+        } else {
+            r->damage = 0;
+            r->msg[0] = '\0';
+        }
+        r->turn  = b->turn;
+        r->state = b->state;
+        atomic_store_explicit(&q->out_tail, ++out_tail, memory_order_release);
+        done++;
+    }
+    rpg_trace_end("rpg_cmdq_drain", tr);
+    return done;
+}
+
+/* ── 結果 (単一の読み手) ────────────────────────────────*/
+bool rpg_cmdq_poll(RPG_CmdQueue* q, RPG_BattleResult* out) {
+    if (!q || !out) return false;
+    size_t head = atomic_load_explicit(&q->out_head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&q->out_tail, memory_order_acquire)) return false;
+    *out = q->out[head & q->mask];
+    atomic_store_explicit(&q->out_head, head + 1, memory_order_release);
+    return true;
+}
+
+uint64_t rpg_cmdq_rejected(const RPG_CmdQueue* q) {
+    return q ? atomic_load_explicit(&((RPG_CmdQueue*)q)->rejected, memory_order_relaxed) : 0;
+}
@@ -7,8 +7,19 @@
 #include <string.h>
 #include <stdio.h>
 
+/* 二次索引の差分更新 (eng_index.c から) */
+void rpg_index_item_changed(int id);
+void rpg_index_skill_changed(int id);
+
+/* 差分の汚れ印 (eng_delta.c から) */
+void rpg_delta_touch(const void* p, size_t size);
+
+/* クエスト条件の入力 (eng_quest.c から) */
+void rpg_quest_item_changed(int item_id);
+
 /* ── グローバルデータベース ─────────────────────────────*/
 static RPG_Actor  g_actors[RPG_MAX_ACTORS + 1];  /* [0] 未使用, [1..MAX] */
+static RPG_Actor  g_actor_base[RPG_MAX_ACTORS + 1];  /* 登録/読み込み時の値 (セッションに無いアクターの戻し先) */
 static RPG_Item   g_items[RPG_MAX_ITEMS  + 1];
 static RPG_Skill  g_skills[RPG_MAX_SKILLS + 1];
 
@@ -18,16 +29,34 @@ static InvEntry g_inv[RPG_MAX_INVENTORY];
 /* ── アクター ────────────────────────────────────────────*/
 void rpg_actor_set(int id, const RPG_Actor* a) {
     if (id < 1 || id > RPG_MAX_ACTORS || !a) return;
+    uint64_t tr = rpg_trace_begin();
     g_actors[id] = *a;
+    /* 名前の終端以降と詰め物を 0 にそろえる (差分/状態ハッシュはバイト列で比べる) */
+    RPG_Actor* d = &g_actors[id];
+    const char* nul = memchr(d->name, '\0', sizeof(d->name));
+    size_t len = nul ? (size_t)(nul - d->name) : sizeof(d->name);
+    memset(d->name + len, 0, sizeof(d->name) - len);
+    memset((char*)d + offsetof(RPG_Actor, alive) + sizeof(d->alive), 0,
+           offsetof(RPG_Actor, status) - offsetof(RPG_Actor, alive) - sizeof(d->alive));
+    g_actor_base[id] = *d;
+    rpg_delta_touch(&g_actors[id], sizeof(g_actors[id]));
+    rpg_trace_end("rpg_actor_set", tr);
 }
 RPG_Actor* rpg_actor_get(int id) {
     if (id < 1 || id > RPG_MAX_ACTORS) return NULL;
+    /* 書き換え可能なポインタを渡すので汚れ扱い (実際に変わったかは確定時に比べる) */
+    rpg_delta_touch(&g_actors[id], sizeof(g_actors[id]));
     return &g_actors[id];
 }
+const RPG_Actor* rpg_actor_peek(int id) {
+    return (id >= 1 && id <= RPG_MAX_ACTORS) ? &g_actors[id] : NULL;
+}
 void rpg_actor_init(int id, const char* name,
                     int hp, int mp, int atk, int def, int spd) {
     if (id < 1 || id > RPG_MAX_ACTORS) return;
+    uint64_t tr = rpg_trace_begin();
     RPG_Actor* a = &g_actors[id];
+    rpg_delta_touch(a, sizeof(*a));
     memset(a, 0, sizeof(*a));
     strncpy(a->name, name, 63);
     a->hp = a->max_hp = hp;
@@ -35,12 +64,28 @@ void rpg_actor_init(int id, const char* name,
     a->atk = atk; a->def = def; a->spd = spd; a->luk = 10;
     a->level = 1; a->exp = 0; a->next_exp = 100;
     a->alive = true;
+    g_actor_base[id] = *a;
+    rpg_trace_end("rpg_actor_init", tr);
 }
+/* 登録時の値へ戻す。セッション展開で、そのセッションに無いアクター用 (eng_session.c から)。
+ * 戻し先が無い (名前が空) ときは消さずにそのままにする */
+void rpg_actor_reset_to_base(int id) {
+    if (id < 1 || id > RPG_MAX_ACTORS || !g_actors[id].name[0] || !g_actor_base[id].name[0]) return;
+    g_actors[id] = g_actor_base[id];
+    rpg_delta_touch(&g_actors[id], sizeof(g_actors[id]));
+}
+/* ロード/スナップショット復元/差分適用でアクターが丸ごと書き換わった。
+ * 読み込んだ値を戻し先にする (eng_save.c / eng_snapshot.c / eng_delta.c から) */
+void rpg_actor_base_sync(void) { memcpy(g_actor_base, g_actors, sizeof(g_actor_base)); }
+size_t rpg_actor_base_bytes(void) { return sizeof(g_actor_base); }
 
 /* ── アイテム ────────────────────────────────────────────*/
 void rpg_item_set(int id, const RPG_Item* it) {
     if (id < 1 || id > RPG_MAX_ITEMS || !it) return;
+    uint64_t tr = rpg_trace_begin();
     g_items[id] = *it; g_items[id].used = true;
+    rpg_index_item_changed(id);
+    rpg_trace_end("rpg_item_set", tr);
 }
 RPG_Item* rpg_item_get(int id) {
     if (id < 1 || id > RPG_MAX_ITEMS || !g_items[id].used) return NULL;
@@ -49,18 +94,24 @@ RPG_Item* rpg_item_get(int id) {
 void rpg_item_init(int id, const char* name, const char* desc,
                     int type, int effect, int price) {
     if (id < 1 || id > RPG_MAX_ITEMS) return;
+    uint64_t tr = rpg_trace_begin();
     RPG_Item* it = &g_items[id];
     memset(it, 0, sizeof(*it));
     strncpy(it->name, name, 63);
     strncpy(it->desc, desc, 127);
     it->type = type; it->effect = effect; it->price = price;
     it->used = true;
+    rpg_index_item_changed(id);
+    rpg_trace_end("rpg_item_init", tr);
 }
 
 /* ── スキル ─────────────────────────────────────────────*/
 void rpg_skill_set(int id, const RPG_Skill* sk) {
     if (id < 1 || id > RPG_MAX_SKILLS || !sk) return;
+    uint64_t tr = rpg_trace_begin();
     g_skills[id] = *sk; g_skills[id].used = true;
+    rpg_index_skill_changed(id);
+    rpg_trace_end("rpg_skill_set", tr);
 }
 RPG_Skill* rpg_skill_get(int id) {
     if (id < 1 || id > RPG_MAX_SKILLS || !g_skills[id].used) return NULL;
@@ -69,21 +120,35 @@ RPG_Skill* rpg_skill_get(int id) {
 void rpg_skill_init(int id, const char* name, const char* desc,
                      int mp_cost, int power, int target) {
     if (id < 1 || id > RPG_MAX_SKILLS) return;
+    uint64_t tr = rpg_trace_begin();
     RPG_Skill* sk = &g_skills[id];
     memset(sk, 0, sizeof(*sk));
     strncpy(sk->name, name, 63);
     strncpy(sk->desc, desc, 127);
     sk->mp_cost = mp_cost; sk->power = power; sk->target = target;
     sk->used = true;
+    rpg_index_skill_changed(id);
+    rpg_trace_end("rpg_skill_init", tr);
 }
 
 /* ── インベントリ ────────────────────────────────────────*/
 void rpg_inventory_add(int item_id, int count) {
     for (int i = 0; i < RPG_MAX_INVENTORY; ++i) {
-        if (g_inv[i].item_id == item_id) { g_inv[i].count += count; return; }
+        if (g_inv[i].item_id == item_id) {
+            g_inv[i].count += count;
+            rpg_delta_touch(&g_inv[i], sizeof(g_inv[i]));
+            rpg_quest_item_changed(item_id);
+            return;
+        }
     }
     for (int i = 0; i < RPG_MAX_INVENTORY; ++i) {
-        if (g_inv[i].item_id == 0) { g_inv[i].item_id = item_id; g_inv[i].count = count; return; }
+        if (g_inv[i].item_id == 0) {
+            g_inv[i].item_id = item_id;
+            g_inv[i].count   = count;
+            rpg_delta_touch(&g_inv[i], sizeof(g_inv[i]));
+            rpg_quest_item_changed(item_id);
+            return;
+        }
     }
     fprintf(stderr, "[eng_rpg] インベントリ満杯\n");
 }
@@ -92,6 +157,8 @@ void rpg_inventory_remove(int item_id, int count) {
         if (g_inv[i].item_id == item_id) {
             g_inv[i].count -= count;
             if (g_inv[i].count <= 0) { g_inv[i].item_id = 0; g_inv[i].count = 0; }
+            rpg_delta_touch(&g_inv[i], sizeof(g_inv[i]));
+            rpg_quest_item_changed(item_id);
             return;
         }
     }
@@ -103,6 +170,18 @@ int rpg_inventory_count(int item_id) {
 }
 bool rpg_inventory_has(int item_id) { return rpg_inventory_count(item_id) > 0; }
 
+/* スナップショット/セーブ対象の状態 (eng_snapshot.c / eng_save.c から) */
+void rpg_db_state_regions(void (*add)(const char* tag, void* p, size_t size)) {
+    add("ACTR", g_actors, sizeof(g_actors));
+    add("INVT", g_inv,    sizeof(g_inv));
+}
+
+void rpg_inventory_clear(void) {
+    memset(g_inv, 0, sizeof(g_inv));
+    rpg_delta_touch(g_inv, sizeof(g_inv));
+    rpg_quest_item_changed(0);
+}
+
 int rpg_inventory_list(int* out_item_ids, int* out_counts, int max) {
     if (!out_item_ids || !out_counts || max <= 0) return 0;
     int n = 0;
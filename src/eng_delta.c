@@ -0,0 +1,312 @@
+/**
+ * src/eng_delta.c — tick ごとの状態差分 (観戦/レプリケーション用)
+ *
+ * 対象はスナップショットと同じ状態領域 (アクター/インベントリ/ゴールド/
+ * 習得スキル/パーティ/フラグ/変数)。全領域を RPG_DELTA_BLOCK バイトの
+ * ブロックに通し番号で区切り、各モジュールの書き込み口 (rpg_actor_get,
+ * rpg_inventory_add, rpg_flag_set など) が rpg_delta_touch で
+ * ブロックに汚れ印を付ける。
+ *
+ * rpg_delta_commit は汚れたブロックだけを影 (直前の確定状態) と比べ、
+ * 実際に変わったブロックの集合を tick ごとの履歴に残して影を更新する。
+ * rpg_delta_encode(since) は since より後の履歴の和集合を影から書き出すので、
+ * 受信側が確認済みの tick さえ分かれば 1 つの影で何人にでも差分を送れる。
+ * 履歴より古い (または 0 の) since には全ブロックを送る。
+ *
+ * 形式: ヘッダー 16 バイト ('RDLT', from, to, レイアウトのハッシュ) に続けて
+ * [開始ブロック varint][ブロック数 varint][中身] の並び。
+ *
+ * 汚れ印は状態ハッシュ (eng_hash.c) にも渡す。どちらも追跡していない間は
+ * 分岐 1 つずつで戻る。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 対象の状態 (各モジュールから) */
+void rpg_db_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_extra_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_save_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_flag_state_restored(void);
+/* アクターの戻し先を読み込んだ値に合わせる (eng_db.c から) */
+void rpg_actor_base_sync(void);
+
+/* 状態ハッシュの汚れ印 (eng_hash.c から) */
+void rpg_hash_touch(const void* p, size_t size);
+void rpg_hash_touch_all(void);
+
+#define DELTA_MAGIC       0x544C4452u   /* "RDLT" */
+#define DELTA_HEADER      16
+#define DELTA_MAX_REGIONS 16
+
+typedef struct {
+    uint8_t* p;
+    size_t   size;
+    uint32_t first;    /* 先頭ブロックの通し番号 */
+    uint32_t shadow;   /* 影の中の先頭オフセット */
+} DeltaRegion;
+
+static DeltaRegion g_regions[DELTA_MAX_REGIONS];
+static int         g_region_count = 0;
+static uint32_t    g_blocks = 0;      /* ブロック総数 */
+static uint32_t    g_words = 0;       /* ビット集合 1 本の語数 */
+static uint32_t    g_layout = 0;      /* 領域名とサイズのハッシュ */
+
+static bool        g_on = false;
+static uint8_t*    g_shadow = NULL;
+static uint64_t*   g_dirty = NULL;
+static uint64_t*   g_hist = NULL;     /* [RPG_DELTA_HISTORY][g_words]: tick t で変わったブロック */
+static uint32_t    g_tick = 0;        /* 送信側: 確定済みの tick */
+static uint32_t    g_applied = 0;     /* 受信側: 適用済みの tick */
+
+/* ── 領域表 ─────────────────────────────────────────────*/
+static void add_region(const char* tag, void* p, size_t size) {
+    if (g_region_count >= DELTA_MAX_REGIONS) {
+        fprintf(stderr, "[eng_rpg] 差分の対象領域が多すぎる\n");
+        return;
+    }
+    DeltaRegion* r = &g_regions[g_region_count++];
+    r->p     = p;
+    r->size  = size;
+    r->first = g_blocks;
+    r->shadow = g_blocks * RPG_DELTA_BLOCK;
+    g_blocks += (uint32_t)((size + RPG_DELTA_BLOCK - 1) / RPG_DELTA_BLOCK);
+    for (const char* c = tag; *c; ++c) g_layout = (g_layout ^ (uint8_t)*c) * 16777619u;
+    g_layout = (g_layout ^ (uint32_t)size) * 16777619u;
+}
+
+static void build_regions(void) {
+    if (g_region_count) return;
+    g_layout = 2166136261u;
+    rpg_db_state_regions(add_region);
+    rpg_extra_state_regions(add_region);
+    rpg_save_state_regions(add_region);
+    g_words = (g_blocks + 63) / 64;
+}
+
+/* ブロック i の実体と長さ (領域の末尾ブロックは短い) */
+static const DeltaRegion* block_region(uint32_t i) {
+    int lo = 0, hi = g_region_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (g_regions[mid].first <= i) lo = mid; else hi = mid - 1;
+    }
+    return &g_regions[lo];
+}
+
+static size_t block_len(const DeltaRegion* r, uint32_t i) {
+    size_t off = (size_t)(i - r->first) * RPG_DELTA_BLOCK;
+    size_t n = r->size - off;
+    return n < RPG_DELTA_BLOCK ? n : RPG_DELTA_BLOCK;
+}
+
+/* ── 汚れ印 (各モジュールから) ──────────────────────────*/
+void rpg_delta_touch(const void* p, size_t size) {
+    rpg_hash_touch(p, size);
+    if (!g_on || size == 0) return;
+    const uint8_t* q = p;
+    for (int i = 0; i < g_region_count; ++i) {
+        const DeltaRegion* r = &g_regions[i];
+        if (q < r->p || q >= r->p + r->size) continue;
+        size_t off = (size_t)(q - r->p);
+        size_t end = off + size < r->size ? off + size : r->size;
+        uint32_t b0 = r->first + (uint32_t)(off / RPG_DELTA_BLOCK);
+        uint32_t b1 = r->first + (uint32_t)((end - 1) / RPG_DELTA_BLOCK);
+        for (uint32_t b = b0; b <= b1; ++b) g_dirty[b / 64] |= 1ULL << (b % 64);
+        return;
+    }
+}
+
+/* 一括で書き換えたとき (ロードなど) */
+void rpg_delta_touch_all(void) {
+    rpg_hash_touch_all();
+    if (!g_on) return;
+    memset(g_dirty, 0xFF, sizeof(uint64_t) * g_words);
+}
+
+/* ── 送信側 ─────────────────────────────────────────────*/
+bool rpg_delta_begin(void) {
+    build_regions();
+    if (g_on) return true;
+    g_shadow = malloc((size_t)g_blocks * RPG_DELTA_BLOCK);
+    g_dirty  = calloc(g_words, sizeof(uint64_t));
+    g_hist   = calloc((size_t)g_words * RPG_DELTA_HISTORY, sizeof(uint64_t));
+    if (!g_shadow || !g_dirty || !g_hist) {
+        free(g_shadow); free(g_dirty); free(g_hist);
+        g_shadow = NULL; g_dirty = NULL; g_hist = NULL;
+        return false;
+    }
+    for (int i = 0; i < g_region_count; ++i)
+        memcpy(g_shadow + g_regions[i].shadow, g_regions[i].p, g_regions[i].size);
+    g_tick = 1;
+    g_on = true;
+    return true;
+}
+
+void rpg_delta_end(void) {
+    g_on = false;
+    free(g_shadow); free(g_dirty); free(g_hist);
+    g_shadow = NULL; g_dirty = NULL; g_hist = NULL;
+    g_tick = 0;
+}
+
+uint32_t rpg_delta_tick(void) { return g_tick; }
+
+int rpg_delta_commit(void) {
+    if (!g_on) return -1;
+    uint64_t tr = rpg_trace_begin();
+    uint64_t* h = g_hist + (size_t)((g_tick + 1) % RPG_DELTA_HISTORY) * g_words;
+    memset(h, 0, sizeof(uint64_t) * g_words);
+    int changed = 0;
+    for (uint32_t w = 0; w < g_words; ++w) {
+        uint64_t bits = g_dirty[w];
+        g_dirty[w] = 0;
+        while (bits) {
+            uint32_t b = w * 64 + (uint32_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (b >= g_blocks) break;
+            const DeltaRegion* r = block_region(b);
+            size_t off = (size_t)(b - r->first) * RPG_DELTA_BLOCK;
+            size_t n = block_len(r, b);
+            uint8_t* s = g_shadow + r->shadow + off;
+            if (memcmp(s, r->p + off, n) == 0) continue;
+            memcpy(s, r->p + off, n);
+            h[w] |= 1ULL << (b % 64);
+            changed++;
+        }
+    }
+    g_tick++;
+    rpg_trace_end("rpg_delta_commit", tr);
+    return changed;
+}
+
+/* ── 符号化 ─────────────────────────────────────────────*/
+typedef struct {
+    uint8_t* p;
+    size_t   cap, len;
+} DeltaOut;
+
+static void out_bytes(DeltaOut* o, const void* p, size_t n) {
+    if (o->p && o->len + n <= o->cap) memcpy(o->p + o->len, p, n);
+    o->len += n;
+}
+static void out_u32(DeltaOut* o, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    out_bytes(o, b, 4);
+}
+static void out_varint(DeltaOut* o, uint32_t v) {
+    uint8_t b[5];
+    int n = 0;
+    do { b[n] = (uint8_t)(v & 0x7F); v >>= 7; if (v) b[n] |= 0x80; n++; } while (v);
+    out_bytes(o, b, (size_t)n);
+}
+
+static bool block_set(const uint64_t* set, uint32_t b) { return set[b / 64] >> (b % 64) & 1; }
+
+size_t rpg_delta_encode(uint32_t since, void* buf, size_t cap) {
+    if (!g_on) return 0;
+    uint64_t tr = rpg_trace_begin();
+    bool full = since == 0 || since > g_tick || g_tick - since >= RPG_DELTA_HISTORY;
+    uint64_t* set = calloc(g_words, sizeof(uint64_t));
+    if (!set) return 0;
+    if (full) {
+        memset(set, 0xFF, sizeof(uint64_t) * g_words);
+        since = 0;
+    } else {
+        for (uint32_t t = since + 1; t <= g_tick; ++t) {
+            const uint64_t* h = g_hist + (size_t)(t % RPG_DELTA_HISTORY) * g_words;
+            for (uint32_t w = 0; w < g_words; ++w) set[w] |= h[w];
+        }
+    }
+
+    DeltaOut o = { buf, cap, 0 };
+    out_u32(&o, DELTA_MAGIC);
+    out_u32(&o, since);
+    out_u32(&o, g_tick);
+    out_u32(&o, g_layout);
+    for (uint32_t b = 0; b < g_blocks; ) {
+        if (!block_set(set, b)) { ++b; continue; }
+        uint32_t e = b;
+        while (e < g_blocks && block_set(set, e)) ++e;
+        out_varint(&o, b);
+        out_varint(&o, e - b);
+        for (uint32_t i = b; i < e; ++i) {
+            const DeltaRegion* r = block_region(i);
+            out_bytes(&o, g_shadow + r->shadow + (size_t)(i - r->first) * RPG_DELTA_BLOCK,
+                      block_len(r, i));
+        }
+        b = e;
+    }
+    free(set);
+    rpg_trace_end("rpg_delta_encode", tr);
+    if (buf && o.len > cap) return 0;
+    return o.len;
+}
+
+/* ── 受信側 ─────────────────────────────────────────────*/
+static uint32_t in_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+static bool in_varint(const uint8_t** p, const uint8_t* end, uint32_t* v) {
+    uint32_t x = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*p >= end) return false;
+        uint8_t b = *(*p)++;
+        x |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) { *v = x; return true; }
+    }
+    return false;
+}
+
+/* 先に全体を検証してから書き込むので、壊れた差分で状態が半端に変わることはない */
+static bool walk(const uint8_t* p, const uint8_t* end, bool write) {
+    while (p < end) {
+        uint32_t b, n;
+        if (!in_varint(&p, end, &b) || !in_varint(&p, end, &n)) return false;
+        if (b >= g_blocks || n > g_blocks - b) return false;
+        for (uint32_t i = b; i < b + n; ++i) {
+            const DeltaRegion* r = block_region(i);
+            size_t len = block_len(r, i);
+            if ((size_t)(end - p) < len) return false;
+            if (write) {
+                uint8_t* dst = r->p + (size_t)(i - r->first) * RPG_DELTA_BLOCK;
+                memcpy(dst, p, len);
+                rpg_delta_touch(dst, len);
+            }
+            p += len;
+        }
+    }
+    return true;
+}
+
+bool rpg_delta_apply(const void* buf, size_t len) {
+    const uint8_t* p = buf;
+    if (!p || len < DELTA_HEADER || in_u32(p) != DELTA_MAGIC) return false;
+    build_regions();
+    uint32_t from = in_u32(p + 4), to = in_u32(p + 8);
+    if (in_u32(p + 12) != g_layout) {
+        fprintf(stderr, "[eng_rpg] 差分のレイアウトが一致しない\n");
+        return false;
+    }
+    /* 間の tick が抜けている / 既に適用済みより古い (全体の差分は常に受け付ける) */
+    if (from != 0 && (from > g_applied || to < g_applied)) return false;
+    if (!walk(p + DELTA_HEADER, p + len, false)) return false;
+    uint64_t tr = rpg_trace_begin();
+    walk(p + DELTA_HEADER, p + len, true);
+    g_applied = to;
+    rpg_actor_base_sync();
+    rpg_flag_state_restored();
+    rpg_trace_end("rpg_delta_apply", tr);
+    return true;
+}
+
+uint32_t rpg_delta_applied_tick(void) { return g_applied; }
+
+size_t rpg_delta_bytes(void) {
+    if (!g_on) return 0;
+    return (size_t)g_blocks * RPG_DELTA_BLOCK
+         + sizeof(uint64_t) * g_words * (RPG_DELTA_HISTORY + 1);
+}
@@ -1,33 +1,189 @@
 /**
  * src/eng_dialog.c — ダイアログ/メッセージキューシステム
  *
+ * 本文と話者名はチャンク単位の文字列アリーナに詰めて格納し、
+ * キューには固定長のヘッダーだけを並べる。メッセージは FIFO で
+ * 消費されるため、チャンクも先頭から順に丸ごと回収できる。
+ *
  * Copyright (c) 2026 Reo Shiozawa — MIT License
  */
 #include "eng_rpg.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+struct RPG_DialogChunk {
+    RPG_DialogChunk* next;
+    size_t cap, used;
+    int    refs;     /* このチャンクを参照している未消費メッセージ数 */
+    char   data[];
+};
+
+#define DIALOG_FREE_KEEP 2   /* 再利用のため手元に残す空きチャンク数 */
+
+/* ── チャンク管理 ────────────────────────────────────────*/
+static RPG_DialogChunk* chunk_new(RPG_Dialog* d, size_t need) {
+    RPG_DialogChunk* c = NULL;
+    if (need <= RPG_DIALOG_CHUNK && d->chunk_free) {
+        c = d->chunk_free;
+        d->chunk_free = c->next;
+    } else {
+        size_t cap = need > RPG_DIALOG_CHUNK ? need : RPG_DIALOG_CHUNK;
+        c = malloc(sizeof(*c) + cap);
+        if (!c) return NULL;
+        c->cap = cap;
+    }
+    c->next = NULL; c->used = 0; c->refs = 0;
+    if (d->chunk_tail) d->chunk_tail->next = c;
+    else               d->chunk_head = c;
+    d->chunk_tail = c;
+    return c;
+}
+
+static void chunk_release(RPG_Dialog* d, RPG_DialogChunk* c) {
+    int kept = 0;
+    for (RPG_DialogChunk* f = d->chunk_free; f; f = f->next) kept++;
+    if (c->cap == RPG_DIALOG_CHUNK && kept < DIALOG_FREE_KEEP) {
+        c->next = d->chunk_free;
+        d->chunk_free = c;
+    } else {
+        free(c);
+    }
+}
+
+/* 参照が無くなった先頭チャンクをまとめて回収する */
+static void chunk_reclaim(RPG_Dialog* d) {
+    while (d->chunk_head && d->chunk_head->refs == 0) {
+        RPG_DialogChunk* c = d->chunk_head;
+        if (c == d->chunk_tail) { c->used = 0; return; }  /* 書き込み中は巻き戻すだけ */
+        d->chunk_head = c->next;
+        chunk_release(d, c);
+    }
+}
+
+/* ── ヘッダーリング ──────────────────────────────────────*/
+static bool queue_grow(RPG_Dialog* d) {
+    int cap = d->cap ? d->cap * 2 : RPG_MSG_QUEUE;
+    RPG_DialogMsg* q = malloc(sizeof(*q) * (size_t)cap);
+    if (!q) return false;
+    /* リングを先頭から詰め直す */
+    for (int i = 0; i < d->count; ++i)
+        q[i] = d->queue[(d->head + i) % d->cap];
+    free(d->queue);
+    d->queue = q;
+    d->cap   = cap;
+    d->head  = 0;
+    d->tail  = d->count;
+    return true;
+}
+
+/* ── 公開 API ───────────────────────────────────────────*/
 void rpg_dialog_init(RPG_Dialog* d) {
     if (!d) return;
     memset(d, 0, sizeof(*d));
 }
 
-void rpg_dialog_push(RPG_Dialog* d, const char* text, const char* speaker) {
-    if (!d || !text) return;
-    if (d->count >= RPG_MSG_QUEUE) {
-        fprintf(stderr, "[eng_rpg] ダイアログキュー満杯\n");
-        return;
+void rpg_dialog_clear(RPG_Dialog* d) {
+    if (!d) return;
+    while (d->chunk_head) {
+        RPG_DialogChunk* c = d->chunk_head;
+        d->chunk_head = c->next;
+        chunk_release(d, c);
+    }
+    d->chunk_tail = NULL;
+    d->head = d->tail = d->count = 0;
+}
+
+void rpg_dialog_free(RPG_Dialog* d) {
+    if (!d) return;
+    rpg_dialog_clear(d);
+    while (d->chunk_free) {
+        RPG_DialogChunk* c = d->chunk_free;
+        d->chunk_free = c->next;
+        free(c);
+    }
+    free(d->queue);
+    memset(d, 0, sizeof(*d));
+}
+
+/* text/speaker は長さ指定 (NUL 終端でなくてよい) */
+static bool dialog_push_n(RPG_Dialog* d, const char* text, size_t tlen,
+                          const char* speaker, size_t slen) {
+    if (d->count >= d->cap && !queue_grow(d)) {
+        fprintf(stderr, "[eng_rpg] ダイアログキュー確保失敗\n");
+        return false;
+    }
+    size_t need = tlen + 1 + slen + 1;
+    RPG_DialogChunk* c = d->chunk_tail;
+    if (!c || c->cap - c->used < need) c = chunk_new(d, need);
+    if (!c) {
+        fprintf(stderr, "[eng_rpg] ダイアログ文字列確保失敗\n");
+        return false;
     }
+    char* t = c->data + c->used;
+    memcpy(t, text, tlen);        t[tlen] = '\0';
+    char* s = t + tlen + 1;
+    if (slen) memcpy(s, speaker, slen);
+    s[slen] = '\0';
+    c->used += need;
+    c->refs++;
+
     RPG_DialogMsg* m = &d->queue[d->tail];
     memset(m, 0, sizeof(*m));
-    strncpy(m->text, text, RPG_MSG_MAX_LEN - 1);
-    if (speaker) strncpy(m->speaker, speaker, 63);
-    m->total_chars  = (int)strlen(m->text);
+    m->text          = t;
+    m->speaker       = s;
+    m->chunk         = c;
+    m->total_chars   = (int)tlen;
     m->char_interval = 0.03f;
-    m->char_pos      = 0;
-    m->finished      = false;
-    d->tail = (d->tail + 1) % RPG_MSG_QUEUE;
+    d->tail = (d->tail + 1) % d->cap;
     d->count++;
+    return true;
+}
+
+void rpg_dialog_push(RPG_Dialog* d, const char* text, const char* speaker) {
+    if (!d || !text) return;
+    dialog_push_n(d, text, strlen(text), speaker ? speaker : "", speaker ? strlen(speaker) : 0);
+}
+
+int rpg_dialog_push_batch(RPG_Dialog* d, const char* const* texts,
+                          const char* const* speakers, int n) {
+    if (!d || !texts || n <= 0) return 0;
+    /* ヘッダーは一度に必要分まで広げておく */
+    while (d->cap - d->count < n)
+        if (!queue_grow(d)) break;
+    int pushed = 0;
+    for (int i = 0; i < n; ++i) {
+        if (!texts[i]) continue;
+        const char* sp = speakers && speakers[i] ? speakers[i] : "";
+        if (!dialog_push_n(d, texts[i], strlen(texts[i]), sp, strlen(sp))) break;
+        pushed++;
+    }
+    return pushed;
+}
+
+int rpg_dialog_push_lines(RPG_Dialog* d, const char* block, const char* default_speaker) {
+    if (!d || !block) return 0;
+    const char* dsp  = default_speaker ? default_speaker : "";
+    size_t      dlen = strlen(dsp);
+    int pushed = 0;
+    const char* p = block;
+    while (*p) {
+        const char* eol = strchr(p, '\n');
+        size_t len = eol ? (size_t)(eol - p) : strlen(p);
+        size_t tl  = len;
+        if (tl > 0 && p[tl - 1] == '\r') tl--;
+        if (tl > 0) {
+            const char* tab = memchr(p, '\t', tl);
+            bool ok = tab
+                ? dialog_push_n(d, tab + 1, tl - (size_t)(tab - p) - 1, p, (size_t)(tab - p))
+                : dialog_push_n(d, p, tl, dsp, dlen);
+            if (!ok) break;
+            pushed++;
+        }
+        if (!eol) break;
+        p = eol + 1;
+    }
+    return pushed;
 }
 
 void rpg_dialog_set_speed(RPG_Dialog* d, float secs_per_char) {
@@ -35,7 +191,7 @@ void rpg_dialog_set_speed(RPG_Dialog* d, float secs_per_char) {
     d->queue[d->head].char_interval = secs_per_char;
 }
 
-void rpg_dialog_update(RPG_Dialog* d, float dt) {
+static void dialog_advance(RPG_Dialog* d, float dt) {
     if (!d || d->count == 0) return;
     RPG_DialogMsg* m = &d->queue[d->head];
     if (m->finished) return;
@@ -51,6 +207,12 @@ void rpg_dialog_update(RPG_Dialog* d, float dt) {
     }
 }
 
+void rpg_dialog_update(RPG_Dialog* d, float dt) {
+    uint64_t tr = rpg_trace_begin();
+    dialog_advance(d, dt);
+    rpg_trace_end("rpg_dialog_update", tr);
+}
+
 void rpg_dialog_next(RPG_Dialog* d) {
     if (!d || d->count == 0) return;
     RPG_DialogMsg* m = &d->queue[d->head];
@@ -61,8 +223,10 @@ void rpg_dialog_next(RPG_Dialog* d) {
         return;
     }
     /* 次のメッセージへ */
-    d->head = (d->head + 1) % RPG_MSG_QUEUE;
+    m->chunk->refs--;
+    d->head = (d->head + 1) % d->cap;
     d->count--;
+    chunk_reclaim(d);
 }
 
 const RPG_DialogMsg* rpg_dialog_current(const RPG_Dialog* d) {
@@ -6,42 +6,185 @@
 #include "eng_rpg.h"
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
+
+/* 差分の汚れ印 (eng_delta.c から) */
+void rpg_delta_touch(const void* p, size_t size);
+
+/* クエスト条件の入力 (eng_quest.c から) */
+void rpg_quest_party_changed(int actor_id);
 
 /* ======================== ゴールド ======================== */
 
 static int g_gold = 0;
 
 int rpg_gold_get(void)          { return g_gold; }
-void rpg_gold_set(int amount)   { g_gold = amount < 0 ? 0 : amount; }
-void rpg_gold_add(int amount)   { g_gold += amount; if (g_gold < 0) g_gold = 0; }
+void rpg_gold_set(int amount) {
+    g_gold = amount < 0 ? 0 : amount;
+    rpg_delta_touch(&g_gold, sizeof(g_gold));
+}
+void rpg_gold_add(int amount) {
+    int64_t g = (int64_t)g_gold + amount;
+    g_gold = g < 0 ? 0 : g > INT_MAX ? INT_MAX : (int)g;
+    rpg_delta_touch(&g_gold, sizeof(g_gold));
+}
 bool rpg_gold_spend(int amount) {
     if (amount < 0 || g_gold < amount) return false;
     g_gold -= amount;
+    rpg_delta_touch(&g_gold, sizeof(g_gold));
     return true;
 }
 
+#if RPG_WITH_SHOP
 /* ======================== ショップ ======================== */
 
+/* 単品の売買も取引として検証してから適用する
+ * (満杯で入らないのにゴールドだけ減る、価格×個数の桁あふれ、を防ぐ) */
 bool rpg_shop_buy(int item_id, int count) {
-    if (count <= 0) return false;
-    RPG_Item* it = rpg_item_get(item_id);
-    if (!it) return false;
-    int total = it->price * count;
-    if (!rpg_gold_spend(total)) return false;
-    rpg_inventory_add(item_id, count);
-    return true;
+    RPG_Txn t;
+    rpg_txn_begin(&t);
+    return rpg_txn_buy(&t, item_id, count) && rpg_txn_commit(&t) == RPG_TXN_OK;
 }
 
+/* 未登録アイテムは従来どおり 0 ゴールドで手放せる (取引の売却は未登録を拒否する) */
 bool rpg_shop_sell(int item_id, int count) {
-    if (count <= 0) return false;
-    if (rpg_inventory_count(item_id) < count) return false;
-    RPG_Item* it = rpg_item_get(item_id);
-    int gain = it ? (it->price / 2) * count : 0;
-    rpg_inventory_remove(item_id, count);
-    rpg_gold_add(gain);
+    RPG_Txn t;
+    rpg_txn_begin(&t);
+    bool ok = rpg_item_get(item_id) ? rpg_txn_sell(&t, item_id, count)
+                                    : rpg_txn_item_remove(&t, item_id, count);
+    return ok && rpg_txn_commit(&t) == RPG_TXN_OK;
+}
+
+/* ======================== 取引 ======================== */
+
+void rpg_txn_begin(RPG_Txn* t) {
+    if (!t) return;
+    t->count       = 0;
+    t->error       = RPG_TXN_OK;
+    t->error_index = -1;
+}
+
+void rpg_txn_rollback(RPG_Txn* t) { rpg_txn_begin(t); }
+
+static bool txn_push(RPG_Txn* t, RPG_TxnOpType type, int item_id, int count, int64_t amount) {
+    if (!t) return false;
+    if (t->count >= RPG_TXN_MAX_OPS) {
+        t->error = RPG_TXN_ERR_TOO_MANY; t->error_index = t->count;
+        return false;
+    }
+    if (type != RPG_TXN_GOLD && (count <= 0 || item_id <= 0)) {
+        t->error = RPG_TXN_ERR_ARG; t->error_index = t->count;
+        return false;
+    }
+    RPG_TxnOp* op = &t->ops[t->count++];
+    op->type = type; op->item_id = item_id; op->count = count; op->amount = amount;
     return true;
 }
 
+bool rpg_txn_buy(RPG_Txn* t, int item_id, int count)         { return txn_push(t, RPG_TXN_BUY, item_id, count, 0); }
+bool rpg_txn_sell(RPG_Txn* t, int item_id, int count)        { return txn_push(t, RPG_TXN_SELL, item_id, count, 0); }
+bool rpg_txn_gold(RPG_Txn* t, int64_t amount)                { return txn_push(t, RPG_TXN_GOLD, 0, 0, amount); }
+bool rpg_txn_item_add(RPG_Txn* t, int item_id, int count)    { return txn_push(t, RPG_TXN_ITEM_ADD, item_id, count, 0); }
+bool rpg_txn_item_remove(RPG_Txn* t, int item_id, int count) { return txn_push(t, RPG_TXN_ITEM_REMOVE, item_id, count, 0); }
+
+/* 操作のゴールド増減。価格は int、個数は int なので積は int64 に収まる。 */
+static int64_t txn_op_gold(const RPG_TxnOp* op) {
+    RPG_Item* it;
+    switch (op->type) {
+    case RPG_TXN_BUY:  it = rpg_item_get(op->item_id); return it ? -(int64_t)it->price * op->count : 0;
+    case RPG_TXN_SELL: it = rpg_item_get(op->item_id); return it ? (int64_t)(it->price / 2) * op->count : 0;
+    case RPG_TXN_GOLD: return op->amount;
+    default:           return 0;
+    }
+}
+
+int64_t rpg_txn_gold_delta(const RPG_Txn* t) {
+    int64_t sum = 0;
+    for (int i = 0; t && i < t->count; ++i) sum += txn_op_gold(&t->ops[i]);
+    return sum;
+}
+
+/* 検証用の在庫表: 取引で触れるアイテムだけを現在数から追跡する */
+typedef struct { int item_id; int64_t have; int64_t orig; } TxnStock;
+
+static TxnStock* txn_stock(TxnStock* st, int* n, int item_id) {
+    for (int i = 0; i < *n; ++i) if (st[i].item_id == item_id) return &st[i];
+    TxnStock* s = &st[(*n)++];
+    s->item_id = item_id;
+    s->have = s->orig = rpg_inventory_count(item_id);
+    return s;
+}
+
+/* 検証本体。成功時は stock/n_stock/gold に最終状態を返す。 */
+static RPG_TxnResult txn_check(RPG_Txn* t, TxnStock* stock, int* n_stock, int64_t* gold) {
+    *n_stock = 0;
+    *gold = rpg_gold_get();
+    t->error_index = -1;
+    for (int i = 0; i < t->count; ++i) {
+        const RPG_TxnOp* op = &t->ops[i];
+        RPG_TxnResult r = RPG_TXN_OK;
+        if ((op->type == RPG_TXN_BUY || op->type == RPG_TXN_SELL) && !rpg_item_get(op->item_id))
+            r = RPG_TXN_ERR_NO_ITEM;
+        if (r == RPG_TXN_OK) {
+            int64_t g = *gold + txn_op_gold(op);
+            if (g < 0)       r = RPG_TXN_ERR_GOLD;
+            else if (g > INT_MAX) r = RPG_TXN_ERR_OVERFLOW;
+            else *gold = g;
+        }
+        if (r == RPG_TXN_OK && op->type != RPG_TXN_GOLD) {
+            TxnStock* s = txn_stock(stock, n_stock, op->item_id);
+            bool add = op->type == RPG_TXN_BUY || op->type == RPG_TXN_ITEM_ADD;
+            int64_t h = s->have + (add ? op->count : -(int64_t)op->count);
+            if (h < 0)            r = RPG_TXN_ERR_STOCK;
+            else if (h > INT_MAX) r = RPG_TXN_ERR_OVERFLOW;
+            else s->have = h;
+        }
+        if (r != RPG_TXN_OK) {
+            t->error = r; t->error_index = i;
+            return r;
+        }
+    }
+    /* 最終状態でのスロット数 */
+    int ids[RPG_MAX_INVENTORY], cnts[RPG_MAX_INVENTORY];
+    int used = rpg_inventory_list(ids, cnts, RPG_MAX_INVENTORY);
+    for (int i = 0; i < *n_stock; ++i) {
+        if (stock[i].orig == 0 && stock[i].have > 0) used++;
+        if (stock[i].orig > 0 && stock[i].have == 0) used--;
+    }
+    if (used > RPG_MAX_INVENTORY) {
+        t->error = RPG_TXN_ERR_CAPACITY;
+        return t->error;
+    }
+    t->error = RPG_TXN_OK;
+    return RPG_TXN_OK;
+}
+
+RPG_TxnResult rpg_txn_validate(RPG_Txn* t) {
+    if (!t) return RPG_TXN_ERR_ARG;
+    TxnStock stock[RPG_TXN_MAX_OPS];
+    int n; int64_t gold;
+    return txn_check(t, stock, &n, &gold);
+}
+
+RPG_TxnResult rpg_txn_commit(RPG_Txn* t) {
+    if (!t) return RPG_TXN_ERR_ARG;
+    TxnStock stock[RPG_TXN_MAX_OPS];
+    int n; int64_t gold;
+    RPG_TxnResult r = txn_check(t, stock, &n, &gold);
+    if (r != RPG_TXN_OK) return r;
+    /* 差分だけを適用。空きスロットを先に作るため減少分から */
+    for (int i = 0; i < n; ++i)
+        if (stock[i].have < stock[i].orig)
+            rpg_inventory_remove(stock[i].item_id, (int)(stock[i].orig - stock[i].have));
+    for (int i = 0; i < n; ++i)
+        if (stock[i].have > stock[i].orig)
+            rpg_inventory_add(stock[i].item_id, (int)(stock[i].have - stock[i].orig));
+    rpg_gold_set((int)gold);
+    t->count = 0;
+    return RPG_TXN_OK;
+}
+#endif /* RPG_WITH_SHOP */
+
 /* ======================== 状態異常 ======================== */
 
 void rpg_actor_set_status(int id, uint32_t flags) {
@@ -50,12 +193,12 @@ void rpg_actor_set_status(int id, uint32_t flags) {
 }
 
 uint32_t rpg_actor_get_status(int id) {
-    RPG_Actor* a = rpg_actor_get(id);
+    const RPG_Actor* a = rpg_actor_peek(id);
     return a ? a->status : RPG_STATUS_NONE;
 }
 
 bool rpg_actor_has_status(int id, RPG_Status s) {
-    RPG_Actor* a = rpg_actor_get(id);
+    const RPG_Actor* a = rpg_actor_peek(id);
     return a ? (a->status & (uint32_t)s) != 0 : false;
 }
 
@@ -141,7 +284,7 @@ void rpg_equip_set(int actor_id, RPG_EquipSlot slot, int item_id) {
 }
 
 int rpg_equip_get(int actor_id, RPG_EquipSlot slot) {
-    RPG_Actor* a = rpg_actor_get(actor_id);
+    const RPG_Actor* a = rpg_actor_peek(actor_id);
     if (!a || slot < 0 || slot >= 4) return 0;
     return a->equip[(int)slot];
 }
@@ -178,11 +321,13 @@ static uint64_t g_actor_skills[RPG_MAX_ACTORS + 1]; /* [0] 未使用 */
 void rpg_actor_learn_skill(int actor_id, int skill_id) {
     if (actor_id < 1 || actor_id > RPG_MAX_ACTORS || skill_id < 0) return;
     g_actor_skills[actor_id] |= (1ULL << (skill_id % 64));
+    rpg_delta_touch(&g_actor_skills[actor_id], sizeof(uint64_t));
 }
 
 void rpg_actor_forget_skill(int actor_id, int skill_id) {
     if (actor_id < 1 || actor_id > RPG_MAX_ACTORS || skill_id < 0) return;
     g_actor_skills[actor_id] &= ~(1ULL << (skill_id % 64));
+    rpg_delta_touch(&g_actor_skills[actor_id], sizeof(uint64_t));
 }
 
 bool rpg_actor_has_skill(int actor_id, int skill_id) {
@@ -210,17 +355,24 @@ void rpg_actor_heal_mp(int actor_id, int amount) {
 /* ======================== パーティ ======================== */
 
 /* RPG_PARTY_MAX はヘッダーで =4 (Battle最大数) → パーティ管理は独自に8まで */
-#define PARTY_MGR_MAX 8
+#define PARTY_MGR_MAX RPG_PARTY_MGR_MAX
 static int  g_party[PARTY_MGR_MAX];
 static int  g_party_size = 0;
 
-void rpg_party_clear(void) { g_party_size = 0; }
+void rpg_party_clear(void) {
+    g_party_size = 0;
+    rpg_delta_touch(&g_party_size, sizeof(g_party_size));
+    rpg_quest_party_changed(0);
+}
 
 bool rpg_party_add(int actor_id) {
     if (g_party_size >= PARTY_MGR_MAX) return false;
     for (int i = 0; i < g_party_size; i++)
         if (g_party[i] == actor_id) return false; /* 重複防止 */
     g_party[g_party_size++] = actor_id;
+    rpg_delta_touch(g_party, sizeof(g_party));
+    rpg_delta_touch(&g_party_size, sizeof(g_party_size));
+    rpg_quest_party_changed(actor_id);
     return true;
 }
 
@@ -230,6 +382,9 @@ bool rpg_party_remove(int actor_id) {
             for (int j = i; j < g_party_size - 1; j++)
                 g_party[j] = g_party[j + 1];
             g_party_size--;
+            rpg_delta_touch(g_party, sizeof(g_party));
+            rpg_delta_touch(&g_party_size, sizeof(g_party_size));
+            rpg_quest_party_changed(actor_id);
             return true;
         }
     }
@@ -286,10 +441,10 @@ bool rpg_item_use(int actor_id, int item_id) {
     return true;
 }
 
+#if RPG_WITH_NOVEL
 /* ======================== ビジュアルノベルシステム ======================== */
 
 #define NOVEL_CHAR_SLOTS 3
-#define NOVEL_BACKLOG_MAX 16
 
 static char g_novel_bg[256];
 static char g_novel_char_path[NOVEL_CHAR_SLOTS][256];
@@ -298,12 +453,6 @@ static bool g_novel_auto      = false;
 static bool g_novel_skip      = false;
 static float g_novel_auto_delay = 2.0f;
 
-/* バックログ (リングバッファ) */
-typedef struct { char speaker[64]; char text[256]; } BacklogEntry;
-static BacklogEntry g_backlog[NOVEL_BACKLOG_MAX];
-static int g_backlog_count = 0;
-static int g_backlog_head  = 0;  /* 次書き込み位置 */
-
 void rpg_novel_set_bg(const char* path) {
     if (path) snprintf(g_novel_bg, sizeof(g_novel_bg), "%s", path);
     else g_novel_bg[0] = '\0';
@@ -335,29 +484,13 @@ void rpg_novel_set_skip(bool on)          { g_novel_skip = on; }
 bool rpg_novel_get_skip(void)             { return g_novel_skip; }
 void rpg_novel_set_auto_delay(float sec)  { g_novel_auto_delay = sec; }
 float rpg_novel_get_auto_delay(void)      { return g_novel_auto_delay; }
-
-/* バックログ */
-void rpg_novel_backlog_push(const char* speaker, const char* text) {
-    BacklogEntry* e = &g_backlog[g_backlog_head];
-    snprintf(e->speaker, 64,  "%s", speaker ? speaker : "");
-    snprintf(e->text,    256, "%s", text    ? text    : "");
-    g_backlog_head = (g_backlog_head + 1) % NOVEL_BACKLOG_MAX;
-    if (g_backlog_count < NOVEL_BACKLOG_MAX) g_backlog_count++;
-}
-
-int rpg_novel_backlog_count(void) { return g_backlog_count; }
-
-static int backlog_index(int i) {
-    /* i=0 が最新。リングバッファの古い順を逆引き */
-    int start = (g_backlog_head - g_backlog_count + NOVEL_BACKLOG_MAX) % NOVEL_BACKLOG_MAX;
-    return (start + i) % NOVEL_BACKLOG_MAX;
-}
-
-const char* rpg_novel_backlog_speaker(int i) {
-    if (i < 0 || i >= g_backlog_count) return "";
-    return g_backlog[backlog_index(i)].speaker;
-}
-const char* rpg_novel_backlog_text(int i) {
-    if (i < 0 || i >= g_backlog_count) return "";
-    return g_backlog[backlog_index(i)].text;
+#endif /* RPG_WITH_NOVEL */
+
+/* ======================== スナップショット ======================== */
+/* スナップショット/セーブ対象の状態 (eng_snapshot.c / eng_save.c から) */
+void rpg_extra_state_regions(void (*add)(const char* tag, void* p, size_t size)) {
+    add("GOLD", &g_gold,        sizeof(g_gold));
+    add("SKIL", g_actor_skills, sizeof(g_actor_skills));
+    add("PRTY", g_party,        sizeof(g_party));
+    add("PRTN", &g_party_size,  sizeof(g_party_size));
 }
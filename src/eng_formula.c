@@ -0,0 +1,671 @@
+/**
+ * src/eng_formula.c — ダメージ計算式の小さな言語
+ *
+ * 式の文字列を一度だけ構文解析し、定数畳み込みをしてから
+ * レジスタ型のバイトコードに落とす。評価は命令列を一回なめるだけ。
+ *
+ *   値    : 数値 / a.xxx (攻撃側) / t.xxx (対象側) / power (スキル威力)
+ *           xxx = atk def spd luk lv hp mhp mp mmp
+ *   演算  : + - * / % 単項- 括弧 (0 除算は 0)
+ *   関数  : min(x,y) max(x,y) abs(x) floor(x) sqrt(x)
+ *           rand(lo,hi)  … lo〜hi の整数乱数
+ *           vary(x,pct)  … 整数化した x に ±pct% の整数乱数を足す
+ *
+ * 既定の式 (rpg_calc_damage と同じ) は "vary(max(a.atk*4 - t.def*2, 1), 10)"。
+ *
+ * RPG_DETERMINISTIC では値を double でなく 1/10000 単位の固定小数点で持つ
+ * (数値は 10 進の小数のみ。指数表記は不可。絶対値は 2^31 で頭打ち)。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 乱数 (eng_battle.c から) */
+int rpg_battle_rand(int lo, int hi);
+
+#define FORM_MAX_NODES 128
+#define FORM_MAX_REGS  16
+#define FORM_MAX_CODE  128
+#define FORM_MAX_CONST 64
+#define FORM_LANES     16   /* 一括評価のレーン幅 */
+
+/* ── 変数 ───────────────────────────────────────────────*/
+enum {
+    V_ATK, V_DEF, V_SPD, V_LUK, V_LV, V_HP, V_MHP, V_MP, V_MMP,
+    V_STATS,
+    V_POWER = V_STATS * 2,   /* [0, V_STATS) は攻撃側, [V_STATS, 2*V_STATS) は対象側 */
+    V_COUNT
+};
+static const char* const k_stat_names[V_STATS] = {
+    "atk", "def", "spd", "luk", "lv", "hp", "mhp", "mp", "mmp"
+};
+
+/* ── 数値 ───────────────────────────────────────────────*/
+#if RPG_DETERMINISTIC
+/* 1/10000 単位の int64 (0.1 や 1.5 のような 10 進の定数が正確に表せる)。
+ * 絶対値は 2^31 未満に飽和させ、乗除の端数は -∞ 方向に切り捨てる。
+ * 整数への変換は double 版の (int) と同じく 0 方向。 */
+typedef int64_t FormNum;
+#define FX_ONE   10000
+#define FX_LIMIT (INT64_C(2147483647) * FX_ONE + (FX_ONE - 1))
+
+static inline FormNum fx_clamp(int64_t v) { return v > FX_LIMIT ? FX_LIMIT : v < -FX_LIMIT ? -FX_LIMIT : v; }
+static inline int64_t floor_div(int64_t n, int64_t d) {
+    int64_t q = n / d;
+    return (n % d != 0 && (n < 0) != (d < 0)) ? q - 1 : q;
+}
+
+static inline FormNum num_int(int v)           { return (FormNum)v * FX_ONE; }
+static inline int     num_to_int(FormNum v)    { return (int)(v / FX_ONE); }
+static inline double  num_to_double(FormNum v) { return (double)v / FX_ONE; }
+static inline FormNum num_add(FormNum x, FormNum y) { return fx_clamp(x + y); }
+static inline FormNum num_sub(FormNum x, FormNum y) { return fx_clamp(x - y); }
+static inline FormNum num_abs(FormNum x)            { return x < 0 ? -x : x; }
+static inline FormNum num_floor(FormNum x)          { return floor_div(x, FX_ONE) * FX_ONE; }
+
+/* 整数部と端数に分けて掛ける (x = xi + xf/FX_ONE, 0 <= xf < FX_ONE) */
+static FormNum num_mul(FormNum x, FormNum y) {
+    int64_t xi = floor_div(x, FX_ONE), xf = x - xi * FX_ONE;
+    int64_t yi = floor_div(y, FX_ONE), yf = y - yi * FX_ONE;
+    int64_t ii = xi * yi;
+    if (ii >  (INT64_C(1) << 33)) return FX_LIMIT;   /* 残りの項では範囲内に戻らない */
+    if (ii < -(INT64_C(1) << 33)) return -FX_LIMIT;
+    return fx_clamp(ii * FX_ONE + xi * yf + xf * yi + xf * yf / FX_ONE);
+}
+
+static inline FormNum num_div(FormNum x, FormNum y) { return y != 0 ? fx_clamp(floor_div(x * FX_ONE, y)) : 0; }
+static inline FormNum num_mod(FormNum x, FormNum y) { return y != 0 ? x % y : 0; }   /* fmod と同じ符号 */
+
+static FormNum num_sqrt(FormNum x) {
+    if (x <= 0) return 0;
+    uint64_t v = (uint64_t)x * FX_ONE, r = 0, bit = UINT64_C(1) << 62;
+    while (bit > v) bit >>= 2;
+    for (; bit; bit >>= 2) {
+        if (v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+        else              r >>= 1;
+    }
+    return (FormNum)r;
+}
+
+/* 10 進の小数を最も近い 1/FX_ONE に丸める (strtod の実装差を避ける) */
+static FormNum num_parse(const char* s, char** end) {
+    int64_t ip = 0, fp = 0, scale = 1;
+    for (; isdigit((unsigned char)*s); ++s)
+        if (ip <= FX_LIMIT / FX_ONE) ip = ip * 10 + (*s - '0');
+    if (*s == '.')
+        for (++s; isdigit((unsigned char)*s); ++s)
+            if (scale < INT64_C(1000000000000)) { fp = fp * 10 + (*s - '0'); scale *= 10; }
+    *end = (char*)s;
+    return fx_clamp(ip * FX_ONE + (fp * FX_ONE * 2 + scale) / (scale * 2));
+}
+
+/* rand の中央 ((lo + hi) / 2 は 1/2 単位なので正確) */
+static inline FormNum num_mid(int lo, int hi) { return ((int64_t)lo + hi) * (FX_ONE / 2); }
+#else
+typedef double FormNum;
+
+static inline FormNum num_int(int v)           { return v; }
+static inline int     num_to_int(FormNum v)    { return (int)v; }
+static inline double  num_to_double(FormNum v) { return v; }
+static inline FormNum num_add(FormNum x, FormNum y) { return x + y; }
+static inline FormNum num_sub(FormNum x, FormNum y) { return x - y; }
+static inline FormNum num_mul(FormNum x, FormNum y) { return x * y; }
+static inline FormNum num_div(FormNum x, FormNum y) { return y != 0 ? x / y : 0; }
+static inline FormNum num_mod(FormNum x, FormNum y) { return y != 0 ? fmod(x, y) : 0; }
+static inline FormNum num_abs(FormNum x)            { return fabs(x); }
+static inline FormNum num_floor(FormNum x)          { return floor(x); }
+static inline FormNum num_sqrt(FormNum x)           { return x > 0 ? sqrt(x) : 0; }
+static inline FormNum num_parse(const char* s, char** end) { return strtod(s, end); }
+static inline FormNum num_mid(int lo, int hi)       { return ((double)lo + hi) / 2; }
+#endif
+
+/* vary の揺らぎ幅 |base * pct / 100| */
+static int vary_span(int base, FormNum pct) {
+    return abs(num_to_int(num_div(num_mul(num_int(base), pct), num_int(100))));
+}
+
+static void load_stats(FormNum* v, const RPG_Actor* a) {
+    if (!a) { memset(v, 0, sizeof(*v) * V_STATS); return; }
+    v[V_ATK] = num_int(a->atk);  v[V_DEF] = num_int(a->def);    v[V_SPD] = num_int(a->spd);
+    v[V_LUK] = num_int(a->luk);  v[V_LV]  = num_int(a->level);
+    v[V_HP]  = num_int(a->hp);   v[V_MHP] = num_int(a->max_hp);
+    v[V_MP]  = num_int(a->mp);   v[V_MMP] = num_int(a->max_mp);
+}
+
+/* ── 命令 ───────────────────────────────────────────────*/
+typedef enum {
+    OP_CONST, OP_VAR,                       /* 構文木のみ */
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_NEG,
+    OP_MIN, OP_MAX, OP_ABS, OP_FLOOR, OP_SQRT,
+    OP_RAND, OP_VARY,
+    OP_LOADK, OP_LOADV,                     /* バイトコードのみ */
+    OP_ADDK, OP_SUBK, OP_MULK, OP_DIVK,     /* 右辺が定数 */
+} FormOp;
+
+typedef struct { uint8_t op, dst, a, b; } FormIns;   /* a/b はレジスタ, 定数番号, 変数番号 */
+
+struct RPG_Formula {
+    FormIns ins[FORM_MAX_CODE];
+    FormNum k[FORM_MAX_CONST];
+    int     n_ins, n_k;
+    bool    uses_target;   /* 対象側の値を読むか (一括評価で詰め替えを省く) */
+};
+
+static FormNum op_apply(int op, FormNum x, FormNum y) {
+    switch (op) {
+    case OP_ADD: case OP_ADDK: return num_add(x, y);
+    case OP_SUB: case OP_SUBK: return num_sub(x, y);
+    case OP_MUL: case OP_MULK: return num_mul(x, y);
+    case OP_DIV: case OP_DIVK: return num_div(x, y);
+    case OP_MOD:   return num_mod(x, y);
+    case OP_NEG:   return -x;
+    case OP_MIN:   return x < y ? x : y;
+    case OP_MAX:   return x > y ? x : y;
+    case OP_ABS:   return num_abs(x);
+    case OP_FLOOR: return num_floor(x);
+    case OP_SQRT:  return num_sqrt(x);
+    case OP_RAND:  return num_int(rpg_battle_rand(num_to_int(x), num_to_int(y)));
+    case OP_VARY: {
+        int base = num_to_int(x);
+        int var  = vary_span(base, y);
+        return num_add(num_int(base), num_int(rpg_battle_rand(-var, var)));
+    }
+    }
+    return 0;
+}
+
+/* ── 構文解析 ───────────────────────────────────────────*/
+typedef struct {
+    uint8_t op, n;
+    int16_t kid[3];
+    FormNum val;      /* OP_CONST の値 / OP_VAR の変数番号 (そのままの整数) */
+} FormNode;
+
+typedef struct {
+    const char* src;
+    const char* p;
+    FormNode    node[FORM_MAX_NODES];
+    int         n_node;
+    int         depth;    /* 括弧/単項演算の入れ子 */
+    char*       err;
+    size_t      err_len;
+    bool        failed;
+} FormParser;
+
+static int parse_fail(FormParser* ps, const char* msg) {
+    if (!ps->failed && ps->err && ps->err_len)
+        snprintf(ps->err, ps->err_len, "%d 文字目: %s", (int)(ps->p - ps->src) + 1, msg);
+    ps->failed = true;
+    return -1;
+}
+
+static int node_new(FormParser* ps, int op, FormNum val, int a, int b, int c) {
+    if (ps->n_node >= FORM_MAX_NODES) return parse_fail(ps, "式が長すぎる");
+    FormNode* n = &ps->node[ps->n_node];
+    n->op = (uint8_t)op; n->val = val;
+    n->kid[0] = (int16_t)a; n->kid[1] = (int16_t)b; n->kid[2] = (int16_t)c;
+    n->n = (uint8_t)((a >= 0) + (b >= 0) + (c >= 0));
+    return ps->n_node++;
+}
+
+static void skip_ws(FormParser* ps) { while (isspace((unsigned char)*ps->p)) ps->p++; }
+
+static bool accept(FormParser* ps, char c) {
+    skip_ws(ps);
+    if (*ps->p != c) return false;
+    ps->p++;
+    return true;
+}
+
+static int parse_expr(FormParser* ps);
+
+static const struct { const char* name; int op, argc; } k_funcs[] = {
+    { "min", OP_MIN, 2 }, { "max", OP_MAX, 2 }, { "abs", OP_ABS, 1 },
+    { "floor", OP_FLOOR, 1 }, { "sqrt", OP_SQRT, 1 },
+    { "rand", OP_RAND, 2 }, { "vary", OP_VARY, 2 },
+};
+
+static int parse_ident(FormParser* ps) {
+    const char* s = ps->p;
+    while (isalnum((unsigned char)*ps->p) || *ps->p == '_' || *ps->p == '.') ps->p++;
+    size_t len = (size_t)(ps->p - s);
+    char name[32];
+    if (len >= sizeof(name)) return parse_fail(ps, "名前が長すぎる");
+    memcpy(name, s, len);
+    name[len] = '\0';
+
+    if (accept(ps, '(')) {
+        for (size_t i = 0; i < sizeof(k_funcs) / sizeof(k_funcs[0]); ++i) {
+            if (strcmp(name, k_funcs[i].name) != 0) continue;
+            int arg[2] = { -1, -1 };
+            for (int j = 0; j < k_funcs[i].argc; ++j) {
+                if (j && !accept(ps, ',')) return parse_fail(ps, "',' が必要");
+                if ((arg[j] = parse_expr(ps)) < 0) return -1;
+            }
+            if (!accept(ps, ')')) return parse_fail(ps, "')' が必要");
+            return node_new(ps, k_funcs[i].op, 0, arg[0], arg[1], -1);
+        }
+        ps->p = s;
+        return parse_fail(ps, "未知の関数");
+    }
+    if (strcmp(name, "power") == 0) return node_new(ps, OP_VAR, V_POWER, -1, -1, -1);
+    if ((name[0] == 'a' || name[0] == 't') && name[1] == '.') {
+        for (int i = 0; i < V_STATS; ++i)
+            if (strcmp(name + 2, k_stat_names[i]) == 0)
+                return node_new(ps, OP_VAR, (name[0] == 't') * V_STATS + i, -1, -1, -1);
+    }
+    ps->p = s;
+    return parse_fail(ps, "未知の変数");
+}
+
+static int parse_primary(FormParser* ps) {
+    skip_ws(ps);
+    if (accept(ps, '(')) {
+        int e = parse_expr(ps);
+        if (e >= 0 && !accept(ps, ')')) return parse_fail(ps, "')' が必要");
+        return e;
+    }
+    if (isdigit((unsigned char)*ps->p) || *ps->p == '.') {
+        char* end;
+        FormNum v = num_parse(ps->p, &end);
+        ps->p = end;
+        return node_new(ps, OP_CONST, v, -1, -1, -1);
+    }
+    if (isalpha((unsigned char)*ps->p) || *ps->p == '_') return parse_ident(ps);
+    return parse_fail(ps, *ps->p ? "値が必要" : "式が途中で終わっている");
+}
+
+static int parse_unary(FormParser* ps) {
+    if (++ps->depth > FORM_MAX_NODES) return parse_fail(ps, "式の入れ子が深すぎる");
+    int e;
+    if (accept(ps, '-')) {
+        e = parse_unary(ps);
+        if (e >= 0) e = node_new(ps, OP_NEG, 0, e, -1, -1);
+    } else if (accept(ps, '+')) {
+        e = parse_unary(ps);
+    } else {
+        e = parse_primary(ps);
+    }
+    ps->depth--;
+    return e;
+}
+
+static int parse_term(FormParser* ps) {
+    int l = parse_unary(ps);
+    while (l >= 0) {
+        int op = accept(ps, '*') ? OP_MUL : accept(ps, '/') ? OP_DIV : accept(ps, '%') ? OP_MOD : -1;
+        if (op < 0) break;
+        int r = parse_unary(ps);
+        l = r < 0 ? -1 : node_new(ps, op, 0, l, r, -1);
+    }
+    return l;
+}
+
+static int parse_expr(FormParser* ps) {
+    int l = parse_term(ps);
+    while (l >= 0) {
+        int op = accept(ps, '+') ? OP_ADD : accept(ps, '-') ? OP_SUB : -1;
+        if (op < 0) break;
+        int r = parse_term(ps);
+        l = r < 0 ? -1 : node_new(ps, op, 0, l, r, -1);
+    }
+    return l;
+}
+
+/* ── 定数畳み込み ───────────────────────────────────────*/
+static bool is_const(const FormParser* ps, int i, FormNum v) {
+    return ps->node[i].op == OP_CONST && ps->node[i].val == v;
+}
+
+/* 畳み込んだ結果のノード番号を返す (子に置き換わることがある) */
+static int fold(FormParser* ps, int i) {
+    FormNode* n = &ps->node[i];
+    if (n->op == OP_CONST || n->op == OP_VAR) return i;
+    bool all_const = true;
+    for (int j = 0; j < n->n; ++j) {
+        n->kid[j] = (int16_t)fold(ps, n->kid[j]);
+        all_const &= ps->node[n->kid[j]].op == OP_CONST;
+    }
+    if (all_const && n->op != OP_RAND && n->op != OP_VARY) {
+        FormNum y = n->n > 1 ? ps->node[n->kid[1]].val : 0;
+        n->val = op_apply(n->op, ps->node[n->kid[0]].val, y);
+        n->op  = OP_CONST;
+        n->n   = 0;
+        return i;
+    }
+    /* 恒等式: x+0, 0+x, x-0, x*1, 1*x, x/1 */
+    int a = n->kid[0], b = n->kid[1];
+    switch (n->op) {
+    case OP_ADD: if (is_const(ps, b, 0)) return a; if (is_const(ps, a, 0)) return b; break;
+    case OP_SUB: if (is_const(ps, b, 0)) return a; break;
+    case OP_MUL: if (is_const(ps, b, num_int(1))) return a; if (is_const(ps, a, num_int(1))) return b; break;
+    case OP_DIV: if (is_const(ps, b, num_int(1))) return a; break;
+    }
+    return i;
+}
+
+/* ── コード生成 ─────────────────────────────────────────*/
+static int const_index(RPG_Formula* f, FormNum v) {
+    for (int i = 0; i < f->n_k; ++i)
+        if (f->k[i] == v) return i;
+    if (f->n_k >= FORM_MAX_CONST) return -1;
+    f->k[f->n_k] = v;
+    return f->n_k++;
+}
+
+static bool emit(FormParser* ps, RPG_Formula* f, int op, int dst, int a, int b) {
+    if (f->n_ins >= FORM_MAX_CODE || a < 0) {
+        parse_fail(ps, "式が複雑すぎる");
+        return false;
+    }
+    f->ins[f->n_ins++] = (FormIns){ (uint8_t)op, (uint8_t)dst, (uint8_t)a, (uint8_t)(b < 0 ? 0 : b) };
+    return true;
+}
+
+/* ノード i の値をレジスタ r に置く (r より上のレジスタは作業用) */
+static bool gen(FormParser* ps, RPG_Formula* f, int i, int r) {
+    const FormNode* n = &ps->node[i];
+    if (r >= FORM_MAX_REGS) { parse_fail(ps, "式の入れ子が深すぎる"); return false; }
+    if (n->op == OP_CONST) return emit(ps, f, OP_LOADK, r, const_index(f, n->val), 0);
+    if (n->op == OP_VAR) {
+        if ((int)n->val >= V_STATS && (int)n->val < V_POWER) f->uses_target = true;
+        return emit(ps, f, OP_LOADV, r, (int)n->val, 0);
+    }
+    int a = n->kid[0], b = n->n > 1 ? n->kid[1] : -1;
+    /* 可換な演算は定数を右に寄せる */
+    if ((n->op == OP_ADD || n->op == OP_MUL) && ps->node[a].op == OP_CONST) { int t = a; a = b; b = t; }
+    if (!gen(ps, f, a, r)) return false;
+    if (b < 0) return emit(ps, f, n->op, r, r, 0);
+    if (ps->node[b].op == OP_CONST) {
+        int kop = n->op == OP_ADD ? OP_ADDK : n->op == OP_SUB ? OP_SUBK :
+                  n->op == OP_MUL ? OP_MULK : n->op == OP_DIV ? OP_DIVK : -1;
+        if (kop >= 0) return emit(ps, f, kop, r, r, const_index(f, ps->node[b].val));
+    }
+    return gen(ps, f, b, r + 1) && emit(ps, f, n->op, r, r, r + 1);
+}
+
+RPG_Formula* rpg_formula_compile(const char* src, char* err, size_t err_len) {
+    if (err && err_len) err[0] = '\0';
+    if (!src) return NULL;
+    FormParser* ps = calloc(1, sizeof(*ps));
+    RPG_Formula* f = calloc(1, sizeof(*f));
+    if (!ps || !f) { free(ps); free(f); return NULL; }
+    ps->src = ps->p = src;
+    ps->err = err; ps->err_len = err_len;
+
+    int root = parse_expr(ps);
+    skip_ws(ps);
+    if (root >= 0 && *ps->p) root = parse_fail(ps, "余分な文字がある");
+    if (root >= 0 && !gen(ps, f, fold(ps, root), 0)) root = -1;
+    free(ps);
+    if (root < 0) { free(f); return NULL; }
+    return f;
+}
+
+void rpg_formula_free(RPG_Formula* f) { free(f); }
+
+bool rpg_formula_constant(const RPG_Formula* f, double* value) {
+    if (!f || f->n_ins != 1 || f->ins[0].op != OP_LOADK) return false;
+    if (value) *value = num_to_double(f->k[f->ins[0].a]);
+    return true;
+}
+
+int rpg_formula_length(const RPG_Formula* f) { return f ? f->n_ins : 0; }
+
+/* ── 評価 ───────────────────────────────────────────────*/
+static inline void exec(const RPG_Formula* f, const FormIns* in, FormNum* r, const FormNum* v) {
+    switch (in->op) {
+    case OP_LOADK: r[in->dst] = f->k[in->a]; break;
+    case OP_LOADV: r[in->dst] = v[in->a]; break;
+    case OP_ADD:   r[in->dst] = num_add(r[in->a], r[in->b]); break;
+    case OP_SUB:   r[in->dst] = num_sub(r[in->a], r[in->b]); break;
+    case OP_MUL:   r[in->dst] = num_mul(r[in->a], r[in->b]); break;
+    case OP_ADDK:  r[in->dst] = num_add(r[in->a], f->k[in->b]); break;
+    case OP_SUBK:  r[in->dst] = num_sub(r[in->a], f->k[in->b]); break;
+    case OP_MULK:  r[in->dst] = num_mul(r[in->a], f->k[in->b]); break;
+    case OP_DIVK:  r[in->dst] = op_apply(OP_DIV, r[in->a], f->k[in->b]); break;
+    default:       r[in->dst] = op_apply(in->op, r[in->a], r[in->b]); break;
+    }
+}
+
+static FormNum run(const RPG_Formula* f, const FormNum* v) {
+    FormNum r[FORM_MAX_REGS];
+    for (const FormIns* in = f->ins, *end = f->ins + f->n_ins; in < end; ++in) exec(f, in, r, v);
+    return r[0];
+}
+
+static FormNum eval(const RPG_Formula* f, const RPG_Actor* a, const RPG_Actor* t, int power) {
+    FormNum v[V_COUNT];
+    load_stats(v, a);
+    load_stats(v + V_STATS, t);
+    v[V_POWER] = num_int(power);
+    return run(f, v);
+}
+
+double rpg_formula_eval(const RPG_Formula* f, const RPG_Actor* a, const RPG_Actor* t, int power) {
+    return f ? num_to_double(eval(f, a, t, power)) : 0;
+}
+
+/* 対象ごとの値をレーンに並べ、命令ごとに FORM_LANES 本まとめて回す */
+static void eval_batch(const RPG_Formula* f, const RPG_Actor* a,
+                       const RPG_Actor* const* targets, int n, int power, FormNum* out) {
+    uint64_t tr = rpg_trace_begin();
+    FormNum av[V_COUNT];
+    load_stats(av, a);
+    av[V_POWER] = num_int(power);
+    for (int base = 0; base < n; base += FORM_LANES) {
+        int lanes = n - base < FORM_LANES ? n - base : FORM_LANES;
+        FormNum tv[V_STATS][FORM_LANES];
+        FormNum r[FORM_MAX_REGS][FORM_LANES];
+        if (f->uses_target) {
+            memset(tv, 0, sizeof(tv));
+            for (int l = 0; l < lanes; ++l) {
+                FormNum s[V_STATS];
+                load_stats(s, targets[base + l]);
+                for (int j = 0; j < V_STATS; ++j) tv[j][l] = s[j];
+            }
+        }
+        for (const FormIns* in = f->ins, *end = f->ins + f->n_ins; in < end; ++in) {
+            FormNum* d = r[in->dst];
+            if (in->op == OP_LOADK || in->op == OP_LOADV) {
+                if (in->op == OP_LOADV && in->a >= V_STATS && in->a < V_POWER) {
+                    memcpy(d, tv[in->a - V_STATS], sizeof(tv[0]));
+                } else {
+                    FormNum k = in->op == OP_LOADK ? f->k[in->a] : av[in->a];
+                    for (int l = 0; l < FORM_LANES; ++l) d[l] = k;
+                }
+                continue;
+            }
+            const FormNum* x = r[in->a];
+            const FormNum* y = in->op >= OP_ADDK ? NULL : r[in->b];   /* K 系の b は定数番号 */
+            switch (in->op) {
+            case OP_ADD:  for (int l = 0; l < FORM_LANES; ++l) d[l] = num_add(x[l], y[l]); break;
+            case OP_SUB:  for (int l = 0; l < FORM_LANES; ++l) d[l] = num_sub(x[l], y[l]); break;
+            case OP_MUL:  for (int l = 0; l < FORM_LANES; ++l) d[l] = num_mul(x[l], y[l]); break;
+            case OP_MIN:  for (int l = 0; l < FORM_LANES; ++l) d[l] = x[l] < y[l] ? x[l] : y[l]; break;
+            case OP_MAX:  for (int l = 0; l < FORM_LANES; ++l) d[l] = x[l] > y[l] ? x[l] : y[l]; break;
+            case OP_ADDK: { FormNum k = f->k[in->b]; for (int l = 0; l < FORM_LANES; ++l) d[l] = num_add(x[l], k); } break;
+            case OP_SUBK: { FormNum k = f->k[in->b]; for (int l = 0; l < FORM_LANES; ++l) d[l] = num_sub(x[l], k); } break;
+            case OP_MULK: { FormNum k = f->k[in->b]; for (int l = 0; l < FORM_LANES; ++l) d[l] = num_mul(x[l], k); } break;
+            /* 乱数などは使われているレーンだけ (残りは 0。全レーンの演算に未初期化値を読ませない) */
+            case OP_DIVK:
+                for (int l = 0; l < lanes; ++l) d[l] = op_apply(OP_DIV, x[l], f->k[in->b]);
+                for (int l = lanes; l < FORM_LANES; ++l) d[l] = 0;
+                break;
+            default:
+                for (int l = 0; l < lanes; ++l) d[l] = op_apply(in->op, x[l], y[l]);
+                for (int l = lanes; l < FORM_LANES; ++l) d[l] = 0;
+                break;
+            }
+        }
+        memcpy(out + base, r[0], sizeof(FormNum) * (size_t)lanes);
+    }
+    rpg_trace_end("rpg_formula_eval_batch", tr);
+}
+
+void rpg_formula_eval_batch(const RPG_Formula* f, const RPG_Actor* a,
+                            const RPG_Actor* const* targets, int n, int power, double* out) {
+    if (!f || !targets || !out || n <= 0) return;
+    FormNum v[FORM_LANES];
+    for (int base = 0; base < n; base += FORM_LANES) {
+        int m = n - base < FORM_LANES ? n - base : FORM_LANES;
+        eval_batch(f, a, targets + base, m, power, v);
+        for (int i = 0; i < m; ++i) out[base + i] = num_to_double(v[i]);
+    }
+}
+
+/* ── 全結果の列挙 (eng_odds.c の分布計算用) ────────────*/
+typedef struct {
+    void (*emit)(void* ctx, int dmg, double p);
+    void*  ctx;
+    long   outcomes;
+} FormEnum;
+
+static int to_damage(FormNum v) { return v > 0 ? (v < num_int(INT32_MAX) ? num_to_int(v) : INT32_MAX) : 0; }
+
+/* 乱数命令で枝分かれしながら命令列を最後まで進める。各枝の確率は等分。 */
+static bool enum_from(const RPG_Formula* f, const FormIns* in, FormNum* r,
+                      const FormNum* v, double p, FormEnum* e) {
+    for (const FormIns* end = f->ins + f->n_ins; in < end; ++in) {
+        if (in->op != OP_RAND && in->op != OP_VARY) { exec(f, in, r, v); continue; }
+        int base = 0, lo, hi;
+        if (in->op == OP_RAND) {
+            lo = num_to_int(r[in->a]); hi = num_to_int(r[in->b]);
+        } else {
+            base = num_to_int(r[in->a]);
+            hi = vary_span(base, r[in->b]); lo = -hi;
+        }
+        if (lo >= hi) { r[in->dst] = num_add(num_int(base), num_int(lo)); continue; }   /* rpg_battle_rand と同じく lo */
+        double q = p / (hi - lo + 1);
+        for (int x = lo; x <= hi; ++x) {
+            FormNum rr[FORM_MAX_REGS];
+            memcpy(rr, r, sizeof(rr));
+            rr[in->dst] = num_add(num_int(base), num_int(x));
+            if (!enum_from(f, in + 1, rr, v, q, e)) return false;
+        }
+        return true;
+    }
+    if (++e->outcomes > RPG_PMF_MAX_OUTCOMES) return false;
+    e->emit(e->ctx, to_damage(r[0]), p);
+    return true;
+}
+
+/* rpg_damage_compute が取りうる全ての値と確率を emit に渡す。
+ * 乱数の組み合わせが RPG_PMF_MAX_OUTCOMES を超えると false。 */
+bool rpg_damage_enumerate(const RPG_Actor* a, const RPG_Actor* t, int skill_id,
+                          void (*emit)(void* ctx, int dmg, double p), void* ctx) {
+    if (!a || !t || !emit) return false;
+    const RPG_Skill* sk = skill_id > 0 ? rpg_skill_get(skill_id) : NULL;
+    int power = sk ? sk->power : 0;
+    const RPG_Formula* f = rpg_damage_formula_get(skill_id);
+    if (!f) {
+        /* rpg_calc_damage: base ± base/10 の一様分布 */
+        int base = (a->atk + power) * 4 - t->def * 2;
+        if (base < 1) base = 1;
+        int var = base / 10;
+        for (int x = -var; x <= var; ++x) emit(ctx, base + x, 1.0 / (2 * var + 1));
+        return true;
+    }
+    FormNum v[V_COUNT], r[FORM_MAX_REGS];
+    load_stats(v, a);
+    load_stats(v + V_STATS, t);
+    v[V_POWER] = num_int(power);
+    FormEnum e = { emit, ctx, 0 };
+    return enum_from(f, f->ins, r, v, 1.0, &e);
+}
+
+/* ── バトルで使う式 ─────────────────────────────────────*/
+/* [0] は通常攻撃、かつ自前の式を持たないスキルの既定 */
+static RPG_Formula* g_damage[RPG_MAX_SKILLS + 1];
+
+bool rpg_damage_formula_set(int skill_id, const char* src) {
+    if (skill_id < 0 || skill_id > RPG_MAX_SKILLS) return false;
+    RPG_Formula* f = NULL;
+    if (src && *src) {
+        char err[96];
+        if (!(f = rpg_formula_compile(src, err, sizeof(err)))) {
+            fprintf(stderr, "[eng_rpg] ダメージ式エラー (%s): %s\n", src, err);
+            return false;
+        }
+    }
+    rpg_formula_free(g_damage[skill_id]);
+    g_damage[skill_id] = f;
+    return true;
+}
+
+const RPG_Formula* rpg_damage_formula_get(int skill_id) {
+    if (skill_id < 0 || skill_id > RPG_MAX_SKILLS) return NULL;
+    return g_damage[skill_id] ? g_damage[skill_id] : g_damage[0];
+}
+
+/* 乱数項を平均に置き換えて評価する (rand は区間の中央, vary は揺らぎ 0) */
+static FormNum run_mean(const RPG_Formula* f, const FormNum* v) {
+    FormNum r[FORM_MAX_REGS];
+    for (const FormIns* in = f->ins, *end = f->ins + f->n_ins; in < end; ++in) {
+        if (in->op == OP_RAND) {
+            int lo = num_to_int(r[in->a]), hi = num_to_int(r[in->b]);
+            r[in->dst] = lo >= hi ? num_int(lo) : num_mid(lo, hi);
+        } else if (in->op == OP_VARY) {
+            r[in->dst] = num_int(num_to_int(r[in->a]));
+        } else {
+            exec(f, in, r, v);
+        }
+    }
+    return r[0];
+}
+
+double rpg_damage_expected(const RPG_Actor* a, const RPG_Actor* t, int skill_id) {
+    if (!a || !t) return 0;
+    const RPG_Skill* sk = skill_id > 0 ? rpg_skill_get(skill_id) : NULL;
+    int power = sk ? sk->power : 0;
+    const RPG_Formula* f = rpg_damage_formula_get(skill_id);
+    if (!f) {
+        int base = (a->atk + power) * 4 - t->def * 2;   /* 揺らぎは左右対称 */
+        return base < 1 ? 1 : base;
+    }
+    FormNum v[V_COUNT];
+    load_stats(v, a);
+    load_stats(v + V_STATS, t);
+    v[V_POWER] = num_int(power);
+    return to_damage(run_mean(f, v));
+}
+
+int rpg_damage_compute(const RPG_Actor* a, const RPG_Actor* t, int skill_id) {
+    if (!a || !t) return 0;
+    const RPG_Skill* sk = skill_id > 0 ? rpg_skill_get(skill_id) : NULL;
+    int power = sk ? sk->power : 0;
+    const RPG_Formula* f = rpg_damage_formula_get(skill_id);
+    if (!f) return rpg_calc_damage(a->atk + power, t->def);
+    return to_damage(eval(f, a, t, power));
+}
+
+void rpg_damage_compute_batch(const RPG_Actor* a, const RPG_Actor* const* targets,
+                              int n, int skill_id, int* out) {
+    if (!a || !targets || !out || n <= 0) return;
+    const RPG_Skill* sk = skill_id > 0 ? rpg_skill_get(skill_id) : NULL;
+    int power = sk ? sk->power : 0;
+    const RPG_Formula* f = rpg_damage_formula_get(skill_id);
+    if (!f) {
+        for (int i = 0; i < n; ++i) out[i] = targets[i] ? rpg_calc_damage(a->atk + power, targets[i]->def) : 0;
+        return;
+    }
+    FormNum v[FORM_LANES];
+    for (int base = 0; base < n; base += FORM_LANES) {
+        int m = n - base < FORM_LANES ? n - base : FORM_LANES;
+        eval_batch(f, a, targets + base, m, power, v);
+        for (int i = 0; i < m; ++i) out[base + i] = targets[base + i] ? to_damage(v[i]) : 0;
+    }
+}
+
+/* eng_session.c から (メモリ使用量) */
+size_t rpg_formula_bytes(void) {
+    size_t n = 0;
+    for (int i = 0; i <= RPG_MAX_SKILLS; ++i)
+        if (g_damage[i]) n += sizeof(RPG_Formula);
+    return n;
+}
@@ -0,0 +1,239 @@
+/**
+ * src/eng_hash.c — ワールド状態のハッシュ (デシンク検出/リプレイ検証)
+ *
+ * 対象はスナップショットと同じ状態領域。各領域をレコード (アクター 1 人、
+ * インベントリ 1 枠、フラグ 1 件…) に分け、レコードごとのハッシュの和を
+ * 全体のハッシュとする。書き込み口の汚れ印 (rpg_delta_touch 経由) で
+ * 変わったレコードだけを引いて足し直すので、1 回の更新は O(変更数)。
+ *
+ * 最初の rpg_state_hash で全レコードを計算して追跡を始める。
+ * 比較はバイト列なので、同じビルド同士でだけ意味がある。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 対象の状態 (各モジュールから) */
+void rpg_db_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_extra_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_save_state_regions(void (*add)(const char* tag, void* p, size_t size));
+
+#define HASH_MAX_REGIONS 16
+#define HASH_K 0x9E3779B97F4A7C15ULL
+
+/* 領域ごとのレコード数と名前 (一覧にない領域は丸ごと 1 レコード) */
+static const struct { char tag[5]; const char* name; int count; bool named; } k_kinds[] = {
+    { "ACTR", "actor",          RPG_MAX_ACTORS + 1, true  },
+    { "INVT", "inventory",      RPG_MAX_INVENTORY,  false },
+    { "GOLD", "gold",           1,                  false },
+    { "SKIL", "learned_skills", RPG_MAX_ACTORS + 1, false },
+    { "PRTY", "party",          RPG_PARTY_MGR_MAX,  false },
+    { "PRTN", "party_size",     1,                  false },
+    { "FLAG", "flag",           RPG_MAX_FLAGS,      true  },
+    { "VARS", "var",            RPG_MAX_VARS,       true  },
+    { "QUST", "quest",          RPG_MAX_QUESTS + 1, false },
+};
+
+typedef struct {
+    uint8_t*    p;
+    size_t      size;
+    size_t      rec_size;
+    int         count;
+    int         first;     /* 先頭レコードの通し番号 */
+    uint64_t    seed;
+    const char* name;
+    bool        named;     /* 先頭がキー/名前の文字列 */
+} HashRegion;
+
+static HashRegion g_regions[HASH_MAX_REGIONS];
+static int        g_region_count = 0;
+static int        g_records = 0;
+
+static bool       g_on = false;
+static uint64_t*  g_rec = NULL;     /* レコードごとのハッシュ */
+static uint64_t*  g_dirty = NULL;
+static uint64_t   g_sum = 0;
+
+/* ── ハッシュ関数 ───────────────────────────────────────*/
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 32; h *= 0xD6E8FEB86659FD93ULL;
+    h ^= h >> 32; h *= 0xD6E8FEB86659FD93ULL;
+    return h ^ (h >> 32);
+}
+
+static uint64_t hash_bytes(uint64_t seed, const uint8_t* p, size_t n) {
+    uint64_t h = seed ^ (n * HASH_K);
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h = (h ^ mix(v)) * HASH_K;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, n);
+    return mix(h ^ tail);
+}
+
+static uint64_t record_hash(const HashRegion* r, int i) {
+    return hash_bytes(r->seed + (uint64_t)i * HASH_K, r->p + r->rec_size * (size_t)i, r->rec_size);
+}
+
+/* ── 領域表 ─────────────────────────────────────────────*/
+static void add_region(const char* tag, void* p, size_t size) {
+    if (g_region_count >= HASH_MAX_REGIONS) {
+        fprintf(stderr, "[eng_rpg] 状態ハッシュの対象領域が多すぎる\n");
+        return;
+    }
+    HashRegion* r = &g_regions[g_region_count++];
+    r->p     = p;
+    r->size  = size;
+    r->count = 1;
+    r->name  = tag;
+    r->named = false;
+    for (size_t k = 0; k < sizeof(k_kinds) / sizeof(k_kinds[0]); ++k) {
+        if (strcmp(k_kinds[k].tag, tag) != 0 || size % (size_t)k_kinds[k].count) continue;
+        r->count = k_kinds[k].count;
+        r->name  = k_kinds[k].name;
+        r->named = k_kinds[k].named;
+    }
+    r->rec_size = size / (size_t)r->count;
+    r->first    = g_records;
+    r->seed     = 1469598103934665603ULL;
+    for (const char* c = tag; *c; ++c) r->seed = (r->seed ^ (uint8_t)*c) * 1099511628211ULL;
+    g_records += r->count;
+}
+
+static bool start(void) {
+    if (g_on) return true;
+    if (!g_region_count) {
+        rpg_db_state_regions(add_region);
+        rpg_extra_state_regions(add_region);
+        rpg_save_state_regions(add_region);
+    }
+    g_rec   = malloc(sizeof(uint64_t) * (size_t)g_records);
+    g_dirty = calloc(((size_t)g_records + 63) / 64, sizeof(uint64_t));
+    if (!g_rec || !g_dirty) {
+        free(g_rec); free(g_dirty);
+        g_rec = NULL; g_dirty = NULL;
+        return false;
+    }
+    g_sum = 0;
+    for (int k = 0; k < g_region_count; ++k) {
+        const HashRegion* r = &g_regions[k];
+        for (int i = 0; i < r->count; ++i) {
+            g_rec[r->first + i] = record_hash(r, i);
+            g_sum += g_rec[r->first + i];
+        }
+    }
+    g_on = true;
+    return true;
+}
+
+/* ── 汚れ印 (eng_delta.c から) ──────────────────────────*/
+void rpg_hash_touch(const void* p, size_t size) {
+    if (!g_on || size == 0) return;
+    const uint8_t* q = p;
+    for (int k = 0; k < g_region_count; ++k) {
+        const HashRegion* r = &g_regions[k];
+        if (q < r->p || q >= r->p + r->size) continue;
+        size_t off = (size_t)(q - r->p);
+        size_t end = off + size < r->size ? off + size : r->size;
+        int i0 = r->first + (int)(off / r->rec_size);
+        int i1 = r->first + (int)((end - 1) / r->rec_size);
+        for (int i = i0; i <= i1; ++i) g_dirty[i / 64] |= 1ULL << (i % 64);
+        return;
+    }
+}
+
+void rpg_hash_touch_all(void) {
+    if (!g_on) return;
+    memset(g_dirty, 0xFF, sizeof(uint64_t) * (((size_t)g_records + 63) / 64));
+}
+
+static const HashRegion* record_region(int i) {
+    int k = 0;
+    while (k + 1 < g_region_count && g_regions[k + 1].first <= i) ++k;
+    return &g_regions[k];
+}
+
+static void refresh(void) {
+    int words = (g_records + 63) / 64;
+    for (int w = 0; w < words; ++w) {
+        uint64_t bits = g_dirty[w];
+        g_dirty[w] = 0;
+        while (bits) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (i >= g_records) break;
+            const HashRegion* r = record_region(i);
+            uint64_t h = record_hash(r, i - r->first);
+            g_sum += h - g_rec[i];
+            g_rec[i] = h;
+        }
+    }
+}
+
+/* ── 公開 API ───────────────────────────────────────────*/
+uint64_t rpg_state_hash(void) {
+    if (!start()) return 0;
+    refresh();
+    return mix(g_sum);
+}
+
+int rpg_state_hash_records(uint64_t* out, int max) {
+    if (!start()) return 0;
+    refresh();
+    if (out) memcpy(out, g_rec, sizeof(uint64_t) * (size_t)(max < g_records ? max : g_records));
+    return g_records;
+}
+
+int rpg_state_hash_diff(const uint64_t* theirs, int n, int* out, int max) {
+    if (!theirs || !start()) return 0;
+    refresh();
+    int got = 0;
+    if (n != g_records) return -1;   /* 別のビルド */
+    for (int i = 0; i < n; ++i) {
+        if (g_rec[i] == theirs[i]) continue;
+        if (out && got < max) out[got] = i;
+        got++;
+    }
+    return got;
+}
+
+bool rpg_state_hash_describe(int record, char* buf, size_t n) {
+    if (!buf || n == 0) return false;
+    if (!start() || record < 0 || record >= g_records) { buf[0] = '\0'; return false; }
+    const HashRegion* r = record_region(record);
+    int i = record - r->first;
+    const char* key = r->named ? (const char*)(r->p + r->rec_size * (size_t)i) : "";
+    if (r->count == 1)      snprintf(buf, n, "%s", r->name);
+    else if (key[0])        snprintf(buf, n, "%s %d (%.*s)", r->name, i, RPG_KEY_LEN - 1, key);
+    else                    snprintf(buf, n, "%s %d", r->name, i);
+    return true;
+}
+
+int rpg_state_hash_check(void) {
+    if (!start()) return 0;
+    refresh();
+    int stale = 0;
+    for (int k = 0; k < g_region_count; ++k) {
+        const HashRegion* r = &g_regions[k];
+        for (int i = 0; i < r->count; ++i) {
+            uint64_t h = record_hash(r, i);
+            if (h == g_rec[r->first + i]) continue;
+            char name[96];
+            rpg_state_hash_describe(r->first + i, name, sizeof(name));
+            fprintf(stderr, "[eng_rpg] 状態ハッシュ: %s が汚れ印なしで書き換えられた\n", name);
+            g_sum += h - g_rec[r->first + i];
+            g_rec[r->first + i] = h;
+            stale++;
+        }
+    }
+    return stale;
+}
+
+size_t rpg_hash_bytes(void) {
+    return g_on ? sizeof(uint64_t) * (size_t)g_records + sizeof(uint64_t) * (((size_t)g_records + 63) / 64) : 0;
+}
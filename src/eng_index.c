@@ -0,0 +1,208 @@
+/**
+ * src/eng_index.c — アイテム/スキル DB の二次索引
+ *
+ * rpg_item_set/init, rpg_skill_set/init のたびに該当 id だけを索引から
+ * 外して入れ直す。索引は登録時のキー (種別/価格/名前ハッシュ/対象/MP) を
+ * 自前で控えているので、古い値を探すために DB を走査することはない。
+ *
+ *   アイテム: 種別 → ビット集合, 価格 → (価格, id) の整列配列, 名前 → ハッシュ連鎖
+ *   スキル  : 対象 → ビット集合, 消費 MP → (MP, id) の整列配列
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <string.h>
+
+#define ITEM_WORDS   ((RPG_MAX_ITEMS  + 1 + 63) / 64)
+#define SKILL_WORDS  ((RPG_MAX_SKILLS + 1 + 63) / 64)
+#define NAME_BUCKETS 512   /* 2 の冪 */
+
+typedef struct { int key, id; } SortEnt;
+
+/* 整列配列 (key, id の辞書順) */
+static int sorted_lower(const SortEnt* v, int n, int key, int id) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (v[mid].key < key || (v[mid].key == key && v[mid].id < id)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+static void sorted_insert(SortEnt* v, int* n, int key, int id) {
+    int i = sorted_lower(v, *n, key, id);
+    memmove(&v[i + 1], &v[i], sizeof(*v) * (size_t)(*n - i));
+    v[i] = (SortEnt){ key, id };
+    (*n)++;
+}
+static void sorted_remove(SortEnt* v, int* n, int key, int id) {
+    int i = sorted_lower(v, *n, key, id);
+    if (i >= *n || v[i].id != id) return;
+    memmove(&v[i], &v[i + 1], sizeof(*v) * (size_t)(*n - i - 1));
+    (*n)--;
+}
+/* key が [lo, hi] の範囲を out に書き、書いた件数を返す */
+static int sorted_range(const SortEnt* v, int n, int lo, int hi,
+                        const uint64_t* filter, int* out, int max) {
+    int got = 0;
+    for (int i = sorted_lower(v, n, lo, 0); i < n && v[i].key <= hi && got < max; ++i)
+        if (!filter || (filter[v[i].id / 64] >> (v[i].id % 64) & 1)) out[got++] = v[i].id;
+    return got;
+}
+
+static int bits_list(const uint64_t* bits, int words, int* out, int max) {
+    int got = 0;
+    for (int w = 0; w < words && got < max; ++w) {
+        for (uint64_t b = bits[w]; b && got < max; b &= b - 1)
+            out[got++] = w * 64 + __builtin_ctzll(b);
+    }
+    return got;
+}
+
+static uint32_t name_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    for (; *s; ++s) h = (h ^ (uint8_t)*s) * 16777619u;
+    return h;
+}
+
+/* ── アイテム ───────────────────────────────────────────*/
+static struct {
+    bool     in[RPG_MAX_ITEMS + 1];
+    int      type[RPG_MAX_ITEMS + 1], price[RPG_MAX_ITEMS + 1];
+    uint32_t hash[RPG_MAX_ITEMS + 1];
+    uint64_t by_type[RPG_INDEX_KINDS][ITEM_WORDS];
+    uint64_t other_type[ITEM_WORDS];         /* 範囲外の種別 */
+    SortEnt  by_price[RPG_MAX_ITEMS];
+    int      n_price;
+    uint16_t name_head[NAME_BUCKETS];        /* 0=空 */
+    uint16_t name_next[RPG_MAX_ITEMS + 1];   /* id 昇順の連鎖 */
+} g_ix;
+
+static uint64_t* item_type_bits(int type) {
+    return (type >= 0 && type < RPG_INDEX_KINDS) ? g_ix.by_type[type] : g_ix.other_type;
+}
+
+static void item_unindex(int id) {
+    if (!g_ix.in[id]) return;
+    item_type_bits(g_ix.type[id])[id / 64] &= ~(1ull << (id % 64));
+    sorted_remove(g_ix.by_price, &g_ix.n_price, g_ix.price[id], id);
+    uint16_t* p = &g_ix.name_head[g_ix.hash[id] & (NAME_BUCKETS - 1)];
+    while (*p && *p != id) p = &g_ix.name_next[*p];
+    if (*p) *p = g_ix.name_next[id];
+    g_ix.in[id] = false;
+}
+
+/* eng_db.c から: id の内容が変わった (未使用になった場合も含む) */
+void rpg_index_item_changed(int id) {
+    if (id < 1 || id > RPG_MAX_ITEMS) return;
+    item_unindex(id);
+    const RPG_Item* it = rpg_item_get(id);
+    if (!it) return;
+    g_ix.in[id]    = true;
+    g_ix.type[id]  = it->type;
+    g_ix.price[id] = it->price;
+    g_ix.hash[id]  = name_hash(it->name);
+    item_type_bits(it->type)[id / 64] |= 1ull << (id % 64);
+    sorted_insert(g_ix.by_price, &g_ix.n_price, it->price, id);
+    uint16_t* p = &g_ix.name_head[g_ix.hash[id] & (NAME_BUCKETS - 1)];
+    while (*p && *p < id) p = &g_ix.name_next[*p];
+    g_ix.name_next[id] = *p;
+    *p = (uint16_t)id;
+}
+
+int rpg_item_find_by_type(int type, int* out, int max) {
+    if (!out || max <= 0) return 0;
+    if (type >= 0 && type < RPG_INDEX_KINDS) return bits_list(g_ix.by_type[type], ITEM_WORDS, out, max);
+    int got = 0;   /* 範囲外の種別は控えた値で絞る */
+    for (int id = 1; id <= RPG_MAX_ITEMS && got < max; ++id)
+        if (g_ix.in[id] && g_ix.type[id] == type) out[got++] = id;
+    return got;
+}
+
+int rpg_item_find_by_price(int type, int min_price, int max_price, int* out, int max) {
+    if (!out || max <= 0 || min_price > max_price) return 0;
+    if (type < 0)
+        return sorted_range(g_ix.by_price, g_ix.n_price, min_price, max_price, NULL, out, max);
+    if (type < RPG_INDEX_KINDS)
+        return sorted_range(g_ix.by_price, g_ix.n_price, min_price, max_price, g_ix.by_type[type], out, max);
+    int got = 0;
+    for (int i = sorted_lower(g_ix.by_price, g_ix.n_price, min_price, 0);
+         i < g_ix.n_price && g_ix.by_price[i].key <= max_price && got < max; ++i)
+        if (g_ix.type[g_ix.by_price[i].id] == type) out[got++] = g_ix.by_price[i].id;
+    return got;
+}
+
+int rpg_item_find_by_name(const char* name) {
+    if (!name) return 0;
+    uint32_t h = name_hash(name);
+    for (int id = g_ix.name_head[h & (NAME_BUCKETS - 1)]; id; id = g_ix.name_next[id]) {
+        const RPG_Item* it = rpg_item_get(id);
+        if (g_ix.hash[id] == h && it && strcmp(it->name, name) == 0) return id;
+    }
+    return 0;
+}
+
+/* ── スキル ─────────────────────────────────────────────*/
+static struct {
+    bool     in[RPG_MAX_SKILLS + 1];
+    int      target[RPG_MAX_SKILLS + 1], mp[RPG_MAX_SKILLS + 1];
+    uint64_t by_target[RPG_INDEX_KINDS][SKILL_WORDS];
+    uint64_t other_target[SKILL_WORDS];
+    SortEnt  by_mp[RPG_MAX_SKILLS];
+    int      n_mp;
+} g_sx;
+
+static uint64_t* skill_target_bits(int target) {
+    return (target >= 0 && target < RPG_INDEX_KINDS) ? g_sx.by_target[target] : g_sx.other_target;
+}
+
+/* eng_db.c から */
+void rpg_index_skill_changed(int id) {
+    if (id < 1 || id > RPG_MAX_SKILLS) return;
+    if (g_sx.in[id]) {
+        skill_target_bits(g_sx.target[id])[id / 64] &= ~(1ull << (id % 64));
+        sorted_remove(g_sx.by_mp, &g_sx.n_mp, g_sx.mp[id], id);
+        g_sx.in[id] = false;
+    }
+    const RPG_Skill* sk = rpg_skill_get(id);
+    if (!sk) return;
+    g_sx.in[id]     = true;
+    g_sx.target[id] = sk->target;
+    g_sx.mp[id]     = sk->mp_cost;
+    skill_target_bits(sk->target)[id / 64] |= 1ull << (id % 64);
+    sorted_insert(g_sx.by_mp, &g_sx.n_mp, sk->mp_cost, id);
+}
+
+int rpg_skill_find_by_target(int target, int* out, int max) {
+    if (!out || max <= 0) return 0;
+    if (target >= 0 && target < RPG_INDEX_KINDS)
+        return bits_list(g_sx.by_target[target], SKILL_WORDS, out, max);
+    int got = 0;
+    for (int id = 1; id <= RPG_MAX_SKILLS && got < max; ++id)
+        if (g_sx.in[id] && g_sx.target[id] == target) out[got++] = id;
+    return got;
+}
+
+int rpg_skill_find_by_mp(int target, int min_mp, int max_mp, int* out, int max) {
+    if (!out || max <= 0 || min_mp > max_mp) return 0;
+    if (target < 0)
+        return sorted_range(g_sx.by_mp, g_sx.n_mp, min_mp, max_mp, NULL, out, max);
+    if (target < RPG_INDEX_KINDS)
+        return sorted_range(g_sx.by_mp, g_sx.n_mp, min_mp, max_mp, g_sx.by_target[target], out, max);
+    int got = 0;
+    for (int i = sorted_lower(g_sx.by_mp, g_sx.n_mp, min_mp, 0);
+         i < g_sx.n_mp && g_sx.by_mp[i].key <= max_mp && got < max; ++i)
+        if (g_sx.target[g_sx.by_mp[i].id] == target) out[got++] = g_sx.by_mp[i].id;
+    return got;
+}
+
+/* ── 再構築 / 使用量 ───────────────────────────────────────*/
+void rpg_db_reindex(void) {
+    memset(&g_ix, 0, sizeof(g_ix));
+    memset(&g_sx, 0, sizeof(g_sx));
+    for (int id = 1; id <= RPG_MAX_ITEMS; ++id)  rpg_index_item_changed(id);
+    for (int id = 1; id <= RPG_MAX_SKILLS; ++id) rpg_index_skill_changed(id);
+}
+
+/* eng_session.c から (メモリ使用量) */
+size_t rpg_index_bytes(void) { return sizeof(g_ix) + sizeof(g_sx); }
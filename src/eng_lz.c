@@ -0,0 +1,122 @@
+/**
+ * src/eng_lz.c — セーブデータ用の軽量圧縮 (LZ4 ブロック形式相当)
+ *
+ * シーケンス = トークン (上位 4bit: リテラル長 / 下位 4bit: 一致長-4)
+ *            + [リテラル長の追加バイト] + リテラル + オフセット (16bit LE)
+ *            + [一致長の追加バイト]。
+ * 最後のシーケンスはリテラルのみ。展開側は入力/出力の境界を全て確かめる。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <string.h>
+
+#define LZ_HASH_BITS  12
+#define LZ_MIN_MATCH  4
+#define LZ_MAX_OFFSET 65535
+
+static uint32_t lz_read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t lz_hash(uint32_t v) { return (v * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+/* 15 以上の長さの残りを 255 区切りで書く */
+static uint8_t* lz_put_len(uint8_t* op, const uint8_t* oend, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (op >= oend) return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend) return NULL;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t* lz_put_seq(uint8_t* op, const uint8_t* oend,
+                           const uint8_t* lit, size_t lit_len, size_t off, size_t match_len) {
+    if (op >= oend) return NULL;
+    uint8_t* token = op++;
+    size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+    *token = (uint8_t)(((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15));
+    if (lit_len >= 15 && !(op = lz_put_len(op, oend, lit_len - 15))) return NULL;
+    if ((size_t)(oend - op) < lit_len) return NULL;
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (!match_len) return op;
+    if (oend - op < 2) return NULL;
+    *op++ = (uint8_t)(off & 0xFF);
+    *op++ = (uint8_t)(off >> 8);
+    if (ml >= 15 && !(op = lz_put_len(op, oend, ml - 15))) return NULL;
+    return op;
+}
+
+/* 圧縮後のバイト数を返す。cap に収まらなければ 0。 */
+size_t rpg_lz_compress(const void* src, size_t n, void* dst, size_t cap) {
+    const uint8_t* s = src;
+    uint8_t*       op = dst;
+    const uint8_t* oend = op + cap;
+    int32_t table[1 << LZ_HASH_BITS];
+    size_t ip = 0, anchor = 0;
+    memset(table, 0xFF, sizeof(table));
+    if (n > INT32_MAX) return 0;
+    while (n >= LZ_MIN_MATCH && ip <= n - LZ_MIN_MATCH) {
+        uint32_t v = lz_read32(s + ip);
+        uint32_t h = lz_hash(v);
+        int32_t  ref = table[h];
+        table[h] = (int32_t)ip;
+        if (ref < 0 || ip - (size_t)ref > LZ_MAX_OFFSET || lz_read32(s + ref) != v) { ip++; continue; }
+        size_t len = LZ_MIN_MATCH;
+        while (ip + len < n && s[ref + len] == s[ip + len]) len++;
+        op = lz_put_seq(op, oend, s + anchor, ip - anchor, ip - (size_t)ref, len);
+        if (!op) return 0;
+        ip += len;
+        anchor = ip;
+    }
+    op = lz_put_seq(op, oend, s + anchor, n - anchor, 0, 0);
+    return op ? (size_t)(op - (uint8_t*)dst) : 0;
+}
+
+/* 展開後のバイト数を返す。壊れた入力や cap 超過は (size_t)-1。 */
+size_t rpg_lz_decompress(const void* src, size_t n, void* dst, size_t cap) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = ip + n;
+    uint8_t*       out = dst;
+    size_t         op = 0;
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return (size_t)-1;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if ((size_t)(iend - ip) < lit || cap - op < lit) return (size_t)-1;
+        memcpy(out + op, ip, lit);
+        ip += lit; op += lit;
+        if (ip == iend) break;   /* 最後のシーケンス */
+
+        if (iend - ip < 2) return (size_t)-1;
+        size_t off = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t len = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return (size_t)-1;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (off == 0 || off > op || cap - op < len) return (size_t)-1;
+        const uint8_t* m = out + op - off;
+        if (off >= len) memcpy(out + op, m, len);
+        else for (size_t i = 0; i < len; ++i) out[op + i] = m[i];   /* 重なりあり */
+        op += len;
+    }
+    return op;
+}
@@ -0,0 +1,169 @@
+/**
+ * src/eng_odds.c — ダメージ分布と撃破確率
+ *
+ * 1 回の攻撃の分布は eng_formula.c で乱数項を列挙して求める。
+ * 撃破確率は「累積ダメージ d (0 ≤ d < HP) にいる確率」の配列に攻撃の
+ * 分布を畳み込み、HP 以上に達した分を撃破として吸収していく。
+ * 分布は同じ確率が並ぶ区間 (通常は 1 区間の一様分布) ごとに
+ * 累積和で畳み込むので、1 攻撃あたりの計算量は HP × 区間数。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 全結果の列挙 (eng_formula.c から) */
+bool rpg_damage_enumerate(const RPG_Actor* a, const RPG_Actor* t, int skill_id,
+                          void (*emit)(void* ctx, int dmg, double p), void* ctx);
+
+/* ── 1 回分の分布 ───────────────────────────────────────*/
+typedef struct { int lo, hi; RPG_DamagePMF* out; } PmfBuild;
+
+static void pmf_range(void* ctx, int dmg, double p) {
+    PmfBuild* b = ctx;
+    (void)p;
+    if (dmg < b->lo) b->lo = dmg;
+    if (dmg > b->hi) b->hi = dmg;
+}
+
+static void pmf_add(void* ctx, int dmg, double p) {
+    PmfBuild* b = ctx;
+    b->out->p[dmg - b->out->min] += p;
+}
+
+bool rpg_damage_pmf(const RPG_Actor* a, const RPG_Actor* t, int skill_id, RPG_DamagePMF* out) {
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    uint64_t tr = rpg_trace_begin();
+    /* 1 周目で範囲、2 周目で確率 */
+    PmfBuild b = { INT32_MAX, INT32_MIN, out };
+    bool ok = rpg_damage_enumerate(a, t, skill_id, pmf_range, &b) && b.lo <= b.hi;
+    if (ok) {
+        out->min = b.lo;
+        out->len = b.hi - b.lo + 1;
+        out->p   = calloc((size_t)out->len, sizeof(double));
+        ok = out->p && rpg_damage_enumerate(a, t, skill_id, pmf_add, &b);
+    }
+    if (!ok) rpg_damage_pmf_free(out);
+    rpg_trace_end("rpg_damage_pmf", tr);
+    return ok;
+}
+
+void rpg_damage_pmf_free(RPG_DamagePMF* pmf) {
+    if (!pmf) return;
+    free(pmf->p);
+    memset(pmf, 0, sizeof(*pmf));
+}
+
+double rpg_damage_pmf_at_least(const RPG_DamagePMF* pmf, int dmg) {
+    if (!pmf || !pmf->p) return 0;
+    double sum = 0;
+    int from = dmg - pmf->min;
+    for (int i = from < 0 ? 0 : from; i < pmf->len; ++i) sum += pmf->p[i];
+    return sum > 1 ? 1 : sum;
+}
+
+double rpg_damage_pmf_mean(const RPG_DamagePMF* pmf) {
+    if (!pmf || !pmf->p) return 0;
+    double m = 0;
+    for (int i = 0; i < pmf->len; ++i) m += pmf->p[i] * (pmf->min + i);
+    return m;
+}
+
+/* ── 畳み込み ───────────────────────────────────────────*/
+typedef struct {
+    int     hp;
+    double* cur;    /* cur[d] = 生存中で累積ダメージ d の確率 */
+    double* nxt;
+    double* sum;    /* sum[k] = cur[0..k) の合計 (hp+1 要素) */
+    double  dead;
+} KillState;
+
+static bool kill_init(KillState* k, int hp) {
+    memset(k, 0, sizeof(*k));
+    k->hp  = hp;
+    k->cur = calloc((size_t)hp, sizeof(double));
+    k->nxt = calloc((size_t)hp, sizeof(double));
+    k->sum = calloc((size_t)hp + 1, sizeof(double));
+    if (!k->cur || !k->nxt || !k->sum) return false;
+    k->cur[0] = 1;
+    return true;
+}
+
+static void kill_free(KillState* k) {
+    free(k->cur); free(k->nxt); free(k->sum);
+}
+
+static int clampi(int v, int lo, int hi) { return v < lo ? lo : v > hi ? hi : v; }
+
+/* 1 回攻撃を受けた後の状態へ進める */
+static void kill_hit(KillState* k, const RPG_DamagePMF* h) {
+    int hp = k->hp;
+    k->sum[0] = 0;
+    for (int d = 0; d < hp; ++d) k->sum[d + 1] = k->sum[d] + k->cur[d];
+    memset(k->nxt, 0, sizeof(double) * (size_t)hp);
+    for (int i = 0; i < h->len; ) {
+        double q = h->p[i];
+        int j = i + 1;
+        while (j < h->len && fabs(h->p[j] - q) <= 1e-12 * q) j++;
+        if (q > 0) {
+            /* ダメージ lo..hi を確率 q ずつ: nxt[x] += q * Σ cur[x-hi .. x-lo] */
+            int lo = h->min + i, hi = h->min + j - 1;
+            for (int x = lo < 0 ? 0 : lo; x < hp; ++x) {
+                int top = clampi(x - lo + 1, 0, hp), bot = clampi(x - hi, 0, hp);
+                if (top > bot) k->nxt[x] += q * (k->sum[top] - k->sum[bot]);
+            }
+        }
+        i = j;
+    }
+    double alive = 0;
+    for (int d = 0; d < hp; ++d) alive += k->nxt[d];
+    double killed = k->sum[hp] - alive;
+    if (killed > 0) k->dead += killed;
+    if (k->dead > 1) k->dead = 1;
+    double* t = k->cur; k->cur = k->nxt; k->nxt = t;
+}
+
+double rpg_kill_probability(const RPG_DamagePMF* hit, int hp, int hits) {
+    if (hp <= 0) return 1;
+    if (!hit || !hit->p || hits <= 0) return 0;
+    KillState k;
+    double p = 0;
+    if (kill_init(&k, hp)) {
+        for (int i = 0; i < hits; ++i) kill_hit(&k, hit);
+        p = k.dead;
+    }
+    kill_free(&k);
+    return p;
+}
+
+int rpg_kill_curve(const int* attackers, const int* skills, int n,
+                   int target_id, int turns, double* out) {
+    const RPG_Actor* t = rpg_actor_peek(target_id);
+    if (!attackers || !out || !t || turns <= 0 || n < 0) return 0;
+    if (t->hp <= 0 || !t->alive) {
+        for (int i = 0; i < turns; ++i) out[i] = 1;
+        return turns;
+    }
+    uint64_t tr = rpg_trace_begin();
+    RPG_DamagePMF* hits = calloc((size_t)(n ? n : 1), sizeof(*hits));
+    KillState k = { 0 };
+    bool ok = hits && kill_init(&k, t->hp);
+    int m = 0;
+    for (int i = 0; ok && i < n; ++i) {
+        const RPG_Actor* a = rpg_actor_peek(attackers[i]);
+        if (!a || !a->alive) continue;
+        ok = rpg_damage_pmf(a, t, skills ? skills[i] : 0, &hits[m++]);
+    }
+    for (int turn = 0; ok && turn < turns; ++turn) {
+        for (int i = 0; i < m; ++i) kill_hit(&k, &hits[i]);
+        out[turn] = k.dead;
+    }
+    if (hits) for (int i = 0; i < m; ++i) rpg_damage_pmf_free(&hits[i]);
+    free(hits);
+    kill_free(&k);
+    rpg_trace_end("rpg_kill_curve", tr);
+    return ok ? turns : 0;
+}
@@ -0,0 +1,210 @@
+/**
+ * src/eng_prof.c — 関数ごとの呼び出し回数/レイテンシ計測
+ *
+ * 計測値は生のティック (x86-64 では rdtsc、それ以外は単調時計の ns) で
+ * 記録し、log2 バケットのヒストグラムに積む。ティック→ns の換算は
+ * リセット時と出力時の 2 点で時計と突き合わせて求める。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(_WIN32)
+#  include <windows.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <x86intrin.h>
+#  endif
+#  define PROF_USE_TSC 1
+#endif
+
+typedef struct {
+    const char* name;
+    uint64_t calls;
+    uint64_t total, min, max;   /* ティック */
+    uint64_t hist[RPG_PROF_BUCKETS];
+} ProfEntry;
+
+static ProfEntry* g_prof = NULL;
+static int        g_prof_count = 0, g_prof_cap = 0;
+static bool       g_prof_on = false;
+static uint64_t   g_ref_ticks = 0, g_ref_ns = 0;   /* 換算用の基準点 */
+
+/* ── 時計 ───────────────────────────────────────────────*/
+uint64_t rpg_prof_clock_ns(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (uint64_t)((double)c.QuadPart * 1e9 / (double)f.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t rpg_prof_now(void) {
+#ifdef PROF_USE_TSC
+    return __rdtsc();
+#else
+    return rpg_prof_clock_ns();
+#endif
+}
+
+/* 1 ティックあたりの ns */
+static double ns_per_tick(void) {
+#ifdef PROF_USE_TSC
+    uint64_t t = rpg_prof_now(), n = rpg_prof_clock_ns();
+    if (t <= g_ref_ticks || n <= g_ref_ns) return 1.0;
+    return (double)(n - g_ref_ns) / (double)(t - g_ref_ticks);
+#else
+    return 1.0;
+#endif
+}
+
+/* ── 登録/記録 ──────────────────────────────────────────*/
+int rpg_prof_register(const char* name) {
+    if (g_prof_count >= g_prof_cap) {
+        int cap = g_prof_cap ? g_prof_cap * 2 : 128;
+        ProfEntry* p = realloc(g_prof, sizeof(*p) * (size_t)cap);
+        if (!p) return -1;
+        g_prof = p; g_prof_cap = cap;
+    }
+    ProfEntry* e = &g_prof[g_prof_count];
+    memset(e, 0, sizeof(*e));
+    e->name = name;
+    e->min  = UINT64_MAX;
+    return g_prof_count++;
+}
+
+void rpg_prof_enable(bool on) {
+    if (on && !g_prof_on && g_ref_ns == 0) {
+        g_ref_ticks = rpg_prof_now();
+        g_ref_ns    = rpg_prof_clock_ns();
+    }
+    g_prof_on = on;
+}
+bool rpg_prof_enabled(void) { return g_prof_on; }
+
+void rpg_prof_record(int id, uint64_t ticks) {
+    if (id < 0 || id >= g_prof_count) return;
+    ProfEntry* e = &g_prof[id];
+    e->calls++;
+    e->total += ticks;
+    if (ticks < e->min) e->min = ticks;
+    if (ticks > e->max) e->max = ticks;
+    int b = 0;
+    while (b < RPG_PROF_BUCKETS - 1 && (ticks >> (b + 1)) != 0) b++;
+    e->hist[b]++;
+}
+
+void rpg_prof_reset(void) {
+    for (int i = 0; i < g_prof_count; ++i) {
+        ProfEntry* e = &g_prof[i];
+        const char* name = e->name;
+        memset(e, 0, sizeof(*e));
+        e->name = name;
+        e->min  = UINT64_MAX;
+    }
+    g_ref_ticks = rpg_prof_now();
+    g_ref_ns    = rpg_prof_clock_ns();
+}
+
+/* ── 集計 ───────────────────────────────────────────────*/
+/* バケット b の上限 (ティック) */
+static uint64_t bucket_hi(int b) { return (2ull << b) - 1; }
+
+/* ヒストグラムから p (0..1) 分位点の上限ティックを求める */
+static uint64_t percentile(const ProfEntry* e, double p) {
+    uint64_t want = (uint64_t)((double)e->calls * p + 0.5), acc = 0;
+    if (want == 0) want = 1;
+    for (int b = 0; b < RPG_PROF_BUCKETS; ++b) {
+        acc += e->hist[b];
+        if (acc >= want) return bucket_hi(b) < e->max ? bucket_hi(b) : e->max;
+    }
+    return e->max;
+}
+
+static int cmp_total_desc(const void* a, const void* b) {
+    const ProfEntry* x = *(const ProfEntry* const*)a;
+    const ProfEntry* y = *(const ProfEntry* const*)b;
+    return x->total < y->total ? 1 : x->total > y->total ? -1 : 0;
+}
+
+/* 呼び出しのあった項目を合計時間の降順で返す (呼び出し側で free) */
+static const ProfEntry** sorted_entries(int* out_n) {
+    const ProfEntry** v = malloc(sizeof(*v) * (size_t)(g_prof_count ? g_prof_count : 1));
+    int n = 0;
+    if (!v) { *out_n = 0; return NULL; }
+    for (int i = 0; i < g_prof_count; ++i)
+        if (g_prof[i].calls) v[n++] = &g_prof[i];
+    qsort(v, (size_t)n, sizeof(*v), cmp_total_desc);
+    *out_n = n;
+    return v;
+}
+
+void rpg_prof_print(void) {
+    double k = ns_per_tick();
+    int n;
+    const ProfEntry** v = sorted_entries(&n);
+    printf("[RPG] %-28s %10s %12s %10s %10s %10s %10s\n",
+           "function", "calls", "total_ms", "mean_ns", "p50_ns", "p99_ns", "max_ns");
+    for (int i = 0; i < n; ++i) {
+        const ProfEntry* e = v[i];
+        printf("[RPG] %-28s %10llu %12.3f %10.0f %10.0f %10.0f %10.0f\n", e->name,
+               (unsigned long long)e->calls, (double)e->total * k / 1e6,
+               (double)e->total * k / (double)e->calls,
+               (double)percentile(e, 0.50) * k, (double)percentile(e, 0.99) * k,
+               (double)e->max * k);
+    }
+    free(v);
+}
+
+static void json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') { fputc('\\', f); fputc(ch, f); }
+        else if (ch < 0x20)          fprintf(f, "\\u%04x", ch);
+        else                         fputc(ch, f);
+    }
+    fputc('"', f);
+}
+
+bool rpg_prof_write_json(const char* path) {
+    FILE* f = path ? fopen(path, "w") : NULL;
+    if (!f) { fprintf(stderr, "[eng_rpg] プロファイル出力失敗: %s\n", path ? path : ""); return false; }
+    double k = ns_per_tick();
+    int n;
+    const ProfEntry** v = sorted_entries(&n);
+    fprintf(f, "{\"unit\":\"ns\",\"functions\":[");
+    for (int i = 0; i < n; ++i) {
+        const ProfEntry* e = v[i];
+        fprintf(f, "%s\n{\"name\":", i ? "," : "");
+        json_string(f, e->name);
+        fprintf(f, ",\"calls\":%llu,\"total_ns\":%.0f,\"mean_ns\":%.1f,"
+                   "\"min_ns\":%.0f,\"p50_ns\":%.0f,\"p99_ns\":%.0f,\"max_ns\":%.0f,\"histogram\":[",
+                (unsigned long long)e->calls, (double)e->total * k,
+                (double)e->total * k / (double)e->calls, (double)e->min * k,
+                (double)percentile(e, 0.50) * k, (double)percentile(e, 0.99) * k,
+                (double)e->max * k);
+        bool first = true;
+        for (int b = 0; b < RPG_PROF_BUCKETS; ++b) {
+            if (!e->hist[b]) continue;
+            fprintf(f, "%s{\"le_ns\":%.0f,\"count\":%llu}", first ? "" : ",",
+                    (double)bucket_hi(b) * k, (unsigned long long)e->hist[b]);
+            first = false;
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n]}\n");
+    free(v);
+    return fclose(f) == 0;
+}
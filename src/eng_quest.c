@@ -0,0 +1,571 @@
+/**
+ * src/eng_quest.c — クエストの出現/完了条件と依存グラフ
+ *
+ * 条件式は定義時に逆ポーランドの命令列へコンパイルし、式が参照する
+ * 入力 (フラグ/変数/アイテム数/パーティ在籍/他クエストの状態) を
+ * 入力表に登録して「入力 → それを参照するクエスト」の辺を張る。
+ *
+ * 各モジュールの書き込み口が rpg_quest_*_changed で入力を汚し、
+ * rpg_quest_update は汚れた入力の値を読み直して、実際に変わった入力に
+ * つながるクエストの条件だけを評価する。クエストの状態が変わると
+ * その状態を参照する入力も汚れるので、連鎖は同じ update の中で収まる。
+ *
+ *   値    : 数値 / flag:キー (0/1) / var:キー / item:id (所持数)
+ *           party:id (在籍なら 1) / quest:id (状態 0〜3) / done:id (完了なら 1)
+ *   演算  : ! && || == != < <= > >= + - 括弧
+ *
+ * 状態は LOCKED → AVAILABLE (出現条件が真) → ACTIVE (rpg_quest_start) →
+ * COMPLETED (完了条件が真、または rpg_quest_complete)。出現条件が偽に
+ * 戻った AVAILABLE は LOCKED に戻る。状態はフラグ/変数と同じく
+ * セーブ/スナップショットの対象。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 差分の汚れ印 (eng_delta.c から) */
+void rpg_delta_touch(const void* p, size_t size);
+
+#define QUEST_MAX_CODE   64     /* 1 つの条件の命令数 */
+#define QUEST_MAX_STACK  32
+#define QUEST_MAX_INPUTS 2048
+#define QUEST_MAX_EDGES  8192
+#define QUEST_HASH       4096   /* 入力表のハッシュ (2 の冪) */
+
+/* ── 入力 ───────────────────────────────────────────────*/
+enum { IN_FLAG, IN_VAR, IN_ITEM, IN_PARTY, IN_QUEST };
+
+typedef struct {
+    uint8_t kind;
+    bool    dirty;
+    int     id;                  /* ITEM/PARTY/QUEST */
+    char    key[RPG_KEY_LEN];    /* FLAG/VAR */
+    double  value;
+    int     edges;               /* g_edges の先頭 (-1 = なし) */
+} QuestInput;
+
+typedef struct { int quest, next; } QuestEdge;
+
+/* ── 条件 ───────────────────────────────────────────────*/
+enum {
+    Q_CONST, Q_INPUT, Q_NOT, Q_NEG,
+    Q_AND, Q_OR, Q_EQ, Q_NE, Q_LT, Q_LE, Q_GT, Q_GE, Q_ADD, Q_SUB,
+};
+
+typedef struct {
+    uint8_t op;
+    int     arg;      /* Q_INPUT: 入力番号 */
+    double  val;      /* Q_CONST */
+} QuestIns;
+
+typedef struct {
+    QuestIns code[QUEST_MAX_CODE];
+    int      n;       /* 0 = 条件なし */
+} QuestCond;
+
+typedef struct {
+    bool      used;
+    bool      dirty;
+    char      name[64];
+    QuestCond avail, done;
+} Quest;
+
+static Quest      g_quests[RPG_MAX_QUESTS + 1];   /* [0] 未使用 */
+static uint8_t    g_state[RPG_MAX_QUESTS + 1];    /* RPG_QuestState (セーブ対象) */
+static int        g_quest_count = 0;
+static QuestInput g_inputs[QUEST_MAX_INPUTS];
+static int        g_input_count = 0;
+static int16_t    g_hash[QUEST_HASH];             /* 入力番号 + 1 (0 = 空き) */
+static QuestEdge  g_edges[QUEST_MAX_EDGES];
+static int        g_edge_count = 0;
+static bool       g_graph_dirty = false;          /* 定義が変わったので辺を張り直す */
+
+static int        g_dirty_in[QUEST_MAX_INPUTS];
+static int        g_dirty_in_n = 0;
+static int        g_dirty_q[RPG_MAX_QUESTS];
+static int        g_dirty_q_n = 0;
+static uint64_t   g_newly[4][(RPG_MAX_QUESTS + 64) / 64];
+static uint64_t   g_evals = 0;
+
+/* ── 入力表 ─────────────────────────────────────────────*/
+static uint32_t input_hash(int kind, int id, const char* key) {
+    uint32_t h = 2166136261u ^ (uint32_t)kind;
+    h = (h ^ (uint32_t)id) * 16777619u;
+    if (key) for (; *key; ++key) h = (h ^ (uint8_t)*key) * 16777619u;
+    return h;
+}
+
+static bool input_is(const QuestInput* in, int kind, int id, const char* key) {
+    return in->kind == kind && in->id == id && strcmp(in->key, key ? key : "") == 0;
+}
+
+static int input_find(int kind, int id, const char* key) {
+    for (uint32_t h = input_hash(kind, id, key);; ++h) {
+        int slot = g_hash[h & (QUEST_HASH - 1)];
+        if (!slot) return -1;
+        if (input_is(&g_inputs[slot - 1], kind, id, key)) return slot - 1;
+    }
+}
+
+static void input_dirty(int i) {
+    if (i < 0 || g_inputs[i].dirty) return;
+    g_inputs[i].dirty = true;
+    g_dirty_in[g_dirty_in_n++] = i;
+}
+
+static int input_intern(int kind, int id, const char* key) {
+    int i = input_find(kind, id, key);
+    if (i >= 0) return i;
+    if (g_input_count >= QUEST_MAX_INPUTS) return -1;
+    i = g_input_count++;
+    QuestInput* in = &g_inputs[i];
+    memset(in, 0, sizeof(*in));
+    in->kind  = (uint8_t)kind;
+    in->id    = id;
+    in->edges = -1;
+    if (key) {
+        size_t n = strlen(key);
+        memcpy(in->key, key, n < RPG_KEY_LEN ? n : RPG_KEY_LEN - 1);
+    }
+    uint32_t h = input_hash(kind, id, key);
+    while (g_hash[h & (QUEST_HASH - 1)]) ++h;
+    g_hash[h & (QUEST_HASH - 1)] = (int16_t)(i + 1);
+    input_dirty(i);   /* 値は次の update で読む */
+    return i;
+}
+
+static double input_read(const QuestInput* in) {
+    switch (in->kind) {
+    case IN_FLAG:  return rpg_flag_get(in->key) ? 1.0 : 0.0;
+    case IN_VAR:   return rpg_var_get(in->key);
+    case IN_ITEM:  return rpg_inventory_count(in->id);
+    case IN_PARTY: return rpg_party_has(in->id) ? 1.0 : 0.0;
+    case IN_QUEST: return (in->id >= 1 && in->id <= RPG_MAX_QUESTS) ? g_state[in->id] : 0.0;
+    }
+    return 0.0;
+}
+
+/* ── 条件の構文解析 ─────────────────────────────────────*/
+typedef struct {
+    const char* src;
+    const char* p;
+    QuestCond*  c;
+    int         depth;
+    char*       err;
+    size_t      err_len;
+    bool        failed;
+} QuestParser;
+
+static bool parse_fail(QuestParser* ps, const char* msg) {
+    if (!ps->failed && ps->err && ps->err_len)
+        snprintf(ps->err, ps->err_len, "%d 文字目: %s", (int)(ps->p - ps->src) + 1, msg);
+    ps->failed = true;
+    return false;
+}
+
+static bool emit(QuestParser* ps, int op, int arg, double val) {
+    if (ps->c->n >= QUEST_MAX_CODE) return parse_fail(ps, "条件が長すぎる");
+    ps->c->code[ps->c->n++] = (QuestIns){ (uint8_t)op, arg, val };
+    return true;
+}
+
+static void skip_ws(QuestParser* ps) { while (isspace((unsigned char)*ps->p)) ps->p++; }
+
+static bool accept(QuestParser* ps, const char* tok) {
+    skip_ws(ps);
+    size_t n = strlen(tok);
+    if (strncmp(ps->p, tok, n) != 0) return false;
+    ps->p += n;
+    return true;
+}
+
+/* キーは英数字/_/. と UTF-8 の非 ASCII 文字 ('-' は減算と紛らわしいので不可) */
+static bool key_char(char ch) {
+    unsigned char c = (unsigned char)ch;
+    return isalnum(c) || c == '_' || c == '.' || c >= 0x80;
+}
+
+static bool parse_or(QuestParser* ps);
+
+static bool parse_input(QuestParser* ps) {
+    static const struct { const char* name; int kind; bool numeric; } k_inputs[] = {
+        { "flag", IN_FLAG, false }, { "var", IN_VAR, false }, { "item", IN_ITEM, true },
+        { "party", IN_PARTY, true }, { "quest", IN_QUEST, true }, { "done", IN_QUEST, true },
+    };
+    const char* s = ps->p;
+    while (isalpha((unsigned char)*ps->p)) ps->p++;
+    size_t len = (size_t)(ps->p - s);
+    for (size_t k = 0; k < sizeof(k_inputs) / sizeof(k_inputs[0]); ++k) {
+        if (strlen(k_inputs[k].name) != len || strncmp(s, k_inputs[k].name, len) != 0) continue;
+        if (*ps->p != ':') return parse_fail(ps, "':' が必要");
+        ps->p++;
+        const char* ks = ps->p;
+        while (key_char(*ps->p)) ps->p++;
+        size_t klen = (size_t)(ps->p - ks);
+        if (klen == 0) return parse_fail(ps, "キーが必要");
+        if (klen >= RPG_KEY_LEN) return parse_fail(ps, "キーが長すぎる");
+        char key[RPG_KEY_LEN];
+        memcpy(key, ks, klen);
+        key[klen] = '\0';
+        int id = 0;
+        if (k_inputs[k].numeric) {
+            char* end;
+            long v = strtol(key, &end, 10);
+            if (*end || v < 0 || v > 1000000) { ps->p = ks; return parse_fail(ps, "番号が必要"); }
+            id = (int)v;
+            if (k_inputs[k].kind == IN_QUEST && (id < 1 || id > RPG_MAX_QUESTS)) {
+                ps->p = ks;
+                return parse_fail(ps, "クエスト番号が範囲外");
+            }
+        }
+        int in = input_intern(k_inputs[k].kind, id, k_inputs[k].numeric ? NULL : key);
+        if (in < 0) return parse_fail(ps, "条件の入力が多すぎる");
+        if (!emit(ps, Q_INPUT, in, 0)) return false;
+        if (strcmp(k_inputs[k].name, "done") == 0)
+            return emit(ps, Q_CONST, 0, RPG_QUEST_COMPLETED) && emit(ps, Q_EQ, 0, 0);
+        return true;
+    }
+    ps->p = s;
+    return parse_fail(ps, "未知の入力 (flag:/var:/item:/party:/quest:/done:)");
+}
+
+static bool parse_primary(QuestParser* ps) {
+    skip_ws(ps);
+    if (accept(ps, "(")) {
+        if (!parse_or(ps)) return false;
+        return accept(ps, ")") || parse_fail(ps, "')' が必要");
+    }
+    if (isdigit((unsigned char)*ps->p) || *ps->p == '.') {
+        char* end;
+        double v = strtod(ps->p, &end);
+        ps->p = end;
+        return emit(ps, Q_CONST, 0, v);
+    }
+    if (isalpha((unsigned char)*ps->p)) return parse_input(ps);
+    return parse_fail(ps, *ps->p ? "値が必要" : "条件が途中で終わっている");
+}
+
+static bool parse_unary(QuestParser* ps) {
+    if (++ps->depth > QUEST_MAX_CODE) return parse_fail(ps, "条件の入れ子が深すぎる");
+    bool ok;
+    if (accept(ps, "!"))      ok = parse_unary(ps) && emit(ps, Q_NOT, 0, 0);
+    else if (accept(ps, "-")) ok = parse_unary(ps) && emit(ps, Q_NEG, 0, 0);
+    else                      ok = parse_primary(ps);
+    ps->depth--;
+    return ok;
+}
+
+static bool parse_sum(QuestParser* ps) {
+    if (!parse_unary(ps)) return false;
+    for (;;) {
+        int op = accept(ps, "+") ? Q_ADD : accept(ps, "-") ? Q_SUB : -1;
+        if (op < 0) return true;
+        if (!parse_unary(ps) || !emit(ps, op, 0, 0)) return false;
+    }
+}
+
+static bool parse_cmp(QuestParser* ps) {
+    if (!parse_sum(ps)) return false;
+    /* 2 文字の演算子を先に試す */
+    int op = accept(ps, "==") ? Q_EQ : accept(ps, "!=") ? Q_NE :
+             accept(ps, "<=") ? Q_LE : accept(ps, ">=") ? Q_GE :
+             accept(ps, "<")  ? Q_LT : accept(ps, ">")  ? Q_GT : -1;
+    if (op < 0) return true;
+    return parse_sum(ps) && emit(ps, op, 0, 0);
+}
+
+static bool parse_and(QuestParser* ps) {
+    if (!parse_cmp(ps)) return false;
+    while (accept(ps, "&&"))
+        if (!parse_cmp(ps) || !emit(ps, Q_AND, 0, 0)) return false;
+    return true;
+}
+
+static bool parse_or(QuestParser* ps) {
+    if (!parse_and(ps)) return false;
+    while (accept(ps, "||"))
+        if (!parse_and(ps) || !emit(ps, Q_OR, 0, 0)) return false;
+    return true;
+}
+
+/* スタックの深さを確かめる (入れ子の深い式は QUEST_MAX_STACK を超えうる) */
+static bool stack_ok(const QuestCond* c) {
+    int sp = 0;
+    for (int i = 0; i < c->n; ++i) {
+        int op = c->code[i].op;
+        sp += (op == Q_CONST || op == Q_INPUT) ? 1 : (op == Q_NOT || op == Q_NEG) ? 0 : -1;
+        if (sp > QUEST_MAX_STACK) return false;
+    }
+    return true;
+}
+
+static bool compile(const char* src, QuestCond* c, char* err, size_t err_len) {
+    c->n = 0;
+    if (!src) return true;
+    QuestParser ps = { src, src, c, 0, err, err_len, false };
+    skip_ws(&ps);
+    if (!*ps.p) return true;   /* 空 = 条件なし */
+    if (!parse_or(&ps)) return false;
+    skip_ws(&ps);
+    if (*ps.p) return parse_fail(&ps, "余分な文字");
+    if (!stack_ok(c)) return parse_fail(&ps, "入れ子が深すぎる");
+    return true;
+}
+
+/* ── 評価 ───────────────────────────────────────────────*/
+static bool eval(const QuestCond* c) {
+    double st[QUEST_MAX_STACK];
+    int sp = 0;
+    g_evals++;
+    if (c->n == 0) return true;   /* 条件なし */
+    for (int i = 0; i < c->n; ++i) {
+        const QuestIns* in = &c->code[i];
+        switch (in->op) {
+        case Q_CONST: st[sp++] = in->val; continue;
+        case Q_INPUT: st[sp++] = g_inputs[in->arg].value; continue;
+        case Q_NOT:   st[sp - 1] = st[sp - 1] == 0.0; continue;
+        case Q_NEG:   st[sp - 1] = -st[sp - 1]; continue;
+        default: break;
+        }
+        double y = st[--sp], x = st[sp - 1], r = 0.0;
+        switch (in->op) {
+        case Q_AND: r = x != 0.0 && y != 0.0; break;
+        case Q_OR:  r = x != 0.0 || y != 0.0; break;
+        case Q_EQ:  r = x == y; break;
+        case Q_NE:  r = x != y; break;
+        case Q_LT:  r = x <  y; break;
+        case Q_LE:  r = x <= y; break;
+        case Q_GT:  r = x >  y; break;
+        case Q_GE:  r = x >= y; break;
+        case Q_ADD: r = x + y;  break;
+        case Q_SUB: r = x - y;  break;
+        }
+        st[sp - 1] = r;
+    }
+    return sp > 0 && st[sp - 1] != 0.0;
+}
+
+/* ── 依存グラフ ─────────────────────────────────────────*/
+static void quest_dirty(int id) {
+    if (g_quests[id].dirty) return;
+    g_quests[id].dirty = true;
+    g_dirty_q[g_dirty_q_n++] = id;
+}
+
+static void link_cond(int quest, const QuestCond* c) {
+    for (int i = 0; i < c->n; ++i) {
+        if (c->code[i].op != Q_INPUT) continue;
+        QuestInput* in = &g_inputs[c->code[i].arg];
+        if (in->edges >= 0 && g_edges[in->edges].quest == quest) continue;   /* 直前に張った辺 */
+        if (g_edge_count >= QUEST_MAX_EDGES) {
+            fprintf(stderr, "[eng_rpg] クエストの依存が多すぎる\n");
+            return;
+        }
+        g_edges[g_edge_count] = (QuestEdge){ quest, in->edges };
+        in->edges = g_edge_count++;
+    }
+}
+
+static void rebuild_edges(void) {
+    g_edge_count = 0;
+    for (int i = 0; i < g_input_count; ++i) g_inputs[i].edges = -1;
+    for (int q = 1; q <= RPG_MAX_QUESTS; ++q) {
+        if (!g_quests[q].used) continue;
+        link_cond(q, &g_quests[q].avail);
+        link_cond(q, &g_quests[q].done);
+    }
+    g_graph_dirty = false;
+}
+
+static void set_state(int id, RPG_QuestState s) {
+    if (g_state[id] == s) return;
+    g_state[id] = (uint8_t)s;
+    rpg_delta_touch(&g_state[id], sizeof(g_state[id]));
+    g_newly[s][id / 64] |= 1ULL << (id % 64);
+    input_dirty(input_find(IN_QUEST, id, NULL));
+    quest_dirty(id);   /* ACTIVE になった直後に完了条件を見る */
+}
+
+static bool step(int id) {
+    Quest* q = &g_quests[id];
+    RPG_QuestState s = (RPG_QuestState)g_state[id];
+    switch (s) {
+    case RPG_QUEST_LOCKED:
+        if (eval(&q->avail)) { set_state(id, RPG_QUEST_AVAILABLE); return true; }
+        break;
+    case RPG_QUEST_AVAILABLE:
+        if (q->avail.n && !eval(&q->avail)) { set_state(id, RPG_QUEST_LOCKED); return true; }
+        break;
+    case RPG_QUEST_ACTIVE:
+        if (q->done.n && eval(&q->done)) { set_state(id, RPG_QUEST_COMPLETED); return true; }
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+int rpg_quest_update(void) {
+    if (!g_quest_count) return 0;
+    uint64_t tr = rpg_trace_begin();
+    if (g_graph_dirty) rebuild_edges();
+    int changes = 0, steps = 0;
+    while (g_dirty_in_n || g_dirty_q_n) {
+        while (g_dirty_in_n) {
+            QuestInput* in = &g_inputs[g_dirty_in[--g_dirty_in_n]];
+            in->dirty = false;
+            double v = input_read(in);
+            if (v == in->value) continue;
+            in->value = v;
+            for (int e = in->edges; e >= 0; e = g_edges[e].next) quest_dirty(g_edges[e].quest);
+        }
+        if (g_dirty_q_n) {
+            int id = g_dirty_q[--g_dirty_q_n];
+            g_quests[id].dirty = false;
+            if (g_quests[id].used && step(id)) changes++;
+            if (++steps > RPG_MAX_QUESTS * 8) {
+                fprintf(stderr, "[eng_rpg] クエスト条件が循環している (クエスト %d)\n", id);
+                break;
+            }
+        }
+    }
+    rpg_trace_end("rpg_quest_update", tr);
+    return changes;
+}
+
+/* ── 書き込み口から (eng_save.c / eng_db.c / eng_extra.c) ─*/
+void rpg_quest_flag_changed(const char* key) {
+    if (g_quest_count) input_dirty(input_find(IN_FLAG, 0, key));
+}
+void rpg_quest_var_changed(const char* key) {
+    if (g_quest_count) input_dirty(input_find(IN_VAR, 0, key));
+}
+/* item_id = 0 はインベントリ全体 */
+void rpg_quest_item_changed(int item_id) {
+    if (!g_quest_count) return;
+    if (item_id) { input_dirty(input_find(IN_ITEM, item_id, NULL)); return; }
+    for (int i = 0; i < g_input_count; ++i)
+        if (g_inputs[i].kind == IN_ITEM) input_dirty(i);
+}
+/* actor_id = 0 はパーティ全体 */
+void rpg_quest_party_changed(int actor_id) {
+    if (!g_quest_count) return;
+    if (actor_id) { input_dirty(input_find(IN_PARTY, actor_id, NULL)); return; }
+    for (int i = 0; i < g_input_count; ++i)
+        if (g_inputs[i].kind == IN_PARTY) input_dirty(i);
+}
+/* ロード/復元などで一括して書き換わった */
+void rpg_quest_invalidate(void) {
+    if (!g_quest_count) return;
+    for (int i = 0; i < g_input_count; ++i) input_dirty(i);
+    for (int q = 1; q <= RPG_MAX_QUESTS; ++q)
+        if (g_quests[q].used) quest_dirty(q);
+}
+
+/* セッション退避用: LOCKED 以外のクエストを列挙する (eng_session.c から) */
+int rpg_quest_states_get(uint16_t* ids, uint8_t* states, int max) {
+    int n = 0;
+    for (int q = 1; q <= RPG_MAX_QUESTS; ++q) {
+        if (g_state[q] == RPG_QUEST_LOCKED) continue;
+        if (n < max) { ids[n] = (uint16_t)q; states[n] = g_state[q]; }
+        n++;
+    }
+    return n;
+}
+/* セッション展開用の一括復元 (eng_session.c から)。中身が変わったときだけ
+ * 全体を汚し、次の rpg_quest_update で評価し直す */
+void rpg_quest_states_restore(const uint16_t* ids, const uint8_t* states, int n) {
+    uint8_t next[RPG_MAX_QUESTS + 1] = { 0 };
+    for (int i = 0; i < n; ++i)
+        if (ids[i] >= 1 && ids[i] <= RPG_MAX_QUESTS && states[i] <= RPG_QUEST_COMPLETED)
+            next[ids[i]] = states[i];
+    if (memcmp(next, g_state, sizeof(g_state)) == 0) return;
+    memcpy(g_state, next, sizeof(g_state));
+    rpg_delta_touch(g_state, sizeof(g_state));
+    rpg_quest_invalidate();
+}
+
+/* セーブ/スナップショット対象の状態 (eng_save.c から) */
+void rpg_quest_state_regions(void (*add)(const char* tag, void* p, size_t size)) {
+    add("QUST", g_state, sizeof(g_state));
+}
+
+/* ── 公開 API ───────────────────────────────────────────*/
+bool rpg_quest_define(int id, const char* name, const char* available_if, const char* complete_if) {
+    if (id < 1 || id > RPG_MAX_QUESTS) return false;
+    Quest tmp = { .used = true };
+    char err[96] = "";
+    const char* bad = NULL;
+    if (!compile(available_if, &tmp.avail, err, sizeof(err)))     bad = available_if;
+    else if (!compile(complete_if, &tmp.done, err, sizeof(err))) bad = complete_if;
+    if (bad) {
+        fprintf(stderr, "[eng_rpg] クエスト条件エラー (%d: %s): %s\n", id, bad, err);
+        return false;
+    }
+    if (name) strncpy(tmp.name, name, sizeof(tmp.name) - 1);
+    if (!g_quests[id].used) g_quest_count++;
+    bool queued = g_quests[id].dirty;
+    g_quests[id] = tmp;
+    g_quests[id].dirty = queued;
+    g_graph_dirty = true;
+    quest_dirty(id);
+    return true;
+}
+
+void rpg_quest_clear(void) {
+    memset(g_quests, 0, sizeof(g_quests));
+    memset(g_state,  0, sizeof(g_state));
+    rpg_delta_touch(g_state, sizeof(g_state));
+    memset(g_hash,   0, sizeof(g_hash));
+    memset(g_newly,  0, sizeof(g_newly));
+    g_quest_count = g_input_count = g_edge_count = 0;
+    g_dirty_in_n = g_dirty_q_n = 0;
+    g_graph_dirty = false;
+}
+
+RPG_QuestState rpg_quest_state(int id) {
+    return (id >= 1 && id <= RPG_MAX_QUESTS) ? (RPG_QuestState)g_state[id] : RPG_QUEST_LOCKED;
+}
+
+const char* rpg_quest_name(int id) {
+    return (id >= 1 && id <= RPG_MAX_QUESTS && g_quests[id].used) ? g_quests[id].name : "";
+}
+
+bool rpg_quest_start(int id) {
+    if (id < 1 || id > RPG_MAX_QUESTS || !g_quests[id].used) return false;
+    rpg_quest_update();
+    if (g_state[id] != RPG_QUEST_AVAILABLE) return false;
+    set_state(id, RPG_QUEST_ACTIVE);
+    return true;
+}
+
+bool rpg_quest_complete(int id) {
+    if (id < 1 || id > RPG_MAX_QUESTS || !g_quests[id].used) return false;
+    if (g_state[id] != RPG_QUEST_ACTIVE && g_state[id] != RPG_QUEST_AVAILABLE) return false;
+    set_state(id, RPG_QUEST_COMPLETED);
+    return true;
+}
+
+int rpg_quest_newly(RPG_QuestState state, int* out, int max) {
+    if ((unsigned)state > RPG_QUEST_COMPLETED || !out || max <= 0) return 0;
+    rpg_quest_update();
+    uint64_t* bits = g_newly[state];
+    int n = 0;
+    for (int w = 0; w < (RPG_MAX_QUESTS + 64) / 64; ++w) {
+        while (bits[w] && n < max) {
+            out[n++] = w * 64 + __builtin_ctzll(bits[w]);
+            bits[w] &= bits[w] - 1;
+        }
+    }
+    return n;
+}
+
+uint64_t rpg_quest_evaluations(void) { return g_evals; }
+
+size_t rpg_quest_bytes(void) {
+    return sizeof(g_quests) + sizeof(g_inputs) + sizeof(g_edges) + sizeof(g_hash);
+}
@@ -2,7 +2,11 @@
  * src/eng_save.c — セーブ/ロード + フラグ/変数管理
  *
  * セーブデータは ~/.hajimu/saves/save_{slot}.dat に保存する。
- * 簡易バイナリ形式: 固定ヘッダー + アクター配列 + アイテム在庫 + フラグ + 変数。
+ * 形式 (v4): ヘッダー + タグ付きセクション (アクター/インベントリ/ゴールド/
+ * 習得スキル/パーティ/フラグ/変数/バックログ)。同じ形式をメモリバッファや
+ * 任意の書き出し先へのストリームにも出せる。v1〜v3 のファイルも読める。
+ * 各スロットの要約は catalog.dat にまとめ、セーブ/削除のたびに
+ * 一時ファイル経由で丸ごと置き換える (ロード画面は 1 回の読み込みで済む)。
  *
  * Copyright (c) 2026 Reo Shiozawa — MIT License
  */
@@ -10,24 +14,54 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/stat.h>
 #ifdef _WIN32
 #  include <direct.h>   /* _mkdir */
+#  include <windows.h>  /* MoveFileExA */
 #endif
 
+/* 差分の汚れ印 (eng_delta.c から) */
+void rpg_delta_touch(const void* p, size_t size);
+void rpg_delta_touch_all(void);
+
+/* アクターの戻し先を読み込んだ値に合わせる (eng_db.c から) */
+void rpg_actor_base_sync(void);
+
+/* 変更監視 (eng_watch.c から) */
+void rpg_watch_flag_changed(const char* key, bool old_v, bool new_v);
+void rpg_watch_var_changed(const char* key, double old_v, double new_v);
+void rpg_watch_reset(void);
+
+/* クエスト条件の入力 (eng_quest.c から) */
+void rpg_quest_flag_changed(const char* key);
+void rpg_quest_var_changed(const char* key);
+void rpg_quest_invalidate(void);
+void rpg_quest_state_regions(void (*add)(const char* tag, void* p, size_t size));
+
 /* ── フラグ・変数 (線形探索ハッシュ) ─────────────────────*/
 typedef struct { char key[RPG_KEY_LEN]; bool  val; bool used; } FlagEntry;
 typedef struct { char key[RPG_KEY_LEN]; double val; bool used; } VarEntry;
 
 static FlagEntry g_flags[RPG_MAX_FLAGS];
 static VarEntry  g_vars[RPG_MAX_VARS];
+static uint32_t  g_flag_version = 0;
+
+uint32_t rpg_flag_version(void) { return g_flag_version; }
 
 void rpg_flag_set(const char* key, bool val) {
     for (int i = 0; i < RPG_MAX_FLAGS; ++i) {
         if (!g_flags[i].used || strcmp(g_flags[i].key, key) == 0) {
+            bool old = g_flags[i].used && g_flags[i].val;
             strncpy(g_flags[i].key, key, RPG_KEY_LEN-1);
             g_flags[i].val  = val;
             g_flags[i].used = true;
+            g_flag_version++;
+            rpg_delta_touch(&g_flags[i], sizeof(g_flags[i]));
+            if (old != val) {
+                rpg_watch_flag_changed(g_flags[i].key, old, val);
+                rpg_quest_flag_changed(g_flags[i].key);
+            }
             return;
         }
     }
@@ -41,9 +75,15 @@ bool rpg_flag_get(const char* key) {
 void rpg_var_set(const char* key, double val) {
     for (int i = 0; i < RPG_MAX_VARS; ++i) {
         if (!g_vars[i].used || strcmp(g_vars[i].key, key) == 0) {
+            double old = g_vars[i].used ? g_vars[i].val : 0.0;
             strncpy(g_vars[i].key, key, RPG_KEY_LEN-1);
             g_vars[i].val  = val;
             g_vars[i].used = true;
+            rpg_delta_touch(&g_vars[i], sizeof(g_vars[i]));
+            if (old != val) {
+                rpg_watch_var_changed(g_vars[i].key, old, val);
+                rpg_quest_var_changed(g_vars[i].key);
+            }
             return;
         }
     }
@@ -55,6 +95,73 @@ double rpg_var_get(const char* key) {
     return 0.0;
 }
 
+/* スナップショット/セーブ対象の状態 (eng_snapshot.c から) */
+void rpg_save_state_regions(void (*add)(const char* tag, void* p, size_t size)) {
+    add("FLAG", g_flags, sizeof(g_flags));
+    add("VARS", g_vars,  sizeof(g_vars));
+    rpg_quest_state_regions(add);   /* クエストの進行もフラグと同じ扱い */
+}
+void rpg_flag_state_restored(void) {
+    g_flag_version++;
+    rpg_watch_reset();
+    rpg_quest_invalidate();
+}
+
+/* スロット i のフラグ/変数 (未使用なら false)。セッション退避用 (eng_session.c から) */
+bool rpg_flag_at(int i, const char** key, bool* val) {
+    if (i < 0 || i >= RPG_MAX_FLAGS || !g_flags[i].used) return false;
+    *key = g_flags[i].key;
+    *val = g_flags[i].val;
+    return true;
+}
+bool rpg_var_at(int i, const char** key, double* val) {
+    if (i < 0 || i >= RPG_MAX_VARS || !g_vars[i].used) return false;
+    *key = g_vars[i].key;
+    *val = g_vars[i].val;
+    return true;
+}
+/* 現在の真のフラグ/0 以外の変数が渡された組とちょうど一致するか */
+static bool flags_vars_equal(const char* const* flags, int n_flags,
+                             const char* const* vars, const double* vals, int n_vars) {
+    int n = 0;
+    for (int i = 0; i < RPG_MAX_FLAGS; ++i) n += g_flags[i].used && g_flags[i].val;
+    if (n != n_flags) return false;
+    n = 0;
+    for (int i = 0; i < RPG_MAX_VARS; ++i) n += g_vars[i].used && g_vars[i].val != 0.0;
+    if (n != n_vars) return false;
+    for (int i = 0; i < n_flags; ++i)
+        if (!rpg_flag_get(flags[i])) return false;
+    for (int i = 0; i < n_vars; ++i) {
+        double v = rpg_var_get(vars[i]);
+        if (memcmp(&v, &vals[i], sizeof(v)) != 0) return false;
+    }
+    return true;
+}
+
+/* セッション展開用の一括復元 (eng_session.c から)。真のフラグと 0 以外の変数だけを渡す。
+ * 表を直接書き換えて 1 件ずつの変更通知は出さず、中身が変わったときだけ
+ * 監視のリセットとクエストの無効化を 1 回行う。 */
+void rpg_flags_vars_restore(const char* const* flags, int n_flags,
+                            const char* const* vars, const double* vals, int n_vars) {
+    if (n_flags > RPG_MAX_FLAGS) n_flags = RPG_MAX_FLAGS;
+    if (n_vars > RPG_MAX_VARS)   n_vars  = RPG_MAX_VARS;
+    if (flags_vars_equal(flags, n_flags, vars, vals, n_vars)) return;
+    memset(g_flags, 0, sizeof(g_flags));
+    memset(g_vars,  0, sizeof(g_vars));
+    for (int i = 0; i < n_flags; ++i) {
+        strncpy(g_flags[i].key, flags[i], RPG_KEY_LEN-1);
+        g_flags[i].val = g_flags[i].used = true;
+    }
+    for (int i = 0; i < n_vars; ++i) {
+        strncpy(g_vars[i].key, vars[i], RPG_KEY_LEN-1);
+        g_vars[i].val  = vals[i];
+        g_vars[i].used = true;
+    }
+    rpg_delta_touch(g_flags, sizeof(g_flags));
+    rpg_delta_touch(g_vars, sizeof(g_vars));
+    rpg_flag_state_restored();
+}
+
 /* ── セーブファイルパス ──────────────────────────────────*/
 static void save_path(int slot, char* buf, size_t n) {
     const char* home = getenv("HOME");
@@ -62,6 +169,21 @@ static void save_path(int slot, char* buf, size_t n) {
     snprintf(buf, n, "%s/.hajimu/saves/save_%02d.dat", home, slot);
 }
 
+static void catalog_path(char* buf, size_t n, const char* suffix) {
+    const char* home = getenv("HOME");
+    if (!home) home = ".";
+    snprintf(buf, n, "%s/.hajimu/saves/catalog.dat%s", home, suffix);
+}
+
+/* tmp を path へ置き換える (同一ディレクトリ内なので原子的) */
+static bool replace_file(const char* tmp, const char* path) {
+#ifdef _WIN32
+    return MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(tmp, path) == 0;
+#endif
+}
+
 static void ensure_dir(void) {
     const char* home = getenv("HOME");
     if (!home) home = ".";
@@ -76,8 +198,9 @@ static void ensure_dir(void) {
 
 /* ── セーブフォーマット ──────────────────────────────────*/
 #define SAVE_MAGIC  0x52504753U  /* "SERP" → "RPGS" */
-#define SAVE_VER    1
+#define SAVE_VER    4   /* v2: 末尾にノベルバックログ / v3: セクション形式 / v4: セクションに 1 件の大きさ */
 
+/* v1/v2 のヘッダー (v3 以降は magic, version, flags の 3 語) */
 typedef struct {
     uint32_t magic;
     uint32_t version;
@@ -86,86 +209,591 @@ typedef struct {
     uint32_t var_count;
 } SaveHeader;
 
-/* アクターは rpg_actor_get で直接アクセスするため、外部リンク利用 */
-extern RPG_Actor* rpg_actor_get(int id);
+/* ── カタログ ────────────────────────────────────────────*/
+#define CATALOG_MAGIC 0x43475052U  /* "RPGC" */
+#define CATALOG_VER   1
 
-bool rpg_save(int slot) {
-    if (slot < 0 || slot >= RPG_SAVE_SLOTS) return false;
+static RPG_SaveInfo* g_catalog = NULL;   /* slot 昇順 */
+static int           g_catalog_count = 0, g_catalog_cap = 0;
+static bool          g_catalog_loaded = false;
+static char          g_save_location[RPG_SAVE_LOCATION];
+static uint32_t      g_save_playtime = 0;
+
+void rpg_save_set_location(const char* location) {
+    snprintf(g_save_location, sizeof(g_save_location), "%s", location ? location : "");
+}
+void rpg_save_set_playtime(uint32_t seconds) { g_save_playtime = seconds; }
+
+/* slot の位置 (無ければ挿入位置を ~pos で返す) */
+static int catalog_find(int slot) {
+    int lo = 0, hi = g_catalog_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (g_catalog[mid].slot < slot) lo = mid + 1; else hi = mid;
+    }
+    return (lo < g_catalog_count && g_catalog[lo].slot == slot) ? lo : ~lo;
+}
+
+static bool catalog_put(const RPG_SaveInfo* info) {
+    int i = catalog_find(info->slot);
+    if (i >= 0) { g_catalog[i] = *info; return true; }
+    if (g_catalog_count >= g_catalog_cap) {
+        int cap = g_catalog_cap ? g_catalog_cap * 2 : 16;
+        RPG_SaveInfo* c = realloc(g_catalog, sizeof(*c) * (size_t)cap);
+        if (!c) return false;
+        g_catalog = c; g_catalog_cap = cap;
+    }
+    i = ~i;
+    memmove(&g_catalog[i + 1], &g_catalog[i], sizeof(*g_catalog) * (size_t)(g_catalog_count - i));
+    g_catalog[i] = *info;
+    g_catalog_count++;
+    return true;
+}
+
+static void catalog_erase(int slot) {
+    int i = catalog_find(slot);
+    if (i < 0) return;
+    memmove(&g_catalog[i], &g_catalog[i + 1], sizeof(*g_catalog) * (size_t)(g_catalog_count - i - 1));
+    g_catalog_count--;
+}
+
+static bool catalog_write(void) {
     ensure_dir();
+    char path[256], tmp[260];
+    catalog_path(path, sizeof(path), "");
+    catalog_path(tmp, sizeof(tmp), ".tmp");
+    FILE* f = fopen(tmp, "wb");
+    if (!f) { fprintf(stderr, "[eng_rpg] カタログ書き込み失敗: %s\n", tmp); return false; }
+    uint32_t hdr[3] = { CATALOG_MAGIC, CATALOG_VER, (uint32_t)g_catalog_count };
+    bool ok = fwrite(hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(g_catalog, sizeof(*g_catalog), (size_t)g_catalog_count, f) == (size_t)g_catalog_count;
+    if (fclose(f) != 0) ok = false;
+    if (ok) ok = replace_file(tmp, path);
+    if (!ok) { remove(tmp); fprintf(stderr, "[eng_rpg] カタログ書き込み失敗: %s\n", path); }
+    return ok;
+}
+
+/* カタログが無い場合は旧形式の 9 スロットを一度だけ調べて作る */
+static void catalog_migrate(void) {
+    for (int slot = 0; slot < RPG_SAVE_SLOTS; ++slot) {
+        char path[256];
+        struct stat st;
+        save_path(slot, path, sizeof(path));
+        if (stat(path, &st) != 0) continue;
+        RPG_SaveInfo info = { .slot = slot, .timestamp = (int64_t)st.st_mtime };
+        catalog_put(&info);
+    }
+    if (g_catalog_count) catalog_write();
+}
+
+bool rpg_save_catalog_reload(void) {
+    g_catalog_count  = 0;
+    g_catalog_loaded = true;
     char path[256];
-    save_path(slot, path, sizeof(path));
-    FILE* f = fopen(path, "wb");
-    if (!f) { fprintf(stderr, "[eng_rpg] セーブ失敗: %s\n", path); return false; }
+    catalog_path(path, sizeof(path), "");
+    FILE* f = fopen(path, "rb");
+    if (!f) { catalog_migrate(); return false; }
+    uint32_t hdr[3];
+    bool ok = fread(hdr, sizeof(hdr), 1, f) == 1 &&
+              hdr[0] == CATALOG_MAGIC && hdr[1] == CATALOG_VER;
+    for (uint32_t i = 0; ok && i < hdr[2]; ++i) {
+        RPG_SaveInfo info;
+        ok = fread(&info, sizeof(info), 1, f) == 1 && catalog_put(&info);
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "[eng_rpg] カタログ破損: %s\n", path);
+    return ok;
+}
 
-    /* ヘッダー */
-    SaveHeader hdr = {
-        .magic   = SAVE_MAGIC,
-        .version = SAVE_VER,
-        .actor_count = RPG_MAX_ACTORS,
-        .flag_count  = RPG_MAX_FLAGS,
-        .var_count   = RPG_MAX_VARS,
-    };
-    fwrite(&hdr, sizeof(hdr), 1, f);
+static void catalog_ensure(void) {
+    if (!g_catalog_loaded) rpg_save_catalog_reload();
+}
 
-    /* アクター */
-    for (int i = 1; i <= RPG_MAX_ACTORS; ++i) {
-        RPG_Actor* a = rpg_actor_get(i);
-        if (a) fwrite(a, sizeof(RPG_Actor), 1, f);
-        else   { RPG_Actor empty = {0}; fwrite(&empty, sizeof(empty), 1, f); }
+int rpg_save_catalog_count(void) { catalog_ensure(); return g_catalog_count; }
+
+const RPG_SaveInfo* rpg_save_catalog_get(int index) {
+    catalog_ensure();
+    return (index >= 0 && index < g_catalog_count) ? &g_catalog[index] : NULL;
+}
+
+const RPG_SaveInfo* rpg_save_info(int slot) {
+    catalog_ensure();
+    int i = catalog_find(slot);
+    return i >= 0 ? &g_catalog[i] : NULL;
+}
+
+/* ── 状態領域 ────────────────────────────────────────────*/
+/* 対象の状態 (各モジュールから) */
+void rpg_db_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_extra_state_regions(void (*add)(const char* tag, void* p, size_t size));
+
+/* バックログのシリアライズ (eng_backlog.c から) */
+bool rpg_novel_backlog_write(bool (*put)(void* ctx, const void* p, size_t n), void* ctx);
+bool rpg_novel_backlog_read(size_t (*get)(void* ctx, void* p, size_t n), void* ctx);
+
+#define SAVE_MAX_REGIONS 16
+
+typedef struct { uint32_t tag; void* p; size_t size; uint32_t rec; } SaveRegion;
+static SaveRegion g_save_regions[SAVE_MAX_REGIONS];
+static int        g_save_region_count = 0;
+
+static uint32_t tag_of(const char* s) {
+    uint32_t t;
+    memcpy(&t, s, sizeof(t));
+    return t;
+}
+
+/* 領域ごとの件数 (一覧にない領域は丸ごと 1 件)。1 件の大きさをセクションに記録し、
+ * RPG_KEY_LEN などで大きさが変わったビルドのセクションを読み違えないようにする */
+static const struct { char tag[5]; int count; } k_save_counts[] = {
+    { "ACTR", RPG_MAX_ACTORS + 1 },
+    { "INVT", RPG_MAX_INVENTORY  },
+    { "SKIL", RPG_MAX_ACTORS + 1 },
+    { "PRTY", RPG_PARTY_MGR_MAX  },
+    { "FLAG", RPG_MAX_FLAGS      },
+    { "VARS", RPG_MAX_VARS       },
+    { "QUST", RPG_MAX_QUESTS + 1 },
+};
+
+static void add_save_region(const char* tag, void* p, size_t size) {
+    if (g_save_region_count >= SAVE_MAX_REGIONS) return;
+    size_t count = 1;
+    for (size_t k = 0; k < sizeof(k_save_counts) / sizeof(k_save_counts[0]); ++k)
+        if (strcmp(k_save_counts[k].tag, tag) == 0 && size % (size_t)k_save_counts[k].count == 0)
+            count = (size_t)k_save_counts[k].count;
+    g_save_regions[g_save_region_count++] = (SaveRegion){ tag_of(tag), p, size, (uint32_t)(size / count) };
+}
+
+static void save_regions_init(void) {
+    if (g_save_region_count) return;
+    rpg_db_state_regions(add_save_region);
+    rpg_extra_state_regions(add_save_region);
+    rpg_save_state_regions(add_save_region);
+}
+
+/* 圧縮 (eng_lz.c から) */
+size_t rpg_lz_compress(const void* src, size_t n, void* dst, size_t cap);
+size_t rpg_lz_decompress(const void* src, size_t n, void* dst, size_t cap);
+
+static bool g_save_compress = false;
+
+void rpg_save_set_compress(bool on) { g_save_compress = on; }
+bool rpg_save_get_compress(void)    { return g_save_compress; }
+
+/* ── 書き出しストリーム ──────────────────────────────────
+ * セクション = [uint32 タグ] + ブロック列 ([uint32 長さ][データ]) + [uint32 0]。
+ * 状態領域のデータは [uint32 1 件の大きさ] + 配列 (v3 は大きさなし)。
+ * 小さな書き込みは SAVE_BLOCK まで溜めてから 1 ブロックにする。
+ * 圧縮ブロックは長さの最上位ビットを立て、データ = [uint32 展開後の長さ][圧縮列]。
+ */
+#define SAVE_BLOCK      16384
+#define SAVE_FLAG_LZ    1u            /* ヘッダーのフラグ: 圧縮ブロックを含む */
+#define SAVE_BLOCK_LZ   0x80000000u
+
+typedef struct {
+    RPG_WriteFn fn;
+    void*       ctx;
+    uint32_t    len;
+    bool        ok;
+    bool        compress;
+    uint8_t     buf[SAVE_BLOCK];
+    uint8_t     zbuf[SAVE_BLOCK];
+} SaveOut;
+
+static void out_raw(SaveOut* o, const void* p, size_t n) {
+    if (o->ok && n && !o->fn(o->ctx, p, n)) o->ok = false;
+}
+
+static void out_block(SaveOut* o, const void* p, uint32_t n) {
+    if (o->compress) {
+        /* 縮まないブロックはそのまま書く */
+        size_t z = rpg_lz_compress(p, n, o->zbuf, sizeof(o->zbuf));
+        if (z && z + sizeof(uint32_t) < n) {
+            uint32_t head[2] = { SAVE_BLOCK_LZ | (uint32_t)(z + sizeof(uint32_t)), n };
+            out_raw(o, head, sizeof(head));
+            out_raw(o, o->zbuf, z);
+            return;
+        }
     }
+    out_raw(o, &n, sizeof(n));
+    out_raw(o, p, n);
+}
 
-    /* フラグ */
-    fwrite(g_flags, sizeof(g_flags), 1, f);
+static void out_flush(SaveOut* o) {
+    if (o->len) out_block(o, o->buf, o->len);
+    o->len = 0;
+}
 
-    /* 変数 */
-    fwrite(g_vars, sizeof(g_vars), 1, f);
+static bool out_put(void* ctx, const void* p, size_t n) {
+    SaveOut* o = ctx;
+    const uint8_t* s = p;
+    while (n && o->ok) {
+        if (o->len == 0 && n >= SAVE_BLOCK) {
+            /* 大きな領域はバッファを通さずそのままブロックにする */
+            out_block(o, s, SAVE_BLOCK);
+            s += SAVE_BLOCK; n -= SAVE_BLOCK;
+            continue;
+        }
+        size_t k = SAVE_BLOCK - o->len;
+        if (k > n) k = n;
+        memcpy(o->buf + o->len, s, k);
+        o->len += (uint32_t)k;
+        s += k; n -= k;
+        if (o->len == SAVE_BLOCK) out_flush(o);
+    }
+    return o->ok;
+}
 
-    fclose(f);
+static void out_section(SaveOut* o, uint32_t tag) { out_raw(o, &tag, sizeof(tag)); }
+static void out_section_end(SaveOut* o) {
+    uint32_t zero = 0;
+    out_flush(o);
+    out_raw(o, &zero, sizeof(zero));
+}
+
+/* ── 読み込みストリーム ──────────────────────────────────*/
+typedef struct {
+    RPG_ReadFn     fn;
+    void*          ctx;
+    uint32_t       left;   /* 現在のブロックの残りバイト数 */
+    const uint8_t* cur;    /* 展開済みブロックの読み出し位置 (非圧縮なら NULL) */
+    bool           end;    /* セクション終端に達した */
+    bool           ok;
+    uint8_t        zbuf[SAVE_BLOCK];
+    uint8_t        buf[SAVE_BLOCK];
+} SaveIn;
+
+static bool in_raw(SaveIn* in, void* p, size_t n) {
+    if (in->ok && n && in->fn(in->ctx, p, n) != n) in->ok = false;
+    return in->ok;
+}
+
+/* 現在のセクションから最大 n バイト読む (ブロック境界は透過) */
+static size_t in_get(void* ctx, void* p, size_t n) {
+    SaveIn* in = ctx;
+    uint8_t* d = p;
+    size_t got = 0;
+    while (got < n && !in->end && in->ok) {
+        if (in->left == 0) {
+            uint32_t len;
+            if (!in_raw(in, &len, sizeof(len))) break;
+            if (len == 0) { in->end = true; break; }
+            in->cur = NULL;
+            if (len & SAVE_BLOCK_LZ) {
+                /* 圧縮ブロックは丸ごと展開してから返す */
+                uint32_t zlen = (len & ~SAVE_BLOCK_LZ) - (uint32_t)sizeof(uint32_t), raw;
+                if ((len & ~SAVE_BLOCK_LZ) < sizeof(uint32_t) || zlen > SAVE_BLOCK ||
+                    !in_raw(in, &raw, sizeof(raw)) || raw > SAVE_BLOCK ||
+                    !in_raw(in, in->zbuf, zlen) ||
+                    rpg_lz_decompress(in->zbuf, zlen, in->buf, raw) != raw) {
+                    in->ok = false;
+                    break;
+                }
+                in->cur = in->buf;
+                len = raw;
+            }
+            in->left = len;
+            continue;
+        }
+        size_t k = n - got < in->left ? n - got : in->left;
+        if (in->cur) { memcpy(d + got, in->cur, k); in->cur += k; }
+        else if (!in_raw(in, d + got, k)) break;
+        in->left -= (uint32_t)k;
+        got += k;
+    }
+    return got;
+}
+
+static bool in_section(SaveIn* in, uint32_t* tag) {
+    in->left = 0;
+    in->end  = false;
+    return in_raw(in, tag, sizeof(*tag));
+}
+
+static void in_section_end(SaveIn* in) {
+    uint8_t scratch[256];
+    while (!in->end && in->ok) in_get(in, scratch, sizeof(scratch));
+}
+
+/* ── シリアライズ ────────────────────────────────────────*/
+#define SAVE_TAG_BACKLOG  "BLOG"
+
+bool rpg_save_stream(RPG_WriteFn fn, void* ctx) {
+    if (!fn) return false;
+    SaveOut* o = malloc(sizeof(*o));
+    if (!o) return false;
+    o->fn = fn; o->ctx = ctx; o->len = 0; o->ok = true;
+    o->compress = g_save_compress;
+    save_regions_init();
+
+    uint32_t hdr[3] = { SAVE_MAGIC, SAVE_VER, o->compress ? SAVE_FLAG_LZ : 0 };
+    out_raw(o, hdr, sizeof(hdr));
+    for (int i = 0; i < g_save_region_count; ++i) {
+        const SaveRegion* r = &g_save_regions[i];
+        out_section(o, r->tag);
+        out_put(o, &r->rec, sizeof(r->rec));
+        out_put(o, r->p, r->size);
+        out_section_end(o);
+    }
+#if RPG_WITH_NOVEL
+    out_section(o, tag_of(SAVE_TAG_BACKLOG));
+    if (!rpg_novel_backlog_write(out_put, o)) o->ok = false;
+    out_section_end(o);
+#endif
+    uint32_t end = 0;
+    out_raw(o, &end, sizeof(end));
+
+    bool ok = o->ok;
+    free(o);
+    return ok;
+}
+
+/* ヘッダーを読んだ後のセクション列を復元する */
+static bool load_sections(SaveIn* in, uint32_t version) {
+    save_regions_init();
+    bool backlog = false;
+    uint32_t tag;
+    while (in_section(in, &tag) && tag != 0) {
+#if RPG_WITH_NOVEL
+        if (tag == tag_of(SAVE_TAG_BACKLOG)) {
+            backlog = rpg_novel_backlog_read(in_get, in);
+        } else
+#endif
+        {
+            for (int i = 0; i < g_save_region_count; ++i) {
+                const SaveRegion* r = &g_save_regions[i];
+                if (r->tag != tag) continue;
+                uint32_t rec = r->rec;
+                if (version >= 4 && in_get(in, &rec, sizeof(rec)) != sizeof(rec)) rec = 0;
+                if (rec != r->rec) {
+                    /* 1 件の大きさが違うビルドのセーブ: 読み違えるより空にする */
+                    fprintf(stderr, "[eng_rpg] セーブの %.4s は 1 件の大きさが違うため読み飛ばします\n", (const char*)&tag);
+                    memset(r->p, 0, r->size);
+                    break;
+                }
+                size_t got = in_get(in, r->p, r->size);
+                if (got < r->size) memset((uint8_t*)r->p + got, 0, r->size - got);
+                break;
+            }
+        }
+        in_section_end(in);   /* 未知のセクション/余りは読み飛ばす */
+    }
+#if RPG_WITH_NOVEL
+    if (!backlog) rpg_novel_backlog_clear();
+#else
+    (void)backlog;
+#endif
+    g_flag_version++;
+    rpg_delta_touch_all();
+    rpg_actor_base_sync();
+    rpg_watch_reset();
+    rpg_quest_invalidate();
+    return in->ok;
+}
+
+bool rpg_load_stream(RPG_ReadFn fn, void* ctx) {
+    if (!fn) return false;
+    SaveIn* in = malloc(sizeof(*in));
+    if (!in) return false;
+    in->fn = fn; in->ctx = ctx; in->left = 0; in->cur = NULL; in->end = false; in->ok = true;
+    uint32_t hdr[3];
+    bool ok = in_raw(in, hdr, sizeof(hdr)) && hdr[0] == SAVE_MAGIC &&
+              hdr[1] >= 3 && hdr[1] <= SAVE_VER && load_sections(in, hdr[1]);
+    free(in);
+    return ok;
+}
+
+/* メモリバッファ */
+typedef struct { uint8_t* p; size_t cap, len; } MemOut;
+typedef struct { const uint8_t* p; size_t size, pos; } MemIn;
+
+static bool mem_write(void* ctx, const void* p, size_t n) {
+    MemOut* m = ctx;
+    if (m->p && m->len <= m->cap && n <= m->cap - m->len) memcpy(m->p + m->len, p, n);
+    m->len += n;
     return true;
 }
+static size_t mem_read(void* ctx, void* p, size_t n) {
+    MemIn* m = ctx;
+    if (n > m->size - m->pos) n = m->size - m->pos;
+    memcpy(p, m->p + m->pos, n);
+    m->pos += n;
+    return n;
+}
 
-bool rpg_load(int slot) {
-    if (slot < 0 || slot >= RPG_SAVE_SLOTS) return false;
-    char path[256];
-    save_path(slot, path, sizeof(path));
-    FILE* f = fopen(path, "rb");
-    if (!f) return false;
+size_t rpg_serialize(void* buf, size_t cap) {
+    MemOut m = { buf, cap, 0 };
+    return rpg_save_stream(mem_write, &m) ? m.len : 0;
+}
+
+/* セクションの枠組みだけを先に確かめる (壊れたバッファで状態を半端に書き換えない) */
+static bool mem_check(const uint8_t* p, size_t size) {
+    size_t pos = 3 * sizeof(uint32_t);
+    uint32_t w;
+    for (;;) {
+        if (size - pos < sizeof(w)) return false;
+        memcpy(&w, p + pos, sizeof(w)); pos += sizeof(w);
+        if (w == 0) return true;            /* 終端タグ */
+        do {
+            if (size - pos < sizeof(w)) return false;
+            memcpy(&w, p + pos, sizeof(w)); pos += sizeof(w);
+            if (w == SAVE_BLOCK_LZ) return false;
+            w &= ~SAVE_BLOCK_LZ;
+            if (w > size - pos) return false;
+            pos += w;
+        } while (w != 0);
+    }
+}
+
+bool rpg_deserialize(const void* buf, size_t size) {
+    if (!buf || size < 3 * sizeof(uint32_t) || !mem_check(buf, size)) return false;
+    MemIn m = { buf, size, 0 };
+    return rpg_load_stream(mem_read, &m);
+}
+
+/* ファイル */
+static bool file_write(void* ctx, const void* p, size_t n) { return fwrite(p, 1, n, ctx) == n; }
+static size_t file_read(void* ctx, void* p, size_t n)      { return fread(p, 1, n, ctx); }
 
+/* v1/v2 形式 (固定ヘッダー + 生の配列) の読み込み。
+ * 件数はヘッダーのものを使い、このビルドの容量を超える分は読み飛ばし、足りない分は 0 にする。
+ * 1 件の大きさは記録されていないので、ファイルの長さが件数と合わなければ
+ * (RPG_Actor や RPG_KEY_LEN が違うビルドのセーブ) 読まずに失敗にする */
+static bool load_legacy(FILE* f, uint32_t version) {
     SaveHeader hdr;
-    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != SAVE_MAGIC) {
-        fclose(f); return false;
+    rewind(f);
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1) return false;
+    if (fseek(f, 0, SEEK_END) != 0) return false;
+    long len = ftell(f);
+    uint64_t need = sizeof(hdr) + (uint64_t)hdr.actor_count * sizeof(RPG_Actor)
+                  + (uint64_t)hdr.flag_count * sizeof(FlagEntry) + (uint64_t)hdr.var_count * sizeof(VarEntry);
+    if (len < 0 || (version >= 2 ? (uint64_t)len < need : (uint64_t)len != need)) {
+        fprintf(stderr, "[eng_rpg] 旧形式セーブの件数と長さが合わない (別の容量/キー長のビルド?)\n");
+        return false;
     }
+    if (fseek(f, (long)sizeof(hdr), SEEK_SET) != 0) return false;
 
     /* アクター */
-    for (int i = 1; i <= RPG_MAX_ACTORS && i <= (int)hdr.actor_count; ++i) {
-        RPG_Actor a;
-        if (fread(&a, sizeof(a), 1, f) == 1) {
-            extern void rpg_actor_set(int id, const RPG_Actor* a);
-            rpg_actor_set(i, &a);
-        }
+    extern void rpg_actor_set(int id, const RPG_Actor* a);
+    for (uint32_t i = 1; i <= RPG_MAX_ACTORS; ++i) {
+        RPG_Actor a = { 0 };
+        if (i <= hdr.actor_count && fread(&a, sizeof(a), 1, f) != 1) return false;
+        rpg_actor_set((int)i, &a);
     }
+    if (hdr.actor_count > RPG_MAX_ACTORS &&
+        fseek(f, (long)((hdr.actor_count - RPG_MAX_ACTORS) * sizeof(RPG_Actor)), SEEK_CUR) != 0) return false;
 
     /* フラグ */
-    fread(g_flags, sizeof(g_flags), 1, f);
+    uint32_t nf = hdr.flag_count < RPG_MAX_FLAGS ? hdr.flag_count : RPG_MAX_FLAGS;
+    memset(g_flags, 0, sizeof(g_flags));
+    if (fread(g_flags, sizeof(FlagEntry), nf, f) != nf) return false;
+    if (fseek(f, (long)((hdr.flag_count - nf) * sizeof(FlagEntry)), SEEK_CUR) != 0) return false;
+    g_flag_version++;
 
     /* 変数 */
-    fread(g_vars, sizeof(g_vars), 1, f);
+    uint32_t nv = hdr.var_count < RPG_MAX_VARS ? hdr.var_count : RPG_MAX_VARS;
+    memset(g_vars, 0, sizeof(g_vars));
+    if (fread(g_vars, sizeof(VarEntry), nv, f) != nv) return false;
+    if (fseek(f, (long)((hdr.var_count - nv) * sizeof(VarEntry)), SEEK_CUR) != 0) return false;
+    rpg_delta_touch(g_flags, sizeof(g_flags));
+    rpg_delta_touch(g_vars, sizeof(g_vars));
+    rpg_actor_base_sync();
+    rpg_watch_reset();
+    rpg_quest_invalidate();
 
-    fclose(f);
+    /* バックログ (v1 のセーブには無い) */
+#if RPG_WITH_NOVEL
+    if (version >= 2) rpg_novel_backlog_read(file_read, f);
+    else              rpg_novel_backlog_clear();
+#else
+    (void)version;
+#endif
     return true;
 }
 
-bool rpg_save_exists(int slot) {
+static bool save_slot(int slot) {
+    if (slot < 0) return false;
+    ensure_dir();
+    char path[256], tmp[260];
+    save_path(slot, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) { fprintf(stderr, "[eng_rpg] セーブ失敗: %s\n", path); return false; }
+
+    bool ok = rpg_save_stream(file_write, f);
+
+    if (fclose(f) != 0) ok = false;
+    if (ok) ok = replace_file(tmp, path);
+    if (!ok) {
+        remove(tmp);
+        fprintf(stderr, "[eng_rpg] セーブ失敗: %s\n", path);
+        return false;
+    }
+
+    /* カタログ更新 */
+    RPG_SaveInfo info = {
+        .slot      = slot,
+        .timestamp = (int64_t)time(NULL),
+        .playtime  = g_save_playtime,
+        .gold      = rpg_gold_get(),
+    };
+    for (int i = 0; i < rpg_party_size() && info.party_count < RPG_PARTY_MAX; ++i) {
+        const RPG_Actor* a = rpg_actor_peek(rpg_party_get(i));
+        info.party_level[info.party_count++] = a ? a->level : 0;
+    }
+    memcpy(info.location, g_save_location, sizeof(info.location));
+    catalog_ensure();
+    if (catalog_put(&info)) catalog_write();   /* 失敗してもセーブ本体は有効 */
+    return true;
+}
+
+static bool load_slot(int slot) {
+    if (slot < 0) return false;
     char path[256];
     save_path(slot, path, sizeof(path));
     FILE* f = fopen(path, "rb");
     if (!f) return false;
+
+    uint32_t head[2];
+    bool ok = fread(head, sizeof(head), 1, f) == 1 && head[0] == SAVE_MAGIC;
+    if (ok && head[1] >= 3 && head[1] <= SAVE_VER) {
+        rewind(f);
+        ok = rpg_load_stream(file_read, f);
+    } else if (ok && head[1] < 3) {
+        ok = load_legacy(f, head[1]);
+    } else {
+        ok = false;
+    }
     fclose(f);
-    return true;
+    if (!ok) fprintf(stderr, "[eng_rpg] ロード失敗: %s\n", path);
+    return ok;
+}
+
+bool rpg_save(int slot) {
+    uint64_t tr = rpg_trace_begin();
+    bool ok = save_slot(slot);
+    rpg_trace_end("rpg_save", tr);
+    return ok;
+}
+
+bool rpg_load(int slot) {
+    uint64_t tr = rpg_trace_begin();
+    bool ok = load_slot(slot);
+    rpg_trace_end("rpg_load", tr);
+    return ok;
+}
+
+bool rpg_save_exists(int slot) {
+    return rpg_save_info(slot) != NULL;
 }
 
 void rpg_save_delete(int slot) {
     char path[256];
     save_path(slot, path, sizeof(path));
     remove(path);
+    catalog_ensure();
+    if (catalog_find(slot) >= 0) {
+        catalog_erase(slot);
+        catalog_write();
+    }
 }
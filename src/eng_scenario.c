@@ -0,0 +1,487 @@
+/**
+ * src/eng_scenario.c — ビジュアルノベル用シナリオ (バイトコード)
+ *
+ * テキスト形式のシナリオを一度だけバイトコードへコンパイルし、
+ * ダイアログ・背景/立ち絵・選択肢・フラグをエンジン内で直接駆動する。
+ * 実行はプレイヤー入力が必要な地点 (メッセージ表示中/選択肢/@wait)
+ * でだけ止まる。スキップモード中はメッセージをバックログへ積むだけで
+ * 選択肢まで一気に進める。
+ *
+ * 書式 (1 行 1 命令):
+ *   # コメント / ; コメント
+ *   *ラベル
+ *   【話者】本文          話者付きメッセージ
+ *   本文                  地の文
+ *   @bg パス
+ *   @char スロット パス [表情]
+ *   @clear スロット
+ *   @flag キー 0|1
+ *   @var キー 数値
+ *   @choice ラベル 表示テキスト
+ *   @select               選択肢を表示して選択を待つ
+ *   @jump ラベル
+ *   @if キー ラベル       フラグが真ならジャンプ
+ *   @unless キー ラベル   フラグが偽ならジャンプ
+ *   @wait                 入力待ち (スキップ中は無視)
+ *   @end
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    OP_END = 0,
+    OP_MSG,      /* speaker text */
+    OP_BG,       /* path */
+    OP_CHAR,     /* slot path expr */
+    OP_CLEAR,    /* slot */
+    OP_FLAG,     /* key val */
+    OP_VAR,      /* key lo hi (double のビット列) */
+    OP_CHOICE,   /* text label */
+    OP_SELECT,
+    OP_JUMP,     /* label */
+    OP_IF,       /* key label */
+    OP_UNLESS,   /* key label */
+    OP_WAIT,
+} ScnOp;
+
+#define SCN_STEP_LIMIT (1u << 24)  /* 入力待ち無しで実行できる命令数の上限 */
+
+typedef struct { uint32_t name; uint32_t pc; } ScnLabel;
+
+struct RPG_Scenario {
+    uint32_t* code;   size_t code_len, code_cap;
+    char*     strs;   size_t strs_len, strs_cap;
+    ScnLabel* labels; int    label_count, label_cap;
+    uint8_t*  starts;  /* 命令の先頭語なら立つビット列 (code_len ビット) */
+    uint32_t  pc;
+    uint32_t  choice_pc[RPG_MAX_CHOICES];
+    int       choice_count;
+    bool      waiting_choice;
+};
+
+/* ── コンパイラ ──────────────────────────────────────────*/
+typedef struct {
+    RPG_Scenario* sc;
+    int   line;
+    char* err;
+    size_t errlen;
+    /* ラベル未解決の参照 (code 内の位置, ラベル名, 行番号) */
+    struct { size_t at; uint32_t name; int line; } *fix;
+    int   fix_count, fix_cap;
+} ScnCompiler;
+
+static bool emit(RPG_Scenario* sc, uint32_t w) {
+    if (sc->code_len >= sc->code_cap) {
+        size_t cap = sc->code_cap ? sc->code_cap * 2 : 256;
+        uint32_t* c = realloc(sc->code, sizeof(*c) * cap);
+        if (!c) return false;
+        sc->code = c; sc->code_cap = cap;
+    }
+    sc->code[sc->code_len++] = w;
+    return true;
+}
+
+/* 文字列プールに追加してオフセットを返す (失敗時 UINT32_MAX) */
+static uint32_t intern(RPG_Scenario* sc, const char* s, size_t n) {
+    if (sc->strs_len + n + 1 > sc->strs_cap) {
+        size_t cap = sc->strs_cap ? sc->strs_cap * 2 : 1024;
+        while (cap < sc->strs_len + n + 1) cap *= 2;
+        char* p = realloc(sc->strs, cap);
+        if (!p) return UINT32_MAX;
+        sc->strs = p; sc->strs_cap = cap;
+    }
+    uint32_t off = (uint32_t)sc->strs_len;
+    memcpy(sc->strs + off, s, n);
+    sc->strs[off + n] = '\0';
+    sc->strs_len += n + 1;
+    return off;
+}
+
+static bool compile_error(ScnCompiler* c, const char* msg) {
+    if (c->err && c->errlen) snprintf(c->err, c->errlen, "%d 行目: %s", c->line, msg);
+    return false;
+}
+
+static bool add_fixup(ScnCompiler* c, uint32_t name) {
+    if (c->fix_count >= c->fix_cap) {
+        int cap = c->fix_cap ? c->fix_cap * 2 : 32;
+        void* p = realloc(c->fix, sizeof(*c->fix) * (size_t)cap);
+        if (!p) return false;
+        c->fix = p; c->fix_cap = cap;
+    }
+    c->fix[c->fix_count].at   = c->sc->code_len;
+    c->fix[c->fix_count].name = name;
+    c->fix[c->fix_count].line = c->line;
+    c->fix_count++;
+    return emit(c->sc, 0);   /* 解決後に pc で上書き */
+}
+
+static bool is_space(char ch) { return ch == ' ' || ch == '\t'; }
+
+/* 次の空白区切りトークンを切り出す。rest=true なら行末まで。 */
+static bool next_token(const char** p, const char* end, const char** tok, size_t* n, bool rest) {
+    const char* s = *p;
+    while (s < end && is_space(*s)) s++;
+    if (s >= end) return false;
+    const char* e = s;
+    if (rest) { e = end; while (e > s && is_space(e[-1])) e--; }
+    else      { while (e < end && !is_space(*e)) e++; }
+    *tok = s; *n = (size_t)(e - s); *p = e;
+    return true;
+}
+
+static bool compile_command(ScnCompiler* c, const char* p, const char* end) {
+    RPG_Scenario* sc = c->sc;
+    const char* cmd; size_t cn;
+    if (!next_token(&p, end, &cmd, &cn, false)) return compile_error(c, "命令がありません");
+    const char* a[3]; size_t an[3];
+    uint32_t s0, s1;
+
+#define CMD(name)   (cn == sizeof(name) - 1 && memcmp(cmd, name, cn) == 0)
+#define ARG(i, r)   next_token(&p, end, &a[i], &an[i], r)
+#define STR_OR_FAIL(var, i) \
+    if ((var = intern(sc, a[i], an[i])) == UINT32_MAX) return compile_error(c, "メモリ不足")
+
+    if (CMD("bg")) {
+        if (!ARG(0, true)) return compile_error(c, "@bg にパスがありません");
+        STR_OR_FAIL(s0, 0);
+        return emit(sc, OP_BG) && emit(sc, s0);
+    }
+    if (CMD("char")) {
+        if (!ARG(0, false) || !ARG(1, false)) return compile_error(c, "@char スロット パス [表情]");
+        if (!ARG(2, true)) { a[2] = ""; an[2] = 0; }
+        uint32_t s2;
+        STR_OR_FAIL(s1, 1);
+        STR_OR_FAIL(s2, 2);
+        return emit(sc, OP_CHAR) && emit(sc, (uint32_t)atoi(a[0])) && emit(sc, s1) && emit(sc, s2);
+    }
+    if (CMD("clear")) {
+        if (!ARG(0, false)) return compile_error(c, "@clear にスロットがありません");
+        return emit(sc, OP_CLEAR) && emit(sc, (uint32_t)atoi(a[0]));
+    }
+    if (CMD("flag")) {
+        if (!ARG(0, false) || !ARG(1, false)) return compile_error(c, "@flag キー 0|1");
+        STR_OR_FAIL(s0, 0);
+        bool v = !(an[1] == 1 && a[1][0] == '0') && !(an[1] == 5 && memcmp(a[1], "false", 5) == 0);
+        return emit(sc, OP_FLAG) && emit(sc, s0) && emit(sc, v);
+    }
+    if (CMD("var")) {
+        if (!ARG(0, false) || !ARG(1, false)) return compile_error(c, "@var キー 数値");
+        STR_OR_FAIL(s0, 0);
+        char num[64];
+        snprintf(num, sizeof(num), "%.*s", (int)(an[1] < 63 ? an[1] : 63), a[1]);
+        double v = strtod(num, NULL);
+        uint64_t bits; memcpy(&bits, &v, sizeof(bits));
+        return emit(sc, OP_VAR) && emit(sc, s0)
+            && emit(sc, (uint32_t)bits) && emit(sc, (uint32_t)(bits >> 32));
+    }
+    if (CMD("choice")) {
+        if (!ARG(0, false) || !ARG(1, true)) return compile_error(c, "@choice ラベル テキスト");
+        STR_OR_FAIL(s0, 0);
+        STR_OR_FAIL(s1, 1);
+        return emit(sc, OP_CHOICE) && emit(sc, s1) && add_fixup(c, s0);
+    }
+    if (CMD("jump")) {
+        if (!ARG(0, false)) return compile_error(c, "@jump にラベルがありません");
+        STR_OR_FAIL(s0, 0);
+        return emit(sc, OP_JUMP) && add_fixup(c, s0);
+    }
+    if (CMD("if") || CMD("unless")) {
+        if (!ARG(0, false) || !ARG(1, false)) return compile_error(c, "@if/@unless キー ラベル");
+        STR_OR_FAIL(s0, 0);
+        STR_OR_FAIL(s1, 1);
+        return emit(sc, CMD("if") ? OP_IF : OP_UNLESS) && emit(sc, s0) && add_fixup(c, s1);
+    }
+    if (CMD("select")) return emit(sc, OP_SELECT);
+    if (CMD("wait"))   return emit(sc, OP_WAIT);
+    if (CMD("end"))    return emit(sc, OP_END);
+
+#undef CMD
+#undef ARG
+#undef STR_OR_FAIL
+    return compile_error(c, "不明な命令");
+}
+
+static bool compile_line(ScnCompiler* c, const char* p, const char* end) {
+    RPG_Scenario* sc = c->sc;
+    while (p < end && is_space(*p)) p++;
+    while (end > p && (is_space(end[-1]) || end[-1] == '\r')) end--;
+    if (p >= end || *p == '#' || *p == ';') return true;
+
+    if (*p == '@') return compile_command(c, p + 1, end);
+
+    if (*p == '*') {
+        const char* name; size_t n;
+        const char* q = p + 1;
+        if (!next_token(&q, end, &name, &n, false)) return compile_error(c, "ラベル名がありません");
+        if (sc->label_count >= sc->label_cap) {
+            int cap = sc->label_cap ? sc->label_cap * 2 : 32;
+            ScnLabel* l = realloc(sc->labels, sizeof(*l) * (size_t)cap);
+            if (!l) return compile_error(c, "メモリ不足");
+            sc->labels = l; sc->label_cap = cap;
+        }
+        uint32_t s = intern(sc, name, n);
+        if (s == UINT32_MAX) return compile_error(c, "メモリ不足");
+        for (int i = 0; i < sc->label_count; ++i)
+            if (strcmp(sc->strs + sc->labels[i].name, sc->strs + s) == 0)
+                return compile_error(c, "ラベルが重複しています");
+        sc->labels[sc->label_count].name = s;
+        sc->labels[sc->label_count].pc   = (uint32_t)sc->code_len;
+        sc->label_count++;
+        return true;
+    }
+
+    /* メッセージ行: 【話者】本文 */
+    static const char open[]  = "【";
+    static const char close[] = "】";
+    const char* spk = p; size_t sn = 0;
+    if ((size_t)(end - p) >= sizeof(open) - 1 && memcmp(p, open, sizeof(open) - 1) == 0) {
+        const char* s = p + sizeof(open) - 1;
+        const char* e = s;
+        while (e + sizeof(close) - 1 <= end && memcmp(e, close, sizeof(close) - 1) != 0) e++;
+        if (e + sizeof(close) - 1 > end) return compile_error(c, "】がありません");
+        spk = s; sn = (size_t)(e - s);
+        p = e + sizeof(close) - 1;
+    }
+    uint32_t s0 = intern(sc, spk, sn);
+    uint32_t s1 = intern(sc, p, (size_t)(end - p));
+    if (s0 == UINT32_MAX || s1 == UINT32_MAX) return compile_error(c, "メモリ不足");
+    return emit(sc, OP_MSG) && emit(sc, s0) && emit(sc, s1);
+}
+
+/* 命令ごとの語数 (オペコード込み)。未知のオペコードは 0 */
+static uint32_t op_words(uint32_t op) {
+    switch ((ScnOp)op) {
+    case OP_END: case OP_SELECT: case OP_WAIT:          return 1;
+    case OP_BG:  case OP_CLEAR:  case OP_JUMP:          return 2;
+    case OP_MSG: case OP_FLAG:   case OP_CHOICE:
+    case OP_IF:  case OP_UNLESS:                        return 3;
+    case OP_CHAR: case OP_VAR:                          return 4;
+    }
+    return 0;
+}
+
+static bool is_start(const RPG_Scenario* sc, uint32_t pc) {
+    return pc < sc->code_len && (sc->starts[pc >> 3] & (1u << (pc & 7)));
+}
+
+/* 文字列オペランドを取り出す。プール外を指すオフセットは空文字列にする */
+static const char* scn_str(const RPG_Scenario* sc, uint32_t off) {
+    return off < sc->strs_len ? sc->strs + off : "";
+}
+
+/* コンパイル後にコードを先頭から走査して命令先頭のビット列を作り、
+ * 分岐先が命令先頭であることを確かめる (seek/選択肢/ジャンプの検証用) */
+static bool build_starts(RPG_Scenario* sc) {
+    sc->starts = calloc((sc->code_len + 7) / 8, 1);
+    if (!sc->starts) return false;
+    for (size_t pc = 0; pc < sc->code_len; ) {
+        uint32_t n = op_words(sc->code[pc]);
+        if (n == 0 || pc + n > sc->code_len) return false;
+        sc->starts[pc >> 3] |= (uint8_t)(1u << (pc & 7));
+        pc += n;
+    }
+    for (size_t pc = 0; pc < sc->code_len; pc += op_words(sc->code[pc])) {
+        const uint32_t* op = &sc->code[pc];
+        uint32_t target;
+        switch ((ScnOp)op[0]) {
+        case OP_JUMP:   target = op[1]; break;
+        case OP_CHOICE: case OP_IF: case OP_UNLESS: target = op[2]; break;
+        default: continue;
+        }
+        if (!is_start(sc, target)) return false;
+    }
+    return true;
+}
+
+static int find_label(const RPG_Scenario* sc, const char* name) {
+    for (int i = 0; i < sc->label_count; ++i)
+        if (strcmp(sc->strs + sc->labels[i].name, name) == 0) return (int)sc->labels[i].pc;
+    return -1;
+}
+
+RPG_Scenario* rpg_scenario_compile(const char* src, char* err, size_t errlen) {
+    if (err && errlen) err[0] = '\0';
+    if (!src) return NULL;
+    RPG_Scenario* sc = calloc(1, sizeof(*sc));
+    if (!sc) return NULL;
+    ScnCompiler c = { .sc = sc, .err = err, .errlen = errlen };
+    bool ok = true;
+    const char* p = src;
+    while (ok && *p) {
+        const char* eol = strchr(p, '\n');
+        const char* end = eol ? eol : p + strlen(p);
+        c.line++;
+        ok = compile_line(&c, p, end);
+        if (!eol) break;
+        p = eol + 1;
+    }
+    if (ok) ok = emit(sc, OP_END);
+    for (int i = 0; ok && i < c.fix_count; ++i) {
+        int pc = find_label(sc, sc->strs + c.fix[i].name);
+        if (pc < 0) {
+            c.line = c.fix[i].line;
+            ok = compile_error(&c, "未定義のラベル");
+        } else {
+            sc->code[c.fix[i].at] = (uint32_t)pc;
+        }
+    }
+    free(c.fix);
+    if (ok) ok = build_starts(sc);
+    if (!ok) {
+        if (err && errlen && !err[0]) snprintf(err, errlen, "メモリ不足");
+        rpg_scenario_free(sc);
+        return NULL;
+    }
+    return sc;
+}
+
+RPG_Scenario* rpg_scenario_load(const char* path, char* err, size_t errlen) {
+    FILE* f = path ? fopen(path, "rb") : NULL;
+    if (!f) {
+        if (err && errlen) snprintf(err, errlen, "ファイルを開けない: %s", path ? path : "");
+        return NULL;
+    }
+    char*  buf = NULL;
+    size_t len = 0, cap = 0, n;
+    char   tmp[4096];
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0) {
+        if (len + n + 1 > cap) {
+            cap = (len + n + 1) * 2;
+            char* nb = realloc(buf, cap);
+            if (!nb) { free(buf); fclose(f); return NULL; }
+            buf = nb;
+        }
+        memcpy(buf + len, tmp, n);
+        len += n;
+    }
+    fclose(f);
+    if (!buf) return rpg_scenario_compile("", err, errlen);
+    buf[len] = '\0';
+    RPG_Scenario* sc = rpg_scenario_compile(buf, err, errlen);
+    free(buf);
+    return sc;
+}
+
+void rpg_scenario_free(RPG_Scenario* sc) {
+    if (!sc) return;
+    free(sc->code);
+    free(sc->strs);
+    free(sc->labels);
+    free(sc->starts);
+    free(sc);
+}
+
+/* ── 実行 ───────────────────────────────────────────────*/
+void rpg_scenario_reset(RPG_Scenario* sc) {
+    if (!sc) return;
+    sc->pc = 0;
+    sc->choice_count   = 0;
+    sc->waiting_choice = false;
+}
+
+bool rpg_scenario_goto(RPG_Scenario* sc, const char* label) {
+    if (!sc || !label) return false;
+    int pc = find_label(sc, label);
+    if (pc < 0) return false;
+    rpg_scenario_reset(sc);
+    sc->pc = (uint32_t)pc;
+    return true;
+}
+
+uint32_t rpg_scenario_tell(const RPG_Scenario* sc) { return sc ? sc->pc : 0; }
+
+bool rpg_scenario_seek(RPG_Scenario* sc, uint32_t pc) {
+    if (!sc || !is_start(sc, pc)) return false;   /* オペランドの途中へは飛ばせない */
+    rpg_scenario_reset(sc);
+    sc->pc = pc;
+    return true;
+}
+
+RPG_ScenarioState rpg_scenario_run(RPG_Scenario* sc, RPG_Dialog* d, RPG_ChoiceMenu* m) {
+    if (!sc || !d || !m) return RPG_SCN_ERROR;
+    bool skip = rpg_novel_get_skip();
+
+    /* 入力待ちの解除判定 */
+    if (sc->waiting_choice) {
+        if (rpg_choice_is_active(m)) return RPG_SCN_WAIT_CHOICE;
+        int sel = rpg_choice_selected(m);
+        sc->waiting_choice = false;
+        if (sel >= 0 && sel < sc->choice_count) sc->pc = sc->choice_pc[sel];
+        sc->choice_count = 0;
+    }
+    /* 表示中のメッセージを読み終えるまでは進まない (スキップ中は破棄) */
+    if (skip) rpg_dialog_clear(d);
+    else if (!rpg_dialog_empty(d)) return RPG_SCN_WAIT_MSG;
+
+    const uint32_t* code = sc->code;
+    for (uint32_t steps = 0; steps < SCN_STEP_LIMIT; ++steps) {
+        const uint32_t* op = &code[sc->pc];
+        switch ((ScnOp)op[0]) {
+        case OP_MSG:
+            sc->pc += 3;
+            rpg_novel_backlog_push(scn_str(sc, op[1]), scn_str(sc, op[2]));
+            if (skip) break;
+            rpg_dialog_push(d, scn_str(sc, op[2]), scn_str(sc, op[1]));
+            return RPG_SCN_WAIT_MSG;
+        case OP_BG:
+            rpg_novel_set_bg(scn_str(sc, op[1]));
+            sc->pc += 2;
+            break;
+        case OP_CHAR:
+            rpg_novel_set_char((int)op[1], scn_str(sc, op[2]), scn_str(sc, op[3]));
+            sc->pc += 4;
+            break;
+        case OP_CLEAR:
+            rpg_novel_clear_char((int)op[1]);
+            sc->pc += 2;
+            break;
+        case OP_FLAG:
+            rpg_flag_set(scn_str(sc, op[1]), op[2] != 0);
+            sc->pc += 3;
+            break;
+        case OP_VAR: {
+            uint64_t bits = (uint64_t)op[2] | ((uint64_t)op[3] << 32);
+            double v; memcpy(&v, &bits, sizeof(v));
+            rpg_var_set(scn_str(sc, op[1]), v);
+            sc->pc += 4;
+            break;
+        }
+        case OP_CHOICE:
+            if (sc->choice_count == 0) rpg_choice_init(m);
+            if (sc->choice_count < RPG_MAX_CHOICES) {
+                rpg_choice_add(m, scn_str(sc, op[1]));
+                sc->choice_pc[sc->choice_count++] = op[2];
+            }
+            sc->pc += 3;
+            break;
+        case OP_SELECT:
+            sc->pc += 1;
+            if (sc->choice_count == 0) break;
+            sc->waiting_choice = true;
+            return RPG_SCN_WAIT_CHOICE;
+        case OP_JUMP:
+            sc->pc = op[1];
+            break;
+        case OP_IF:
+        case OP_UNLESS:
+            if (rpg_flag_get(scn_str(sc, op[1])) == (op[0] == OP_IF)) sc->pc = op[2];
+            else sc->pc += 3;
+            break;
+        case OP_WAIT:
+            sc->pc += 1;
+            if (skip) break;
+            return RPG_SCN_WAIT_INPUT;
+        case OP_END:
+            return RPG_SCN_END;
+        default:
+            return RPG_SCN_ERROR;
+        }
+    }
+    fprintf(stderr, "[eng_rpg] シナリオが入力待ちに到達しない (無限ループ?)\n");
+    return RPG_SCN_ERROR;
+}
@@ -0,0 +1,425 @@
+/**
+ * src/eng_sched.c — 多数のワールドを進めるワークスティーリング型スケジューラ
+ *
+ * tick のたびに各ワールドを「前回そのワールドを実行したワーカー」の
+ * 両端キューへ積み、ワーカーは自分のキューの末尾から取り、空になったら
+ * 他のワーカーのキューの先頭から盗む。担当を固定したワールドは
+ * 別のキューに積み、盗まれない。呼び出しスレッドもワーカー 0 として働く。
+ *
+ * エンジン本体のワールド (DB/フラグ/パーティなど) は 1 つしかないので、
+ * ステータス/敵 AI/フック/オートセーブは g_engine_lock を取って
+ * セッションを展開 → 処理 → 取り直す。ダイアログはワールドが持つので
+ * ロックの外で並列に進む。
+ *
+ * 予算を超えたワールドは次から 2, 4, 8 tick に 1 回へ間引き、間引いた分の
+ * dt はまとめて渡す。予算内に戻れば間隔も戻す。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ── スレッド (Win32 / pthread) ─────────────────────────*/
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK            SchedMutex;
+typedef CONDITION_VARIABLE SchedCond;
+typedef HANDLE             SchedThread;
+#define SCHED_MUTEX_INIT SRWLOCK_INIT
+static void mutex_init(SchedMutex* m)    { InitializeSRWLock(m); }
+static void mutex_destroy(SchedMutex* m) { (void)m; }
+static void mutex_lock(SchedMutex* m)    { AcquireSRWLockExclusive(m); }
+static void mutex_unlock(SchedMutex* m)  { ReleaseSRWLockExclusive(m); }
+static void cond_init(SchedCond* c)      { InitializeConditionVariable(c); }
+static void cond_destroy(SchedCond* c)   { (void)c; }
+static void cond_wait(SchedCond* c, SchedMutex* m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void cond_broadcast(SchedCond* c) { WakeAllConditionVariable(c); }
+static DWORD WINAPI thread_entry(LPVOID arg);
+static bool thread_start(SchedThread* t, void* arg) {
+    *t = CreateThread(NULL, 0, thread_entry, arg, 0, NULL);
+    return *t != NULL;
+}
+static void thread_join(SchedThread t) { WaitForSingleObject(t, INFINITE); CloseHandle(t); }
+#else
+#include <pthread.h>
+typedef pthread_mutex_t SchedMutex;
+typedef pthread_cond_t  SchedCond;
+typedef pthread_t       SchedThread;
+#define SCHED_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+static void mutex_init(SchedMutex* m)    { pthread_mutex_init(m, NULL); }
+static void mutex_destroy(SchedMutex* m) { pthread_mutex_destroy(m); }
+static void mutex_lock(SchedMutex* m)    { pthread_mutex_lock(m); }
+static void mutex_unlock(SchedMutex* m)  { pthread_mutex_unlock(m); }
+static void cond_init(SchedCond* c)      { pthread_cond_init(c, NULL); }
+static void cond_destroy(SchedCond* c)   { pthread_cond_destroy(c); }
+static void cond_wait(SchedCond* c, SchedMutex* m) { pthread_cond_wait(c, m); }
+static void cond_broadcast(SchedCond* c) { pthread_cond_broadcast(c); }
+static void* thread_entry(void* arg);
+static bool thread_start(SchedThread* t, void* arg) { return pthread_create(t, NULL, thread_entry, arg) == 0; }
+static void thread_join(SchedThread t) { pthread_join(t, NULL); }
+#endif
+
+#define SCHED_MAX_BEHIND 3   /* 最大で 8 tick に 1 回まで間引く */
+
+/* エンジン本体のワールドを借りる間のロック (スケジューラ間で共有) */
+static SchedMutex g_engine_lock = SCHED_MUTEX_INIT;
+
+typedef struct {
+    bool         used;
+    RPG_Session* session;
+    RPG_Dialog   dialog;
+    RPG_Battle   battle;
+    int          home;          /* 次の tick で積むワーカー */
+    bool         pinned;
+    int          turn_ticks, since_turn;
+    int          save_slot, save_every, since_save;
+    RPG_WorldFn  fn;
+    void*        ud;
+    float        pending_dt;    /* 間引かれた分を含む未処理の経過時間 */
+    int          behind;        /* 0 = 毎 tick, n = 2^n tick に 1 回 */
+    uint64_t     last_ns;
+} SchedWorld;
+
+typedef struct {
+    SchedMutex     lock;
+    int            deque[RPG_SCHED_MAX_WORLDS];   /* [top, bottom) が盗める分 */
+    int            top, bottom;
+    int            pinned[RPG_SCHED_MAX_WORLDS];  /* 固定分 (本人だけが取る) */
+    int            n_pinned;
+    uint64_t       steals;
+    SchedThread    thread;
+    RPG_Scheduler* owner;
+    int            index;
+} SchedWorker;
+
+struct RPG_Scheduler {
+    SchedWorld  worlds[RPG_SCHED_MAX_WORLDS];
+    SchedWorker workers[RPG_SCHED_MAX_WORKERS];
+    int         n_workers;
+
+    SchedMutex  lock;            /* generation / quit / done 待ち */
+    SchedCond   wake, done;
+    uint64_t    generation;
+    bool        quit;
+    atomic_int  remaining;       /* この tick で未完了のワールド数 */
+
+    uint64_t    tick_no, budget_ns;
+    uint64_t    lat[RPG_SCHED_LAT_WINDOW];
+    uint64_t    world_runs, world_skips;
+};
+
+static SchedWorld* world_at(RPG_Scheduler* s, int w) {
+    return (s && w >= 0 && w < RPG_SCHED_MAX_WORLDS && s->worlds[w].used) ? &s->worlds[w] : NULL;
+}
+
+/* ── 1 ワールド分の処理 ─────────────────────────────────*/
+static void status_tick_side(const int* ids, int n) {
+    for (int i = 0; i < n; ++i) if (ids[i]) rpg_status_tick(ids[i]);
+}
+
+static void run_world(RPG_Scheduler* s, int wi, int worker) {
+    SchedWorld* w = &s->worlds[wi];
+    uint64_t t0 = rpg_prof_clock_ns();
+    float dt = w->pending_dt;
+    w->pending_dt = 0;
+
+    rpg_dialog_update(&w->dialog, dt);
+
+    bool turn = ++w->since_turn >= w->turn_ticks;
+    bool save = w->save_every > 0 && ++w->since_save >= w->save_every && w->behind == 0;
+    if (turn || save || w->fn) {
+        mutex_lock(&g_engine_lock);
+        rpg_session_activate(w->session);
+        if (turn) {
+            RPG_Battle* b = &w->battle;
+            w->since_turn = 0;
+            if (b->state == RPG_BATTLE_RUNNING && b->party_size) {
+                status_tick_side(b->party, b->party_size);
+                status_tick_side(b->enemy, b->enemy_size);
+                for (int i = 0; i < b->enemy_size && b->state == RPG_BATTLE_RUNNING; ++i)
+                    rpg_battle_enemy_auto_action(b, b->enemy[i]);
+            } else {
+                for (int i = 0; i < rpg_party_size(); ++i) rpg_status_tick(rpg_party_get(i));
+            }
+        }
+        if (w->fn) w->fn(w->ud, wi, dt);
+        if (save) {
+            w->since_save = 0;
+            rpg_save(w->save_slot);
+        }
+        RPG_Session* ns = rpg_session_capture();
+        if (ns) { rpg_session_free(w->session); w->session = ns; }
+        mutex_unlock(&g_engine_lock);
+    }
+
+    w->home = worker;
+    w->last_ns = rpg_prof_clock_ns() - t0;
+    if (s->budget_ns && w->last_ns > s->budget_ns) {
+        if (w->behind < SCHED_MAX_BEHIND) w->behind++;
+    } else if (w->behind > 0) {
+        w->behind--;
+    }
+}
+
+/* ── キュー ─────────────────────────────────────────────*/
+static int take_own(SchedWorker* k) {
+    int wi = -1;
+    mutex_lock(&k->lock);
+    if (k->n_pinned)            wi = k->pinned[--k->n_pinned];
+    else if (k->bottom > k->top) wi = k->deque[--k->bottom];
+    mutex_unlock(&k->lock);
+    return wi;
+}
+
+static int steal(RPG_Scheduler* s, SchedWorker* self) {
+    for (int i = 1; i < s->n_workers; ++i) {
+        SchedWorker* v = &s->workers[(self->index + i) % s->n_workers];
+        int wi = -1;
+        mutex_lock(&v->lock);
+        if (v->bottom > v->top) wi = v->deque[v->top++];
+        mutex_unlock(&v->lock);
+        if (wi >= 0) { self->steals++; return wi; }
+    }
+    return -1;
+}
+
+/* 取れる仕事が無くなるまで回す */
+static void drain(RPG_Scheduler* s, SchedWorker* k) {
+    for (;;) {
+        int wi = take_own(k);
+        if (wi < 0) wi = steal(s, k);
+        if (wi < 0) return;
+        run_world(s, wi, k->index);
+        if (atomic_fetch_sub(&s->remaining, 1) == 1) {
+            mutex_lock(&s->lock);
+            cond_broadcast(&s->done);
+            mutex_unlock(&s->lock);
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID arg)
+#else
+static void* thread_entry(void* arg)
+#endif
+{
+    SchedWorker* k = arg;
+    RPG_Scheduler* s = k->owner;
+    uint64_t seen = 0;
+    for (;;) {
+        mutex_lock(&s->lock);
+        while (!s->quit && s->generation == seen) cond_wait(&s->wake, &s->lock);
+        bool quit = s->quit;
+        seen = s->generation;
+        mutex_unlock(&s->lock);
+        if (quit) break;
+        drain(s, k);
+    }
+    return 0;
+}
+
+/* ── 生成/破棄 ──────────────────────────────────────────*/
+RPG_Scheduler* rpg_sched_create(int workers) {
+    if (workers < 1) workers = 1;
+    if (workers > RPG_SCHED_MAX_WORKERS) workers = RPG_SCHED_MAX_WORKERS;
+    RPG_Scheduler* s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    mutex_init(&s->lock);
+    cond_init(&s->wake);
+    cond_init(&s->done);
+    atomic_init(&s->remaining, 0);
+    for (int i = 0; i < workers; ++i) {
+        mutex_init(&s->workers[i].lock);
+        s->workers[i].owner = s;
+        s->workers[i].index = i;
+    }
+    s->n_workers = 1;
+    for (int i = 1; i < workers; ++i) {
+        if (!thread_start(&s->workers[i].thread, &s->workers[i])) {
+            fprintf(stderr, "[eng_rpg] スケジューラ: ワーカー %d を起動できない\n", i);
+            break;
+        }
+        s->n_workers++;
+    }
+    return s;
+}
+
+void rpg_sched_destroy(RPG_Scheduler* s) {
+    if (!s) return;
+    mutex_lock(&s->lock);
+    s->quit = true;
+    cond_broadcast(&s->wake);
+    mutex_unlock(&s->lock);
+    for (int i = 1; i < s->n_workers; ++i) thread_join(s->workers[i].thread);
+    for (int i = 0; i < RPG_SCHED_MAX_WORLDS; ++i) rpg_sched_remove_world(s, i);
+    for (int i = 0; i < RPG_SCHED_MAX_WORKERS; ++i) mutex_destroy(&s->workers[i].lock);
+    cond_destroy(&s->wake);
+    cond_destroy(&s->done);
+    mutex_destroy(&s->lock);
+    free(s);
+}
+
+/* ── ワールド ───────────────────────────────────────────*/
+int rpg_sched_add_world(RPG_Scheduler* s, RPG_Session* session) {
+    if (!s || !session) return -1;
+    for (int i = 0; i < RPG_SCHED_MAX_WORLDS; ++i) {
+        SchedWorld* w = &s->worlds[i];
+        if (w->used) continue;
+        memset(w, 0, sizeof(*w));
+        w->used       = true;
+        w->session    = session;
+        w->home       = i % s->n_workers;
+        w->turn_ticks = 1;
+        rpg_dialog_init(&w->dialog);
+        return i;
+    }
+    return -1;
+}
+
+void rpg_sched_remove_world(RPG_Scheduler* s, int world) {
+    SchedWorld* w = world_at(s, world);
+    if (!w) return;
+    rpg_dialog_free(&w->dialog);
+    rpg_session_free(w->session);
+    w->used = false;
+}
+
+RPG_Dialog* rpg_sched_world_dialog(RPG_Scheduler* s, int world) {
+    SchedWorld* w = world_at(s, world);
+    return w ? &w->dialog : NULL;
+}
+
+RPG_Battle* rpg_sched_world_battle(RPG_Scheduler* s, int world) {
+    SchedWorld* w = world_at(s, world);
+    return w ? &w->battle : NULL;
+}
+
+void rpg_sched_world_turns(RPG_Scheduler* s, int world, int turn_ticks) {
+    SchedWorld* w = world_at(s, world);
+    if (w) w->turn_ticks = turn_ticks < 1 ? 1 : turn_ticks;
+}
+
+void rpg_sched_world_autosave(RPG_Scheduler* s, int world, int slot, int every) {
+    SchedWorld* w = world_at(s, world);
+    if (!w) return;
+    w->save_slot  = slot;
+    w->save_every = every;
+    w->since_save = 0;
+}
+
+void rpg_sched_world_hook(RPG_Scheduler* s, int world, RPG_WorldFn fn, void* ud) {
+    SchedWorld* w = world_at(s, world);
+    if (!w) return;
+    w->fn = fn;
+    w->ud = ud;
+}
+
+void rpg_sched_world_pin(RPG_Scheduler* s, int world, int worker) {
+    SchedWorld* w = world_at(s, world);
+    if (!w) return;
+    w->pinned = worker >= 0;
+    if (worker >= 0) w->home = worker % s->n_workers;
+}
+
+bool rpg_sched_world_enter(RPG_Scheduler* s, int world) {
+    SchedWorld* w = world_at(s, world);
+    return w && rpg_session_activate(w->session);
+}
+
+bool rpg_sched_world_leave(RPG_Scheduler* s, int world) {
+    SchedWorld* w = world_at(s, world);
+    RPG_Session* ns = w ? rpg_session_capture() : NULL;
+    if (!ns) return false;
+    rpg_session_free(w->session);
+    w->session = ns;
+    return true;
+}
+
+void rpg_sched_set_budget(RPG_Scheduler* s, uint64_t ns) { if (s) s->budget_ns = ns; }
+
+/* ── tick ───────────────────────────────────────────────*/
+bool rpg_sched_tick(RPG_Scheduler* s, float dt) {
+    if (!s) return false;
+    uint64_t t0 = rpg_prof_clock_ns();
+    uint64_t tr = rpg_trace_begin();
+    /* 呼び出し側のワールドは tick の後に戻す */
+    RPG_Session* caller = rpg_session_capture();
+    if (!caller) { rpg_trace_end("rpg_sched_tick", tr); return false; }
+
+    int run[RPG_SCHED_MAX_WORLDS], queued = 0;
+    for (int i = 0; i < RPG_SCHED_MAX_WORLDS; ++i) {
+        SchedWorld* w = &s->worlds[i];
+        if (!w->used) continue;
+        w->pending_dt += dt;
+        if (w->behind && s->tick_no % (1u << w->behind)) { s->world_skips++; continue; }
+        run[queued++] = i;
+    }
+    s->world_runs += (uint64_t)queued;
+
+    if (queued) {
+        /* 前の tick の drain がまだ回っていても数が合うよう、積む前に件数を入れる */
+        atomic_store(&s->remaining, queued);
+        for (int j = 0; j < queued; ++j) {
+            SchedWorld*  w = &s->worlds[run[j]];
+            SchedWorker* k = &s->workers[w->home % s->n_workers];
+            mutex_lock(&k->lock);
+            if (w->pinned) k->pinned[k->n_pinned++] = run[j];
+            else           k->deque[k->bottom++] = run[j];
+            mutex_unlock(&k->lock);
+        }
+        mutex_lock(&s->lock);
+        s->generation++;
+        cond_broadcast(&s->wake);
+        mutex_unlock(&s->lock);
+
+        drain(s, &s->workers[0]);
+        mutex_lock(&s->lock);
+        while (atomic_load(&s->remaining) > 0) cond_wait(&s->done, &s->lock);
+        mutex_unlock(&s->lock);
+        for (int i = 0; i < s->n_workers; ++i) {
+            mutex_lock(&s->workers[i].lock);
+            s->workers[i].top = s->workers[i].bottom = 0;
+            mutex_unlock(&s->workers[i].lock);
+        }
+    }
+
+    mutex_lock(&g_engine_lock);
+    rpg_session_activate(caller);
+    mutex_unlock(&g_engine_lock);
+    rpg_session_free(caller);
+
+    s->lat[s->tick_no % RPG_SCHED_LAT_WINDOW] = rpg_prof_clock_ns() - t0;
+    s->tick_no++;
+    rpg_trace_end("rpg_sched_tick", tr);
+    return true;
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+void rpg_sched_stats(const RPG_Scheduler* s, RPG_SchedStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s) return;
+    out->ticks       = s->tick_no;
+    out->world_runs  = s->world_runs;
+    out->world_skips = s->world_skips;
+    for (int i = 0; i < s->n_workers; ++i) out->steals += s->workers[i].steals;
+    for (int i = 0; i < RPG_SCHED_MAX_WORLDS; ++i)
+        if (s->worlds[i].used && s->worlds[i].behind) out->behind++;
+    int n = s->tick_no < RPG_SCHED_LAT_WINDOW ? (int)s->tick_no : RPG_SCHED_LAT_WINDOW;
+    if (!n) return;
+    uint64_t v[RPG_SCHED_LAT_WINDOW];
+    memcpy(v, s->lat, sizeof(v[0]) * (size_t)n);
+    out->last_ns = s->lat[(s->tick_no - 1) % RPG_SCHED_LAT_WINDOW];
+    qsort(v, (size_t)n, sizeof(v[0]), cmp_u64);
+    out->p50_ns = v[n / 2];
+    out->p99_ns = v[(n * 99) / 100];
+    out->max_ns = v[n - 1];
+}
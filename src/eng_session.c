@@ -0,0 +1,352 @@
+/**
+ * src/eng_session.c — サーバー向けの省メモリなセッション状態 + メモリ使用量
+ *
+ * エンジン本体のワールドは 1 つだけなので、多数のプレイヤーを抱える
+ * サーバーは各セッションを RPG_Session として小さく持ち、処理のたびに
+ * rpg_session_activate でワールドへ展開し、終わったら rpg_session_capture で
+ * 取り直す。アクター名やアイテム/スキル定義などの不変データは DB 側に
+ * 1 つだけ置き、セッションには変化する値だけを狭い整数型で持つ。
+ * フラグ/変数のキーは全セッション共通の表に登録し、番号で参照する。
+ * クエストの進行は LOCKED 以外の (番号, 状態) だけを持つ。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* フラグ/変数の列挙 (eng_save.c から) */
+bool rpg_flag_at(int i, const char** key, bool* val);
+bool rpg_var_at(int i, const char** key, double* val);
+void rpg_flags_vars_restore(const char* const* flags, int n_flags,
+                            const char* const* vars, const double* vals, int n_vars);
+/* 使用量の集計 (各モジュールから) */
+void   rpg_db_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void   rpg_extra_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void   rpg_save_state_regions(void (*add)(const char* tag, void* p, size_t size));
+size_t rpg_novel_backlog_bytes(void);
+size_t rpg_table_bytes(void);
+size_t rpg_index_bytes(void);
+size_t rpg_formula_bytes(void);
+size_t rpg_delta_bytes(void);
+size_t rpg_hash_bytes(void);
+size_t rpg_quest_bytes(void);
+size_t rpg_actor_base_bytes(void);
+/* 登録時の値へ戻す (eng_db.c から) */
+void rpg_actor_reset_to_base(int id);
+/* クエストの進行 (eng_quest.c から) */
+int  rpg_quest_states_get(uint16_t* ids, uint8_t* states, int max);
+void rpg_quest_states_restore(const uint16_t* ids, const uint8_t* states, int n);
+
+/* ── 共有キー表 ─────────────────────────────────────────*/
+#define KEY_MAX 65535
+
+static char**    g_keys = NULL;       /* 番号 → 文字列 */
+static int       g_key_count = 0, g_key_cap = 0;
+static uint16_t* g_key_hash = NULL;   /* 開番地法 (番号+1、0=空き) */
+static int       g_key_hash_cap = 0;
+static size_t    g_key_bytes = 0;
+
+static uint32_t key_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    for (; *s; ++s) h = (h ^ (uint8_t)*s) * 16777619u;
+    return h;
+}
+
+static bool key_rehash(int cap) {
+    uint16_t* t = calloc((size_t)cap, sizeof(*t));
+    if (!t) return false;
+    for (int i = 0; i < g_key_count; ++i) {
+        uint32_t h = key_hash(g_keys[i]) & (uint32_t)(cap - 1);
+        while (t[h]) h = (h + 1) & (uint32_t)(cap - 1);
+        t[h] = (uint16_t)(i + 1);
+    }
+    free(g_key_hash);
+    g_key_hash = t;
+    g_key_hash_cap = cap;
+    return true;
+}
+
+/* キーの番号 (未登録なら登録)。失敗は -1。 */
+static int key_intern(const char* key) {
+    if (g_key_hash_cap) {
+        uint32_t h = key_hash(key) & (uint32_t)(g_key_hash_cap - 1);
+        for (; g_key_hash[h]; h = (h + 1) & (uint32_t)(g_key_hash_cap - 1))
+            if (strcmp(g_keys[g_key_hash[h] - 1], key) == 0) return g_key_hash[h] - 1;
+    }
+    if (g_key_count >= KEY_MAX) return -1;
+    if (g_key_count >= g_key_cap) {
+        int cap = g_key_cap ? g_key_cap * 2 : 256;
+        char** k = realloc(g_keys, sizeof(*k) * (size_t)cap);
+        if (!k) return -1;
+        g_keys = k; g_key_cap = cap;
+    }
+    size_t len = strlen(key) + 1;
+    char* s = malloc(len);
+    if (!s) return -1;
+    memcpy(s, key, len);
+    g_keys[g_key_count++] = s;
+    g_key_bytes += len;
+    /* 負荷率 1/2 以下を保つ */
+    if (g_key_count * 2 > g_key_hash_cap) {
+        if (!key_rehash(g_key_hash_cap ? g_key_hash_cap * 2 : 512)) { free(s); g_key_count--; return -1; }
+    } else {
+        uint32_t h = key_hash(key) & (uint32_t)(g_key_hash_cap - 1);
+        while (g_key_hash[h]) h = (h + 1) & (uint32_t)(g_key_hash_cap - 1);
+        g_key_hash[h] = (uint16_t)g_key_count;
+    }
+    return g_key_count - 1;
+}
+
+/* ── セッション ─────────────────────────────────────────*/
+typedef struct {
+    int32_t  hp, max_hp, mp, max_mp, exp, next_exp;
+    uint32_t status;
+    int16_t  atk, def, spd, luk, level;
+    uint16_t equip[4];
+    uint8_t  id, alive;
+} SessActor;
+
+struct RPG_Session {
+    size_t     bytes;
+    int32_t    gold;
+    uint16_t   n_actors, n_skills, n_inv, n_flags, n_vars, n_quests;
+    uint8_t    party_n;
+    uint8_t    party[RPG_PARTY_MGR_MAX];
+    /* 以下は末尾の可変長領域を指す */
+    double*    var_val;
+    uint64_t*  skill_mask;
+    SessActor* actors;
+    int32_t*   inv_count;
+    uint16_t*  inv_item;
+    uint16_t*  var_key;
+    uint16_t*  flag_key;     /* 真のフラグだけ */
+    uint16_t*  quest_id;     /* LOCKED 以外のクエストだけ */
+    uint8_t*   skill_actor;
+    uint8_t*   quest_state;
+};
+
+static size_t g_session_bytes = 0;   /* 生存中の全セッションの合計 */
+
+static bool fits16(int v) { return v >= INT16_MIN && v <= INT16_MAX; }
+
+RPG_Session* rpg_session_capture(void) {
+    /* 件数を数えて 1 回で確保する */
+    int n_actors = 0, n_skills = 0, n_flags = 0, n_vars = 0;
+    for (int id = 1; id <= RPG_MAX_ACTORS; ++id) {
+        const RPG_Actor* a = rpg_actor_peek(id);
+        if (!a->name[0]) continue;
+        n_actors++;
+        if (!fits16(a->atk) || !fits16(a->def) || !fits16(a->spd) || !fits16(a->luk) ||
+            !fits16(a->level) || a->equip[0] < 0 || a->equip[0] > UINT16_MAX ||
+            a->equip[1] < 0 || a->equip[1] > UINT16_MAX || a->equip[2] < 0 ||
+            a->equip[2] > UINT16_MAX || a->equip[3] < 0 || a->equip[3] > UINT16_MAX) {
+            fprintf(stderr, "[eng_rpg] セッション退避失敗: アクター %d の値が範囲外\n", id);
+            return NULL;
+        }
+        for (int b = 0; b < 64; ++b)
+            if (rpg_actor_has_skill(id, b)) { n_skills++; break; }
+    }
+    int inv_ids[RPG_MAX_INVENTORY], inv_cnts[RPG_MAX_INVENTORY];
+    int n_inv = rpg_inventory_list(inv_ids, inv_cnts, RPG_MAX_INVENTORY);
+    for (int i = 0; i < RPG_MAX_FLAGS; ++i) {
+        const char* k; bool v;
+        if (rpg_flag_at(i, &k, &v) && v) n_flags++;
+    }
+    for (int i = 0; i < RPG_MAX_VARS; ++i) {
+        const char* k; double v;
+        if (rpg_var_at(i, &k, &v) && v != 0.0) n_vars++;
+    }
+    int n_quests = rpg_quest_states_get(NULL, NULL, 0);
+
+    /* 配置は境界の大きい順 */
+    size_t off_var   = (sizeof(RPG_Session) + 7) & ~(size_t)7;
+    size_t off_mask  = off_var   + sizeof(double)    * (size_t)n_vars;
+    size_t off_actor = off_mask  + sizeof(uint64_t)  * (size_t)n_skills;
+    size_t off_icnt  = off_actor + sizeof(SessActor) * (size_t)n_actors;
+    size_t off_iitem = off_icnt  + sizeof(int32_t)   * (size_t)n_inv;
+    size_t off_vkey  = off_iitem + sizeof(uint16_t)  * (size_t)n_inv;
+    size_t off_fkey  = off_vkey  + sizeof(uint16_t)  * (size_t)n_vars;
+    size_t off_qid   = off_fkey  + sizeof(uint16_t)  * (size_t)n_flags;
+    size_t off_sact  = off_qid   + sizeof(uint16_t)  * (size_t)n_quests;
+    size_t off_qst   = off_sact  + (size_t)n_skills;
+    size_t total     = off_qst   + (size_t)n_quests;
+    uint8_t* mem = malloc(total);
+    if (!mem) return NULL;
+    RPG_Session* s = (RPG_Session*)mem;
+    memset(s, 0, sizeof(*s));
+    s->bytes       = total;
+    s->var_val     = (double*)(mem + off_var);
+    s->skill_mask  = (uint64_t*)(mem + off_mask);
+    s->actors      = (SessActor*)(mem + off_actor);
+    s->inv_count   = (int32_t*)(mem + off_icnt);
+    s->inv_item    = (uint16_t*)(mem + off_iitem);
+    s->var_key     = (uint16_t*)(mem + off_vkey);
+    s->flag_key    = (uint16_t*)(mem + off_fkey);
+    s->quest_id    = (uint16_t*)(mem + off_qid);
+    s->skill_actor = mem + off_sact;
+    s->quest_state = mem + off_qst;
+
+    s->gold = rpg_gold_get();
+    int pn = rpg_party_size();
+    for (int i = 0; i < pn && i < RPG_PARTY_MGR_MAX; ++i) s->party[s->party_n++] = (uint8_t)rpg_party_get(i);
+
+    for (int id = 1; id <= RPG_MAX_ACTORS; ++id) {
+        const RPG_Actor* a = rpg_actor_peek(id);
+        if (!a->name[0]) continue;
+        SessActor* sa = &s->actors[s->n_actors++];
+        sa->id = (uint8_t)id;     sa->alive = a->alive;
+        sa->hp = a->hp;           sa->max_hp = a->max_hp;
+        sa->mp = a->mp;           sa->max_mp = a->max_mp;
+        sa->exp = a->exp;         sa->next_exp = a->next_exp;
+        sa->status = a->status;
+        sa->atk = (int16_t)a->atk; sa->def = (int16_t)a->def;
+        sa->spd = (int16_t)a->spd; sa->luk = (int16_t)a->luk;
+        sa->level = (int16_t)a->level;
+        for (int e = 0; e < 4; ++e) sa->equip[e] = (uint16_t)a->equip[e];
+        uint64_t mask = 0;
+        for (int b = 0; b < 64; ++b)
+            if (rpg_actor_has_skill(id, b)) mask |= 1ull << b;
+        if (mask) {
+            s->skill_actor[s->n_skills] = (uint8_t)id;
+            s->skill_mask[s->n_skills++] = mask;
+        }
+    }
+    for (int i = 0; i < n_inv; ++i) {
+        if (inv_ids[i] < 0 || inv_ids[i] > UINT16_MAX) continue;
+        s->inv_item[s->n_inv]    = (uint16_t)inv_ids[i];
+        s->inv_count[s->n_inv++] = inv_cnts[i];
+    }
+    for (int i = 0; i < RPG_MAX_FLAGS; ++i) {
+        const char* k; bool v;
+        if (!rpg_flag_at(i, &k, &v) || !v) continue;
+        int key = key_intern(k);
+        if (key < 0) { free(mem); return NULL; }
+        s->flag_key[s->n_flags++] = (uint16_t)key;
+    }
+    for (int i = 0; i < RPG_MAX_VARS; ++i) {
+        const char* k; double v;
+        if (!rpg_var_at(i, &k, &v) || v == 0.0) continue;
+        int key = key_intern(k);
+        if (key < 0) { free(mem); return NULL; }
+        s->var_key[s->n_vars]   = (uint16_t)key;
+        s->var_val[s->n_vars++] = v;
+    }
+    s->n_quests = (uint16_t)rpg_quest_states_get(s->quest_id, s->quest_state, n_quests);
+    g_session_bytes += total;
+    return s;
+}
+
+bool rpg_session_activate(const RPG_Session* s) {
+    if (!s) return false;
+    uint64_t tr = rpg_trace_begin();
+    bool present[RPG_MAX_ACTORS + 1] = { false };
+    for (int i = 0; i < s->n_actors; ++i) {
+        const SessActor* sa = &s->actors[i];
+        RPG_Actor* a = rpg_actor_get(sa->id);
+        if (!a) continue;
+        present[sa->id] = true;
+        a->alive = sa->alive;
+        a->hp = sa->hp;     a->max_hp = sa->max_hp;
+        a->mp = sa->mp;     a->max_mp = sa->max_mp;
+        a->exp = sa->exp;   a->next_exp = sa->next_exp;
+        a->status = sa->status;
+        a->atk = sa->atk;   a->def = sa->def;
+        a->spd = sa->spd;   a->luk = sa->luk;
+        a->level = sa->level;
+        for (int e = 0; e < 4; ++e) a->equip[e] = sa->equip[e];
+    }
+    /* 退避後に登録されたアクターは前のワールドの値を引き継がず、登録時の値に戻す */
+    for (int id = 1; id <= RPG_MAX_ACTORS; ++id) {
+        const RPG_Actor* a = rpg_actor_peek(id);
+        if (a->name[0] && !present[id]) rpg_actor_reset_to_base(id);
+    }
+    for (int id = 1; id <= RPG_MAX_ACTORS; ++id)
+        for (int b = 0; b < 64; ++b) rpg_actor_forget_skill(id, b);
+    for (int i = 0; i < s->n_skills; ++i)
+        for (int b = 0; b < 64; ++b)
+            if (s->skill_mask[i] >> b & 1) rpg_actor_learn_skill(s->skill_actor[i], b);
+
+    rpg_inventory_clear();
+    for (int i = 0; i < s->n_inv; ++i) rpg_inventory_add(s->inv_item[i], s->inv_count[i]);
+    rpg_gold_set(s->gold);
+    rpg_party_clear();
+    for (int i = 0; i < s->party_n; ++i) rpg_party_add(s->party[i]);
+
+    /* フラグ/変数は 1 件ずつ設定すると監視とクエストに偽の変更が流れるので一括で戻す */
+    const char* fk[RPG_MAX_FLAGS];
+    const char* vk[RPG_MAX_VARS];
+    for (int i = 0; i < s->n_flags; ++i) fk[i] = g_keys[s->flag_key[i]];
+    for (int i = 0; i < s->n_vars; ++i)  vk[i] = g_keys[s->var_key[i]];
+    rpg_flags_vars_restore(fk, s->n_flags, vk, s->var_val, s->n_vars);
+    rpg_quest_states_restore(s->quest_id, s->quest_state, s->n_quests);
+    rpg_trace_end("rpg_session_activate", tr);
+    return true;
+}
+
+void rpg_session_free(RPG_Session* s) {
+    if (!s) return;
+    g_session_bytes -= s->bytes;
+    free(s);
+}
+
+size_t rpg_session_bytes(const RPG_Session* s) { return s ? s->bytes : 0; }
+
+/* ── メモリ使用量 ───────────────────────────────────────*/
+static RPG_MemUsage* g_rep;
+static int           g_rep_n, g_rep_max;
+
+static void rep_add(const char* name, size_t bytes) {
+    for (int i = 0; i < g_rep_n; ++i)
+        if (strcmp(g_rep[i].name, name) == 0) { g_rep[i].bytes += bytes; return; }
+    if (g_rep_n < g_rep_max) g_rep[g_rep_n++] = (RPG_MemUsage){ name, bytes };
+}
+
+static void rep_region(const char* tag, void* p, size_t size) {
+    (void)p;
+    static const struct { const char tag[5]; const char* name; } names[] = {
+        { "ACTR", "actors" }, { "INVT", "inventory" }, { "GOLD", "gold" },
+        { "SKIL", "learned_skills" }, { "PRTY", "party" }, { "PRTN", "party" },
+        { "FLAG", "flags" }, { "VARS", "vars" }, { "QUST", "quests" },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        if (memcmp(names[i].tag, tag, 4) == 0) { rep_add(names[i].name, size); return; }
+    rep_add("other", size);
+}
+
+int rpg_memory_report(RPG_MemUsage* out, int max) {
+    if (!out || max <= 0) return 0;
+    g_rep = out; g_rep_n = 0; g_rep_max = max;
+    rpg_db_state_regions(rep_region);
+    rpg_extra_state_regions(rep_region);
+    rpg_save_state_regions(rep_region);
+    rep_add("actor_base", rpg_actor_base_bytes());
+    rep_add("item_db",  sizeof(RPG_Item)  * (RPG_MAX_ITEMS + 1));
+    rep_add("skill_db", sizeof(RPG_Skill) * (RPG_MAX_SKILLS + 1));
+    rep_add("db_index", rpg_index_bytes());
+#if RPG_WITH_BATTLE
+    rep_add("formulas", rpg_formula_bytes());
+#endif
+    rep_add("quest_graph", rpg_quest_bytes());
+#if RPG_WITH_NOVEL
+    rep_add("backlog",   rpg_novel_backlog_bytes());
+#endif
+    rep_add("tables",    rpg_table_bytes());
+    rep_add("snapshots", rpg_snapshot_bytes());
+    rep_add("delta",     rpg_delta_bytes());
+    rep_add("state_hash", rpg_hash_bytes());
+    rep_add("save_catalog", sizeof(RPG_SaveInfo) * (size_t)rpg_save_catalog_count());
+    rep_add("session_keys", g_key_bytes + sizeof(*g_keys) * (size_t)g_key_cap +
+                            sizeof(*g_key_hash) * (size_t)g_key_hash_cap);
+    rep_add("sessions", g_session_bytes);
+    return g_rep_n;
+}
+
+size_t rpg_memory_total(void) {
+    RPG_MemUsage u[32];
+    int n = rpg_memory_report(u, 32);
+    size_t total = 0;
+    for (int i = 0; i < n; ++i) total += u[i].bytes;
+    return total;
+}
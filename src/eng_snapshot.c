@@ -0,0 +1,196 @@
+/**
+ * src/eng_snapshot.c — メモリ上のワールドスナップショット (クイックセーブ/リトライ)
+ *
+ * 対象の状態 (アクター/インベントリ/ゴールド/パーティ/習得スキル/フラグ/変数) を
+ * RPG_SNAPSHOT_PAGE バイトのページに区切り、参照カウント付きのページを
+ * スナップショット間で共有する。保存時は直前のスナップショットと中身が
+ * 同じページを共有するだけなので、変化したページ分しかコピーしない。
+ * 復元も異なるページだけを書き戻す。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 対象の状態 (各モジュールから) */
+void rpg_db_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_extra_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_save_state_regions(void (*add)(const char* tag, void* p, size_t size));
+void rpg_flag_state_restored(void);
+void rpg_delta_touch(const void* p, size_t size);
+/* アクターの戻し先を読み込んだ値に合わせる (eng_db.c から) */
+void rpg_actor_base_sync(void);
+
+#define SNAP_MAX_REGIONS 16
+
+typedef struct {
+    int     refs;
+    uint8_t data[];
+} SnapPage;
+
+typedef struct {
+    int        id;
+    SnapPage** pages;
+} Snapshot;
+
+/* ページ i は g_page_ptr[i] から g_page_len[i] バイト */
+static struct { uint8_t* p; size_t size; } g_regions[SNAP_MAX_REGIONS];
+static int       g_region_count = 0;
+static uint8_t** g_page_ptr = NULL;
+static uint32_t* g_page_len = NULL;
+static int       g_page_count = 0;
+
+static Snapshot  g_snaps[RPG_SNAPSHOT_HISTORY_MAX];   /* 古い順 */
+static int       g_snap_count = 0;
+static int       g_snap_limit = RPG_SNAPSHOT_HISTORY;
+static int       g_snap_next_id = 1;
+static int       g_snap_base = 0;   /* 現在の状態に最も近いスナップショット id */
+static size_t    g_snap_bytes = 0;  /* 確保中のページ総バイト数 */
+
+/* ── ページ表 ───────────────────────────────────────────*/
+static void add_region(const char* tag, void* p, size_t size) {
+    (void)tag;
+    if (g_region_count >= SNAP_MAX_REGIONS) {
+        fprintf(stderr, "[eng_rpg] スナップショット領域が多すぎる\n");
+        return;
+    }
+    g_regions[g_region_count].p    = p;
+    g_regions[g_region_count].size = size;
+    g_region_count++;
+}
+
+static bool pages_init(void) {
+    if (g_page_ptr) return true;
+    rpg_db_state_regions(add_region);
+    rpg_extra_state_regions(add_region);
+    rpg_save_state_regions(add_region);
+    int n = 0;
+    for (int r = 0; r < g_region_count; ++r)
+        n += (int)((g_regions[r].size + RPG_SNAPSHOT_PAGE - 1) / RPG_SNAPSHOT_PAGE);
+    g_page_ptr = malloc(sizeof(*g_page_ptr) * (size_t)n);
+    g_page_len = malloc(sizeof(*g_page_len) * (size_t)n);
+    if (!g_page_ptr || !g_page_len) {
+        free(g_page_ptr); free(g_page_len);
+        g_page_ptr = NULL; g_page_len = NULL;
+        return false;
+    }
+    for (int r = 0; r < g_region_count; ++r) {
+        for (size_t off = 0; off < g_regions[r].size; off += RPG_SNAPSHOT_PAGE) {
+            size_t len = g_regions[r].size - off;
+            g_page_ptr[g_page_count] = g_regions[r].p + off;
+            g_page_len[g_page_count] = (uint32_t)(len < RPG_SNAPSHOT_PAGE ? len : RPG_SNAPSHOT_PAGE);
+            g_page_count++;
+        }
+    }
+    return true;
+}
+
+static void page_release(SnapPage* pg, uint32_t len) {
+    if (pg && --pg->refs == 0) {
+        g_snap_bytes -= len;
+        free(pg);
+    }
+}
+
+static void snap_free(Snapshot* s) {
+    for (int i = 0; i < g_page_count; ++i) page_release(s->pages[i], g_page_len[i]);
+    free(s->pages);
+    s->pages = NULL;
+}
+
+static int snap_index(int id) {
+    for (int i = 0; i < g_snap_count; ++i)
+        if (g_snaps[i].id == id) return i;
+    return -1;
+}
+
+static void snap_remove_at(int i) {
+    snap_free(&g_snaps[i]);
+    memmove(&g_snaps[i], &g_snaps[i + 1], sizeof(*g_snaps) * (size_t)(g_snap_count - i - 1));
+    g_snap_count--;
+}
+
+/* ── 保存/復元 ──────────────────────────────────────────*/
+int rpg_snapshot_take(void) {
+    if (!pages_init()) return 0;
+    uint64_t tr = rpg_trace_begin();
+    Snapshot s = { .id = g_snap_next_id, .pages = calloc((size_t)g_page_count, sizeof(SnapPage*)) };
+    if (!s.pages) return 0;
+    int bi = snap_index(g_snap_base);
+    if (bi < 0 && g_snap_count) bi = g_snap_count - 1;
+    const Snapshot* base = bi >= 0 ? &g_snaps[bi] : NULL;
+    for (int i = 0; i < g_page_count; ++i) {
+        SnapPage* prev = base ? base->pages[i] : NULL;
+        if (prev && memcmp(prev->data, g_page_ptr[i], g_page_len[i]) == 0) {
+            prev->refs++;
+            s.pages[i] = prev;
+            continue;
+        }
+        SnapPage* pg = malloc(sizeof(*pg) + g_page_len[i]);
+        if (!pg) { snap_free(&s); rpg_trace_end("rpg_snapshot_take", tr); return 0; }
+        pg->refs = 1;
+        memcpy(pg->data, g_page_ptr[i], g_page_len[i]);
+        g_snap_bytes += g_page_len[i];
+        s.pages[i] = pg;
+    }
+    while (g_snap_count >= g_snap_limit) snap_remove_at(0);
+    g_snaps[g_snap_count++] = s;
+    g_snap_next_id++;
+    g_snap_base = s.id;
+    rpg_trace_end("rpg_snapshot_take", tr);
+    return s.id;
+}
+
+bool rpg_snapshot_restore(int id) {
+    int si = snap_index(id);
+    if (si < 0) return false;
+    uint64_t tr = rpg_trace_begin();
+    const Snapshot* s = &g_snaps[si];
+    for (int i = 0; i < g_page_count; ++i) {
+        if (memcmp(g_page_ptr[i], s->pages[i]->data, g_page_len[i]) != 0) {
+            memcpy(g_page_ptr[i], s->pages[i]->data, g_page_len[i]);
+            rpg_delta_touch(g_page_ptr[i], g_page_len[i]);
+        }
+    }
+    rpg_actor_base_sync();
+    rpg_flag_state_restored();
+    g_snap_base = id;
+    rpg_trace_end("rpg_snapshot_restore", tr);
+    return true;
+}
+
+bool rpg_snapshot_undo(int steps) {
+    if (steps < 1 || steps > g_snap_count) return false;
+    int target = g_snap_count - steps;
+    if (!rpg_snapshot_restore(g_snaps[target].id)) return false;
+    while (g_snap_count > target + 1) snap_remove_at(g_snap_count - 1);
+    return true;
+}
+
+/* ── 履歴管理 ───────────────────────────────────────────*/
+void rpg_snapshot_drop(int id) {
+    int i = snap_index(id);
+    if (i >= 0) snap_remove_at(i);
+}
+
+void rpg_snapshot_clear(void) {
+    while (g_snap_count) snap_remove_at(g_snap_count - 1);
+    g_snap_base = 0;
+}
+
+void rpg_snapshot_set_limit(int n) {
+    if (n < 1) n = 1;
+    if (n > RPG_SNAPSHOT_HISTORY_MAX) n = RPG_SNAPSHOT_HISTORY_MAX;
+    g_snap_limit = n;
+    while (g_snap_count > g_snap_limit) snap_remove_at(0);
+}
+
+int rpg_snapshot_count(void) { return g_snap_count; }
+
+int rpg_snapshot_id(int back) {
+    return (back >= 0 && back < g_snap_count) ? g_snaps[g_snap_count - 1 - back].id : 0;
+}
+
+size_t rpg_snapshot_bytes(void) { return g_snap_bytes; }
@@ -0,0 +1,244 @@
+/**
+ * src/eng_table.c — エンカウント/ドロップ用の重み付き抽選テーブル
+ *
+ * 抽選は Walker のエイリアス法で O(1)。フラグ条件付きの行があるテーブルは
+ * フラグストアの更新番号が変わったときだけ有効行を数え直し、有効行の
+ * 組み合わせが変わった場合に限ってエイリアス表を作り直す。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    RPG_TableRowKind kind;
+    uint32_t weight;
+    int      v[RPG_PARTY_MAX];   /* 敵: actor_id 群 / アイテム: id,min,max / ゴールド: min,max */
+    bool     has_cond, cond_neg;
+    char     flag[RPG_KEY_LEN];
+} TableRow;
+
+typedef struct {
+    TableRow rows[RPG_TABLE_ROWS];
+    int      row_count;
+    bool     has_cond;
+    /* エイリアス表 (有効行のみ。slot → 行番号) */
+    uint64_t prob[RPG_TABLE_ROWS];   /* 2^32 スケールの閾値 */
+    uint8_t  alias[RPG_TABLE_ROWS];
+    uint8_t  slot_row[RPG_TABLE_ROWS];
+    int      n_slots;
+    uint64_t built_mask;             /* エイリアス表を作ったときの有効行 */
+    uint32_t flag_version;
+    bool     dirty;
+} Table;
+
+static Table* g_tables[RPG_MAX_TABLES + 1];   /* [0] 未使用、必要になってから確保 */
+
+/* ── 乱数 (splitmix64) ───────────────────────────────────*/
+static uint64_t g_table_rng = 0;
+
+void rpg_table_seed(uint64_t seed) { g_table_rng = seed ? seed : 1; }
+
+static uint64_t table_rand(void) {
+    if (!g_table_rng) g_table_rng = (uint64_t)time(NULL) | 1;
+    uint64_t z = (g_table_rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int rand_range(int lo, int hi) {
+    if (hi <= lo) return lo;
+    return lo + (int)(table_rand() % (uint64_t)((int64_t)hi - lo + 1));
+}
+
+/* ── 構築 ───────────────────────────────────────────────*/
+static Table* table_at(int id, bool create) {
+    if (id < 1 || id > RPG_MAX_TABLES) return NULL;
+    if (!g_tables[id] && create) g_tables[id] = calloc(1, sizeof(Table));
+    return g_tables[id];
+}
+
+void rpg_table_clear(int id) {
+    Table* t = table_at(id, false);
+    if (!t) return;
+    memset(t, 0, sizeof(*t));
+}
+
+static int table_add(int id, RPG_TableRowKind kind, int weight, const int* v, int nv, const char* flag) {
+    Table* t = table_at(id, true);
+    if (!t || weight <= 0) return -1;
+    if (t->row_count >= RPG_TABLE_ROWS) {
+        fprintf(stderr, "[eng_rpg] テーブル %d の行が満杯\n", id);
+        return -1;
+    }
+    TableRow* r = &t->rows[t->row_count];
+    memset(r, 0, sizeof(*r));
+    r->kind   = kind;
+    r->weight = (uint32_t)weight;
+    for (int i = 0; i < nv && i < RPG_PARTY_MAX; ++i) r->v[i] = v[i];
+    if (flag && *flag) {
+        r->has_cond = true;
+        r->cond_neg = flag[0] == '!';
+        snprintf(r->flag, sizeof(r->flag), "%s", flag + (r->cond_neg ? 1 : 0));
+        t->has_cond = true;
+    }
+    t->dirty = true;
+    return t->row_count++;
+}
+
+int rpg_table_add_enemies(int id, int weight, const int* enemies, const char* flag) {
+    int v[RPG_PARTY_MAX] = {0}, n = 0;
+    for (; enemies && n < RPG_PARTY_MAX && enemies[n]; ++n) v[n] = enemies[n];
+    if (n == 0) return -1;
+    return table_add(id, RPG_ROW_ENEMIES, weight, v, n, flag);
+}
+int rpg_table_add_item(int id, int weight, int item_id, int min, int max, const char* flag) {
+    int v[3] = { item_id, min, max < min ? min : max };
+    return table_add(id, RPG_ROW_ITEM, weight, v, 3, flag);
+}
+int rpg_table_add_gold(int id, int weight, int min, int max, const char* flag) {
+    int v[2] = { min, max < min ? min : max };
+    return table_add(id, RPG_ROW_GOLD, weight, v, 2, flag);
+}
+int rpg_table_add_none(int id, int weight, const char* flag) {
+    return table_add(id, RPG_ROW_NONE, weight, NULL, 0, flag);
+}
+
+static uint64_t active_mask(const Table* t) {
+    uint64_t m = 0;
+    for (int i = 0; i < t->row_count; ++i) {
+        const TableRow* r = &t->rows[i];
+        if (!r->has_cond || rpg_flag_get(r->flag) != r->cond_neg) m |= 1ull << i;
+    }
+    return m;
+}
+
+/* Vose のエイリアス法 (整数演算) */
+static void build_alias(Table* t, uint64_t mask) {
+    uint64_t p[RPG_TABLE_ROWS], total = 0;
+    int n = 0;
+    for (int i = 0; i < t->row_count; ++i) {
+        if (!(mask >> i & 1)) continue;
+        t->slot_row[n] = (uint8_t)i;
+        total += t->rows[i].weight;
+        n++;
+    }
+    t->n_slots    = n;
+    t->built_mask = mask;
+    t->dirty      = false;
+    if (n == 0) return;
+    /* 各スロットの重み×n を平均 total と比べる */
+    int small[RPG_TABLE_ROWS], large[RPG_TABLE_ROWS], ns = 0, nl = 0;
+    for (int s = 0; s < n; ++s) {
+        p[s] = (uint64_t)t->rows[t->slot_row[s]].weight * (uint64_t)n;
+        if (p[s] < total) small[ns++] = s; else large[nl++] = s;
+    }
+    while (ns && nl) {
+        int s = small[--ns], l = large[--nl];
+        /* p[s] * 2^32 / total を 16bit ずつ 2 段の割り算で求める (total < 2^38 なので
+         * 途中の値は 64bit に収まり、浮動小数点の丸めがビルドで変わることもない) */
+        uint64_t hi = (p[s] << 16) / total, rem = (p[s] << 16) % total;
+        t->prob[s]  = (hi << 16) + (rem << 16) / total;
+        t->alias[s] = (uint8_t)l;
+        p[l] -= total - p[s];
+        if (p[l] < total) small[ns++] = l; else large[nl++] = l;
+    }
+    while (nl) { int l = large[--nl]; t->prob[l] = 1ull << 32; t->alias[l] = (uint8_t)l; }
+    while (ns) { int s = small[--ns]; t->prob[s] = 1ull << 32; t->alias[s] = (uint8_t)s; }
+}
+
+/* 抽選前にエイリアス表を最新にする。有効行が無ければ false。 */
+static bool table_ready(Table* t) {
+    if (t->has_cond) {
+        uint32_t ver = rpg_flag_version();
+        if (t->dirty || ver != t->flag_version) {
+            t->flag_version = ver;
+            uint64_t m = active_mask(t);
+            if (t->dirty || m != t->built_mask) build_alias(t, m);
+        }
+    } else if (t->dirty) {
+        build_alias(t, t->row_count >= 64 ? ~0ull : (1ull << t->row_count) - 1);
+    }
+    return t->n_slots > 0;
+}
+
+static int table_sample(const Table* t) {
+    uint64_t u = table_rand();
+    uint32_t s = (uint32_t)(((u >> 32) * (uint64_t)t->n_slots) >> 32);
+    if ((u & 0xFFFFFFFFull) >= t->prob[s]) s = t->alias[s];
+    return t->slot_row[s];
+}
+
+/* ── 抽選 ───────────────────────────────────────────────*/
+int rpg_table_roll(int id) {
+    Table* t = table_at(id, false);
+    if (!t || !table_ready(t)) return -1;
+    return table_sample(t);
+}
+
+int rpg_table_roll_batch(int id, int n, int* out_hits) {
+    Table* t = table_at(id, false);
+    if (!t || n <= 0 || !out_hits) return 0;
+    for (int i = 0; i < t->row_count; ++i) out_hits[i] = 0;
+    if (!table_ready(t)) return 0;
+    for (int i = 0; i < n; ++i) out_hits[table_sample(t)]++;
+    return t->row_count;
+}
+
+size_t rpg_table_bytes(void) {
+    size_t n = 0;
+    for (int i = 1; i <= RPG_MAX_TABLES; ++i)
+        if (g_tables[i]) n += sizeof(Table);
+    return n;
+}
+
+int rpg_table_row_count(int id) {
+    Table* t = table_at(id, false);
+    return t ? t->row_count : 0;
+}
+
+RPG_TableRowKind rpg_table_row_kind(int id, int row) {
+    Table* t = table_at(id, false);
+    if (!t || row < 0 || row >= t->row_count) return RPG_ROW_NONE;
+    return t->rows[row].kind;
+}
+
+#if RPG_WITH_BATTLE
+int rpg_encounter_roll(int id, RPG_Battle* b, const int* party) {
+    Table* t = table_at(id, false);
+    if (!t || !b || !party || !table_ready(t)) return -1;
+    int row = table_sample(t);
+    const TableRow* r = &t->rows[row];
+    if (r->kind == RPG_ROW_ENEMIES) {
+        int enemy[RPG_PARTY_MAX + 1] = {0};
+        memcpy(enemy, r->v, sizeof(r->v));
+        rpg_battle_init(b, party, enemy);
+    }
+    return row;
+}
+#endif
+
+int rpg_loot_apply(int id, int rolls, int* out_gold) {
+    Table* t = table_at(id, false);
+    int items = 0;
+    int64_t gold = 0;
+    if (t && rolls > 0 && table_ready(t)) {
+        for (int i = 0; i < rolls; ++i) {
+            const TableRow* r = &t->rows[table_sample(t)];
+            if (r->kind == RPG_ROW_ITEM) {
+                int c = rand_range(r->v[1], r->v[2]);
+                if (c > 0) { rpg_inventory_add(r->v[0], c); items += c; }
+            } else if (r->kind == RPG_ROW_GOLD) {
+                gold += rand_range(r->v[0], r->v[1]);
+            }
+        }
+        /* ゴールドはまとめて加算 (int 上限で飽和) */
+        rpg_gold_add(gold > INT32_MAX ? INT32_MAX : (int)gold);
+    }
+    if (out_gold) *out_gold = gold > INT32_MAX ? INT32_MAX : (int)gold;
+    return items;
+}
@@ -0,0 +1,110 @@
+/**
+ * src/eng_trace.c — Chrome trace 形式のスパン記録
+ *
+ * スパンはスレッドごとのリングバッファに書き込む。書き込みは所有
+ * スレッドだけが行い、出力側は head を読んで未出力分をコピーするだけ
+ * なのでロックは不要。コピー中に上書きされた古いイベントは捨てる。
+ * 出力は chrome://tracing / Perfetto で開ける JSON。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char* name;   /* 静的な文字列 */
+    uint64_t    ts;     /* 開始 (ns) */
+    uint64_t    dur;    /* 長さ (ns) */
+} TraceEvent;
+
+typedef struct TraceRing {
+    struct TraceRing* next;
+    uint32_t          tid;
+    _Atomic uint64_t  head;      /* 書き込み済みイベント総数 */
+    uint64_t          flushed;   /* 出力済みイベント総数 (出力側のみ更新) */
+    TraceEvent        ev[RPG_TRACE_RING];
+} TraceRing;
+
+static _Atomic(TraceRing*)     g_rings = NULL;
+static atomic_bool             g_trace_on = false;
+static atomic_uint             g_next_tid = 1;
+static _Thread_local TraceRing* t_ring = NULL;
+
+static TraceRing* my_ring(void) {
+    if (t_ring) return t_ring;
+    TraceRing* r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->tid = atomic_fetch_add(&g_next_tid, 1);
+    /* リストの先頭へ登録 (スレッド終了後もリングは残す) */
+    TraceRing* old = atomic_load(&g_rings);
+    do { r->next = old; } while (!atomic_compare_exchange_weak(&g_rings, &old, r));
+    t_ring = r;
+    return r;
+}
+
+void rpg_trace_enable(bool on) { atomic_store(&g_trace_on, on); }
+bool rpg_trace_enabled(void)   { return atomic_load_explicit(&g_trace_on, memory_order_relaxed); }
+
+uint64_t rpg_trace_begin(void) {
+    if (!atomic_load_explicit(&g_trace_on, memory_order_relaxed)) return 0;
+    return rpg_prof_clock_ns();
+}
+
+void rpg_trace_end(const char* name, uint64_t begin) {
+    if (!begin) return;
+    uint64_t now = rpg_prof_clock_ns();
+    TraceRing* r = my_ring();
+    if (!r) return;
+    uint64_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    TraceEvent* e = &r->ev[h % RPG_TRACE_RING];
+    e->name = name;
+    e->ts   = begin;
+    e->dur  = now - begin;
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+static void json_name(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') { fputc('\\', f); fputc(ch, f); }
+        else if (ch >= 0x20)         fputc(ch, f);
+    }
+    fputc('"', f);
+}
+
+bool rpg_trace_write(const char* path) {
+    FILE* f = path ? fopen(path, "w") : NULL;
+    if (!f) { fprintf(stderr, "[eng_rpg] トレース出力失敗: %s\n", path ? path : ""); return false; }
+    TraceEvent* buf = malloc(sizeof(*buf) * RPG_TRACE_RING);
+    if (!buf) { fclose(f); return false; }
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    for (TraceRing* r = atomic_load(&g_rings); r; r = r->next) {
+        uint64_t h     = atomic_load_explicit(&r->head, memory_order_acquire);
+        uint64_t start = r->flushed;
+        if (h - start > RPG_TRACE_RING) start = h - RPG_TRACE_RING;
+        for (uint64_t i = start; i < h; ++i) buf[i - start] = r->ev[i % RPG_TRACE_RING];
+        /* コピー中に書き手が追い越した分は壊れている可能性があるので捨てる。
+         * 書き手は公開前の h2 番目を h2 % RING (= h2 - RING 番目の枠) に書いているので、
+         * 残せるのは h2 - RING + 1 番目から */
+        uint64_t h2 = atomic_load_explicit(&r->head, memory_order_acquire);
+        uint64_t valid_from = h2 >= RPG_TRACE_RING ? h2 - RPG_TRACE_RING + 1 : 0;
+        for (uint64_t i = start; i < h; ++i) {
+            if (i < valid_from) continue;
+            const TraceEvent* e = &buf[i - start];
+            fprintf(f, "%s\n{\"name\":", first ? "" : ",");
+            json_name(f, e->name);
+            fprintf(f, ",\"cat\":\"rpg\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    r->tid, (double)e->ts / 1000.0, (double)e->dur / 1000.0);
+            first = false;
+        }
+        r->flushed = h;
+    }
+    fprintf(f, "\n]}\n");
+    free(buf);
+    return fclose(f) == 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * src/eng_watch.c — フラグ/変数/アクターの変更監視
+ *
+ * フラグ/変数は eng_save.c の書き込み口が値の変わったときだけ
+ * rpg_watch_flag_changed / rpg_watch_var_changed を呼び、キー (または
+ * 末尾 '*' の前方一致) が合う監視ごとにイベントを積む。同じ監視・同じキーの
+ * イベントが既に積まれていれば新しい値だけ上書きし、取り出すまでに
+ * 元の値へ戻ったものは捨てる。
+ *
+ * アクターの hp/alive/status はポインタ経由で直接書き換えられるので、
+ * 取り出し時に監視中のアクターだけ前回値と比べる。
+ *
+ * ロード/スナップショット復元など一括で書き換わったときや、キューが
+ * あふれたときは RPG_WATCH_RESET を 1 件返す (読み直しの合図)。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#include "eng_rpg.h"
+#include <string.h>
+
+typedef struct {
+    RPG_WatchKind kind;       /* FLAG / VAR / ACTOR。0 件目は未使用 */
+    bool          used;
+    bool          prefix;     /* pattern の末尾が '*' */
+    char          pattern[RPG_KEY_LEN];
+    size_t        len;        /* '*' を除いた長さ */
+    int           actor_id;
+    int           hp;         /* ACTOR: 前回の値 */
+    bool          alive;
+    uint32_t      status;
+} Watch;
+
+static Watch          g_watches[RPG_MAX_WATCHES + 1];   /* [0] 未使用 */
+static int            g_watch_count = 0;
+static RPG_WatchEvent g_queue[RPG_WATCH_QUEUE];
+static int            g_queued = 0;
+static bool           g_reset = false;
+
+/* ── 登録 ───────────────────────────────────────────────*/
+static int add_watch(RPG_WatchKind kind, const char* pattern, int actor_id) {
+    for (int id = 1; id <= RPG_MAX_WATCHES; ++id) {
+        Watch* w = &g_watches[id];
+        if (w->used) continue;
+        memset(w, 0, sizeof(*w));
+        w->used = true;
+        w->kind = kind;
+        if (pattern) {
+            strncpy(w->pattern, pattern, RPG_KEY_LEN - 1);
+            w->len = strlen(w->pattern);
+            if (w->len > 0 && w->pattern[w->len - 1] == '*') { w->prefix = true; w->len--; }
+        }
+        w->actor_id = actor_id;
+        if (kind == RPG_WATCH_ACTOR) {
+            const RPG_Actor* a = rpg_actor_peek(actor_id);
+            w->hp     = a ? a->hp : 0;
+            w->alive  = a ? a->alive : false;
+            w->status = a ? a->status : 0;
+        }
+        if (id > g_watch_count) g_watch_count = id;
+        return id;
+    }
+    return 0;
+}
+
+int rpg_watch_flag(const char* pattern) { return pattern ? add_watch(RPG_WATCH_FLAG, pattern, 0) : 0; }
+int rpg_watch_var(const char* pattern)  { return pattern ? add_watch(RPG_WATCH_VAR,  pattern, 0) : 0; }
+int rpg_watch_actor(int actor_id) {
+    return rpg_actor_peek(actor_id) ? add_watch(RPG_WATCH_ACTOR, NULL, actor_id) : 0;
+}
+
+void rpg_watch_remove(int id) {
+    if (id < 1 || id > RPG_MAX_WATCHES) return;
+    g_watches[id].used = false;
+    /* 解除した監視のイベントは捨てる */
+    int n = 0;
+    for (int i = 0; i < g_queued; ++i)
+        if (g_queue[i].watch_id != id) g_queue[n++] = g_queue[i];
+    g_queued = n;
+    while (g_watch_count > 0 && !g_watches[g_watch_count].used) g_watch_count--;
+}
+
+void rpg_watch_clear(void) {
+    memset(g_watches, 0, sizeof(g_watches));
+    g_watch_count = 0;
+    g_queued = 0;
+    g_reset = false;
+}
+
+/* ── 通知 ───────────────────────────────────────────────*/
+static void push(int id, RPG_WatchKind kind, int actor_id, const char* key, double old_v, double new_v) {
+    for (int i = 0; i < g_queued; ++i) {
+        RPG_WatchEvent* e = &g_queue[i];
+        if (e->watch_id == id && e->actor_id == actor_id && strcmp(e->key, key) == 0) {
+            e->new_value = new_v;   /* 元の値は最初のイベントのまま */
+            return;
+        }
+    }
+    if (g_queued >= RPG_WATCH_QUEUE) { g_reset = true; return; }
+    RPG_WatchEvent* e = &g_queue[g_queued++];
+    e->watch_id  = id;
+    e->kind      = kind;
+    e->actor_id  = actor_id;
+    strncpy(e->key, key, RPG_KEY_LEN - 1);
+    e->key[RPG_KEY_LEN - 1] = '\0';
+    e->old_value = old_v;
+    e->new_value = new_v;
+}
+
+static bool key_matches(const Watch* w, const char* key) {
+    return w->prefix ? strncmp(key, w->pattern, w->len) == 0 : strcmp(key, w->pattern) == 0;
+}
+
+static void key_changed(RPG_WatchKind kind, const char* key, double old_v, double new_v) {
+    for (int id = 1; id <= g_watch_count; ++id) {
+        const Watch* w = &g_watches[id];
+        if (w->used && w->kind == kind && key_matches(w, key))
+            push(id, kind, 0, key, old_v, new_v);
+    }
+}
+
+/* 書き込み口から (eng_save.c)。値が変わったときだけ呼ばれる */
+void rpg_watch_flag_changed(const char* key, bool old_v, bool new_v) {
+    if (g_watch_count) key_changed(RPG_WATCH_FLAG, key, old_v, new_v);
+}
+void rpg_watch_var_changed(const char* key, double old_v, double new_v) {
+    if (g_watch_count) key_changed(RPG_WATCH_VAR, key, old_v, new_v);
+}
+/* ロード/復元などで一括して書き換わった。積まれた値は当てにならないので捨てる */
+void rpg_watch_reset(void) {
+    if (!g_watch_count) return;
+    g_reset  = true;
+    g_queued = 0;
+}
+
+/* ── 取り出し ───────────────────────────────────────────*/
+static void poll_actors(void) {
+    for (int id = 1; id <= g_watch_count; ++id) {
+        Watch* w = &g_watches[id];
+        if (!w->used || w->kind != RPG_WATCH_ACTOR) continue;
+        const RPG_Actor* a = rpg_actor_peek(w->actor_id);
+        if (!a) continue;
+        if (a->hp != w->hp)         push(id, RPG_WATCH_ACTOR, w->actor_id, "hp", w->hp, a->hp);
+        if (a->alive != w->alive)   push(id, RPG_WATCH_ACTOR, w->actor_id, "alive", w->alive, a->alive);
+        if (a->status != w->status) push(id, RPG_WATCH_ACTOR, w->actor_id, "status", w->status, a->status);
+        w->hp     = a->hp;
+        w->alive  = a->alive;
+        w->status = a->status;
+    }
+}
+
+int rpg_watch_drain(RPG_WatchEvent* out, int max) {
+    if (!out || max <= 0 || !g_watch_count) return 0;
+    poll_actors();
+    int n = 0;
+    if (g_reset) {
+        memset(&out[n], 0, sizeof(out[n]));
+        out[n++].kind = RPG_WATCH_RESET;
+        g_reset = false;
+    }
+    int i = 0;
+    for (; i < g_queued && n < max; ++i) {
+        if (g_queue[i].old_value == g_queue[i].new_value) continue;   /* 元に戻った */
+        out[n++] = g_queue[i];
+    }
+    /* 入りきらなかった分は次回へ */
+    memmove(g_queue, g_queue + i, sizeof(g_queue[0]) * (size_t)(g_queued - i));
+    g_queued -= i;
+    return n;
+}
+
+int rpg_watch_pending(void) { return g_queued + (g_reset ? 1 : 0); }
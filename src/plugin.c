@@ -5,18 +5,25 @@
  */
 #include "hajimu_plugin.h"
 #include "eng_rpg.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* グローバルバトル・ダイアログをシングルトンで保持 */
+#if RPG_WITH_BATTLE
 static RPG_Battle g_battle;
-static RPG_Dialog g_dialog;
 static bool g_battle_init = false;
+#endif
+#if RPG_WITH_DIALOG
+static RPG_Dialog g_dialog;
 static bool g_dialog_init = false;
 
 static RPG_Dialog* dlg(void) {
     if (!g_dialog_init) { rpg_dialog_init(&g_dialog); g_dialog_init = true; }
     return &g_dialog;
 }
+#endif
 
 /* ── ヘルパーマクロ ─────────────────────────────────────*/
 #define ARG_NUM(i) ((i) < argc && args[(i)].type == VALUE_NUMBER ? args[(i)].number : 0.0)
@@ -47,25 +54,27 @@ static Value fn_スキル登録(int argc, Value* args) {
     return NUL;
 }
 static Value fn_キャラ名取得(int argc, Value* args) {
-    RPG_Actor* a = rpg_actor_get(ARG_INT(0));
+    const RPG_Actor* a = rpg_actor_peek(ARG_INT(0));
     return a ? STR(a->name) : STR("");
 }
-static Value fn_キャラHP取得(int argc, Value* args)     { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->hp:0); }
-static Value fn_キャラ最大HP取得(int argc, Value* args) { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->max_hp:0); }
-static Value fn_キャラMP取得(int argc, Value* args)     { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->mp:0); }
-static Value fn_キャラ最大MP取得(int argc, Value* args) { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->max_mp:0); }
-static Value fn_キャラATK取得(int argc, Value* args)    { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->atk:0); }
-static Value fn_キャラDEF取得(int argc, Value* args)    { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->def:0); }
-static Value fn_キャラSPD取得(int argc, Value* args)    { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->spd:0); }
-static Value fn_キャラLv取得(int argc, Value* args)     { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->level:0); }
-static Value fn_キャラEXP取得(int argc, Value* args)    { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return NUM(a?a->exp:0); }
-static Value fn_キャラ生存確認(int argc, Value* args)   { RPG_Actor* a=rpg_actor_get(ARG_INT(0)); return BVAL(a&&a->alive); }
+static Value fn_キャラHP取得(int argc, Value* args)     { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->hp:0); }
+static Value fn_キャラ最大HP取得(int argc, Value* args) { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->max_hp:0); }
+static Value fn_キャラMP取得(int argc, Value* args)     { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->mp:0); }
+static Value fn_キャラ最大MP取得(int argc, Value* args) { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->max_mp:0); }
+static Value fn_キャラATK取得(int argc, Value* args)    { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->atk:0); }
+static Value fn_キャラDEF取得(int argc, Value* args)    { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->def:0); }
+static Value fn_キャラSPD取得(int argc, Value* args)    { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->spd:0); }
+static Value fn_キャラLv取得(int argc, Value* args)     { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->level:0); }
+static Value fn_キャラEXP取得(int argc, Value* args)    { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return NUM(a?a->exp:0); }
+static Value fn_キャラ生存確認(int argc, Value* args)   { const RPG_Actor* a=rpg_actor_peek(ARG_INT(0)); return BVAL(a&&a->alive); }
 static Value fn_キャラHP設定(int argc, Value* args) {
     RPG_Actor* a = rpg_actor_get(ARG_INT(0));
     if (a) { a->hp = ARG_INT(1); if(a->hp>a->max_hp) a->hp=a->max_hp; if(a->hp<=0){a->hp=0;a->alive=false;} }
     return NUL;
 }
+#if RPG_WITH_BATTLE
 static Value fn_経験値付与(int argc, Value* args) { rpg_gain_exp(ARG_INT(0),ARG_INT(1)); return NUL; }
+#endif
 
 /* ── インベントリ ────────────────────────────────────────*/
 static Value fn_アイテム追加(int argc, Value* args)   { rpg_inventory_add(ARG_INT(0),ARG_INT(1)); return NUL; }
@@ -77,6 +86,38 @@ static Value fn_アイテム名取得(int argc, Value* args) {
     return it ? STR(it->name) : STR("");
 }
 
+/* ── DB 検索 ────────────────────────────────────────────
+ * 一覧系は該当 id を内部配列に取り込んで件数を返し、
+ * 検索結果(i) で i 番目の id を参照する (範囲外は 0)。
+ */
+static int g_find_ids[RPG_MAX_ITEMS];
+static int g_find_len = 0;
+
+static Value fn_アイテム検索種別(int argc, Value* args) {
+    g_find_len = rpg_item_find_by_type(ARG_INT(0), g_find_ids, RPG_MAX_ITEMS);
+    return NUM(g_find_len);
+}
+static Value fn_アイテム検索価格(int argc, Value* args) {
+    g_find_len = rpg_item_find_by_price(argc > 2 ? ARG_INT(2) : -1, ARG_INT(0), ARG_INT(1),
+                                        g_find_ids, RPG_MAX_ITEMS);
+    return NUM(g_find_len);
+}
+static Value fn_スキル検索対象(int argc, Value* args) {
+    g_find_len = rpg_skill_find_by_target(ARG_INT(0), g_find_ids, RPG_MAX_ITEMS);
+    return NUM(g_find_len);
+}
+static Value fn_スキル検索MP(int argc, Value* args) {
+    g_find_len = rpg_skill_find_by_mp(argc > 2 ? ARG_INT(2) : -1, ARG_INT(0), ARG_INT(1),
+                                      g_find_ids, RPG_MAX_ITEMS);
+    return NUM(g_find_len);
+}
+static Value fn_検索結果(int argc, Value* args) {
+    int i = ARG_INT(0);
+    return (i >= 0 && i < g_find_len) ? NUM(g_find_ids[i]) : NUM(0);
+}
+static Value fn_アイテム名検索(int argc, Value* args) { return NUM(rpg_item_find_by_name(ARG_STR(0))); }
+
+#if RPG_WITH_BATTLE
 /* ── バトル ─────────────────────────────────────────────*/
 static Value fn_バトル開始(int argc, Value* args) {
     /* 引数: party_id1, party_id2, ..., 0, enemy_id1, ..., 0 */
@@ -112,12 +153,92 @@ static Value fn_バトル次アクター(int argc, Value* args){ return NUM(g_ba
 static Value fn_ダメージ計算(int argc, Value* args)  { return NUM(rpg_calc_damage(ARG_INT(0),ARG_INT(1))); }
 static Value fn_バトルターン(int argc, Value* args)  { return NUM(g_battle_init ? g_battle.turn : 0); }
 static Value fn_最後ダメージ(int argc, Value* args)  { return NUM(g_battle_init ? g_battle.last_damage : 0); }
+static Value fn_バトルシード(int argc, Value* args)  { rpg_battle_seed((uint64_t)ARG_NUM(0)); return NUL; }
+
+/* ── ダメージ式 ──────────────────────────────────────────
+ * ダメージ式一括(攻撃者, スキル[, 対象...]) は対象ごとのダメージを
+ * 内部配列に取り込んで件数を返す。対象を省くと現在のバトルの敵全員。
+ * 結果は ダメージ式結果(i) で参照する。
+ */
+#define DMG_BATCH_MAX 16
+static int g_dmg_batch[DMG_BATCH_MAX];
+static int g_dmg_batch_len = 0;
 
+static Value fn_ダメージ式設定(int argc, Value* args) {
+    return BVAL(rpg_damage_formula_set(argc > 1 ? ARG_INT(1) : 0, ARG_STR(0)));
+}
+static Value fn_ダメージ式計算(int argc, Value* args) {
+    return NUM(rpg_damage_compute(rpg_actor_peek(ARG_INT(0)), rpg_actor_peek(ARG_INT(1)),
+                                  argc > 2 ? ARG_INT(2) : 0));
+}
+static Value fn_ダメージ式一括(int argc, Value* args) {
+    const RPG_Actor* targets[DMG_BATCH_MAX];
+    int n = 0;
+    if (argc > 2) {
+        for (int i = 2; i < argc && n < DMG_BATCH_MAX; ++i) targets[n++] = rpg_actor_peek(ARG_INT(i));
+    } else if (g_battle_init) {
+        for (int i = 0; i < g_battle.enemy_size; ++i) targets[n++] = rpg_actor_peek(g_battle.enemy[i]);
+    }
+    rpg_damage_compute_batch(rpg_actor_peek(ARG_INT(0)), targets, n, ARG_INT(1), g_dmg_batch);
+    g_dmg_batch_len = n;
+    return NUM(n);
+}
+static Value fn_ダメージ式結果(int argc, Value* args) {
+    int i = ARG_INT(0);
+    return (i >= 0 && i < g_dmg_batch_len) ? NUM(g_dmg_batch[i]) : NUM(0);
+}
+
+/* ── ダメージ分布 / 撃破確率 ──────────────────────────────*/
+static Value fn_ダメージ確率(int argc, Value* args) {
+    RPG_DamagePMF pmf;
+    if (!rpg_damage_pmf(rpg_actor_peek(ARG_INT(0)), rpg_actor_peek(ARG_INT(1)), ARG_INT(2), &pmf)) return NUM(0);
+    double p = rpg_damage_pmf_at_least(&pmf, ARG_INT(3));
+    rpg_damage_pmf_free(&pmf);
+    return NUM(p);
+}
+static Value fn_ダメージ期待値(int argc, Value* args) {
+    RPG_DamagePMF pmf;
+    if (!rpg_damage_pmf(rpg_actor_peek(ARG_INT(0)), rpg_actor_peek(ARG_INT(1)),
+                        argc > 2 ? ARG_INT(2) : 0, &pmf)) return NUM(0);
+    double m = rpg_damage_pmf_mean(&pmf);
+    rpg_damage_pmf_free(&pmf);
+    return NUM(m);
+}
+static Value fn_撃破確率(int argc, Value* args) {
+    const RPG_Actor* t = rpg_actor_peek(ARG_INT(1));
+    RPG_DamagePMF pmf;
+    if (!t || !rpg_damage_pmf(rpg_actor_peek(ARG_INT(0)), t, ARG_INT(2), &pmf)) return NUM(0);
+    double p = rpg_kill_probability(&pmf, t->hp, ARG_INT(3));
+    rpg_damage_pmf_free(&pmf);
+    return NUM(p);
+}
+/* 現在のパーティ全員が毎ターン同じスキル (省略時は通常攻撃) で攻撃した場合 */
+static Value fn_パーティ撃破確率(int argc, Value* args) {
+    int party[RPG_PARTY_MGR_MAX], skills[RPG_PARTY_MGR_MAX];
+    int n = rpg_party_size(), turns = ARG_INT(1);
+    if (n > RPG_PARTY_MGR_MAX) n = RPG_PARTY_MGR_MAX;
+    if (turns < 1) return NUM(0);
+    for (int i = 0; i < n; ++i) { party[i] = rpg_party_get(i); skills[i] = argc > 2 ? ARG_INT(2) : 0; }
+    double* curve = malloc(sizeof(double) * (size_t)turns);
+    double p = (curve && rpg_kill_curve(party, skills, n, ARG_INT(0), turns, curve)) ? curve[turns - 1] : 0;
+    free(curve);
+    return NUM(p);
+}
+#endif /* RPG_WITH_BATTLE */
+
+#if RPG_WITH_DIALOG
 /* ── ダイアログ ─────────────────────────────────────────*/
 static Value fn_メッセージ追加(int argc, Value* args) {
     rpg_dialog_push(dlg(), ARG_STR(0), argc>1?ARG_STR(1):"");
     return NUL;
 }
+static Value fn_メッセージ一括追加(int argc, Value* args) {
+    /* 改行区切りで 1 行 1 メッセージ。"話者\t本文" の行は行ごとに話者を指定 */
+    return NUM(rpg_dialog_push_lines(dlg(), ARG_STR(0), argc>1?ARG_STR(1):""));
+}
+static Value fn_メッセージクリア(int argc, Value* args) {
+    (void)argc;(void)args; rpg_dialog_clear(dlg()); return NUL;
+}
 static Value fn_メッセージ更新(int argc, Value* args) {
     rpg_dialog_update(dlg(), ARG_F(0)); return NUL;
 }
@@ -129,10 +250,16 @@ static Value fn_メッセージ速度設定(int argc, Value* args) {
 static Value fn_現在メッセージ取得(int argc, Value* args) {
     const RPG_DialogMsg* m = rpg_dialog_current(dlg());
     if (!m) return STR("");
-    /* char_pos 文字分だけ返す */
-    static char buf[RPG_MSG_MAX_LEN];
-    int n = m->char_pos < RPG_MSG_MAX_LEN ? m->char_pos : RPG_MSG_MAX_LEN-1;
-    strncpy(buf, m->text, n); buf[n] = '\0';
+    /* char_pos 文字分だけ返す (本文長に合わせてバッファを広げる) */
+    static char*  buf = NULL;
+    static size_t buf_cap = 0;
+    size_t n = (size_t)m->char_pos;
+    if (n + 1 > buf_cap) {
+        char* nb = realloc(buf, n + 1);
+        if (!nb) return STR("");
+        buf = nb; buf_cap = n + 1;
+    }
+    memcpy(buf, m->text, n); buf[n] = '\0';
     return STR(buf);
 }
 static Value fn_現在話者取得(int argc, Value* args) {
@@ -143,6 +270,7 @@ static Value fn_メッセージ完了(int argc, Value* args) {
     const RPG_DialogMsg* m = rpg_dialog_current(dlg());
     return BVAL(m && m->finished);
 }
+#endif /* RPG_WITH_DIALOG */
 
 /* ── フラグ・変数 ────────────────────────────────────────*/
 static Value fn_フラグ設定(int argc, Value* args) { rpg_flag_set(ARG_STR(0),ARG_B(1)); return NUL; }
@@ -150,11 +278,109 @@ static Value fn_フラグ取得(int argc, Value* args) { return BVAL(rpg_flag_ge
 static Value fn_変数設定(int argc, Value* args)   { rpg_var_set(ARG_STR(0),ARG_NUM(1)); return NUL; }
 static Value fn_変数取得(int argc, Value* args)   { return NUM(rpg_var_get(ARG_STR(0))); }
 
+/* 変更監視
+ * 監視取得() で溜まったイベントを内部配列に取り込み、監視イベントキー(i) などで参照する。
+ */
+static RPG_WatchEvent g_watch_ev[RPG_WATCH_QUEUE + 1];
+static int            g_watch_ev_len = 0;
+
+static Value fn_フラグ監視(int argc, Value* args)     { return NUM(rpg_watch_flag(ARG_STR(0))); }
+static Value fn_変数監視(int argc, Value* args)       { return NUM(rpg_watch_var(ARG_STR(0))); }
+static Value fn_アクター監視(int argc, Value* args)   { return NUM(rpg_watch_actor(ARG_INT(0))); }
+static Value fn_監視解除(int argc, Value* args)       { rpg_watch_remove(ARG_INT(0)); return NUL; }
+static Value fn_監視取得(int argc, Value* args) {
+    (void)argc;(void)args;
+    g_watch_ev_len = rpg_watch_drain(g_watch_ev, RPG_WATCH_QUEUE + 1);
+    return NUM(g_watch_ev_len);
+}
+static const RPG_WatchEvent* watch_ev_at(int i) { return (i >= 0 && i < g_watch_ev_len) ? &g_watch_ev[i] : NULL; }
+static Value fn_監視イベントID(int argc, Value* args)     { const RPG_WatchEvent* e = watch_ev_at(ARG_INT(0)); return NUM(e ? e->watch_id : 0); }
+static Value fn_監視イベント種別(int argc, Value* args)   { const RPG_WatchEvent* e = watch_ev_at(ARG_INT(0)); return NUM(e ? (int)e->kind : -1); }
+static Value fn_監視イベントキー(int argc, Value* args)   { const RPG_WatchEvent* e = watch_ev_at(ARG_INT(0)); return STR(e ? e->key : ""); }
+static Value fn_監視イベントアクター(int argc, Value* args) { const RPG_WatchEvent* e = watch_ev_at(ARG_INT(0)); return NUM(e ? e->actor_id : 0); }
+static Value fn_監視イベント旧値(int argc, Value* args)   { const RPG_WatchEvent* e = watch_ev_at(ARG_INT(0)); return NUM(e ? e->old_value : 0); }
+static Value fn_監視イベント新値(int argc, Value* args)   { const RPG_WatchEvent* e = watch_ev_at(ARG_INT(0)); return NUM(e ? e->new_value : 0); }
+
+/* クエスト
+ * クエスト新規(状態) で前回からその状態になったクエストを内部配列に取り込み、
+ * クエスト結果(i) で参照する。
+ */
+static int g_quest_ids[RPG_MAX_QUESTS];
+static int g_quest_ids_len = 0;
+
+static Value fn_クエスト定義(int argc, Value* args) {
+    return BVAL(rpg_quest_define(ARG_INT(0), ARG_STR(1), ARG_STR(2), argc > 3 ? ARG_STR(3) : ""));
+}
+static Value fn_クエスト開始(int argc, Value* args) { return BVAL(rpg_quest_start(ARG_INT(0))); }
+static Value fn_クエスト完了(int argc, Value* args) { return BVAL(rpg_quest_complete(ARG_INT(0))); }
+static Value fn_クエスト状態(int argc, Value* args) { return NUM(rpg_quest_state(ARG_INT(0))); }
+static Value fn_クエスト名(int argc, Value* args)   { return STR(rpg_quest_name(ARG_INT(0))); }
+static Value fn_クエスト更新(int argc, Value* args) { (void)argc;(void)args; return NUM(rpg_quest_update()); }
+static Value fn_クエスト新規(int argc, Value* args) {
+    g_quest_ids_len = rpg_quest_newly((RPG_QuestState)ARG_INT(0), g_quest_ids, RPG_MAX_QUESTS);
+    return NUM(g_quest_ids_len);
+}
+static Value fn_クエスト結果(int argc, Value* args) {
+    int i = ARG_INT(0);
+    return NUM(i >= 0 && i < g_quest_ids_len ? g_quest_ids[i] : 0);
+}
+
 /* ── セーブ/ロード ────────────────────────────────────────*/
 static Value fn_セーブ(int argc, Value* args)        { return BVAL(rpg_save(ARG_INT(0))); }
 static Value fn_ロード(int argc, Value* args)        { return BVAL(rpg_load(ARG_INT(0))); }
 static Value fn_セーブ存在確認(int argc, Value* args) { return BVAL(rpg_save_exists(ARG_INT(0))); }
 static Value fn_セーブ削除(int argc, Value* args)    { rpg_save_delete(ARG_INT(0)); return NUL; }
+static Value fn_スナップショット保存(int argc, Value* args) { (void)argc;(void)args; return NUM(rpg_snapshot_take()); }
+static Value fn_スナップショット復元(int argc, Value* args) { return BVAL(rpg_snapshot_restore(ARG_INT(0))); }
+static Value fn_スナップショット戻す(int argc, Value* args) { return BVAL(rpg_snapshot_undo(argc > 0 ? ARG_INT(0) : 1)); }
+static Value fn_スナップショット削除(int argc, Value* args) { rpg_snapshot_drop(ARG_INT(0)); return NUL; }
+static Value fn_スナップショット数(int argc, Value* args)   { (void)argc;(void)args; return NUM(rpg_snapshot_count()); }
+static Value fn_スナップショット上限(int argc, Value* args) { rpg_snapshot_set_limit(ARG_INT(0)); return NUL; }
+static Value fn_状態ハッシュ(int argc, Value* args) {
+    (void)argc;(void)args;
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)rpg_state_hash());
+    return STR(buf);
+}
+static Value fn_状態ハッシュ検査(int argc, Value* args) { (void)argc;(void)args; return NUM(rpg_state_hash_check()); }
+static Value fn_メモリ使用量(int argc, Value* args) {
+    RPG_MemUsage u[32];
+    int n = rpg_memory_report(u, 32);
+    if (argc == 0) return NUM((double)rpg_memory_total());
+    for (int i = 0; i < n; ++i)
+        if (strcmp(u[i].name, ARG_STR(0)) == 0) return NUM((double)u[i].bytes);
+    return NUM(0);
+}
+static Value fn_メモリ表示(int argc, Value* args) {
+    (void)argc;(void)args;
+    RPG_MemUsage u[32];
+    int n = rpg_memory_report(u, 32);
+    size_t total = 0;
+    for (int i = 0; i < n; ++i) {
+        printf("[RPG] %-16s %10zu bytes\n", u[i].name, u[i].bytes);
+        total += u[i].bytes;
+    }
+    printf("[RPG] %-16s %10zu bytes\n", "total", total);
+    return NUL;
+}
+static Value fn_セーブ圧縮設定(int argc, Value* args) { rpg_save_set_compress(ARG_B(0)); return NUL; }
+static Value fn_セーブ場所設定(int argc, Value* args)   { rpg_save_set_location(ARG_STR(0)); return NUL; }
+static Value fn_プレイ時間設定(int argc, Value* args)   { rpg_save_set_playtime((uint32_t)ARG_INT(0)); return NUL; }
+
+/* セーブ一覧 (i = 0〜セーブ一覧件数()-1、スロット番号の昇順) */
+static Value fn_セーブ一覧件数(int argc, Value* args)   { (void)argc;(void)args; return NUM(rpg_save_catalog_count()); }
+static Value fn_セーブ一覧更新(int argc, Value* args)   { (void)argc;(void)args; rpg_save_catalog_reload(); return NUM(rpg_save_catalog_count()); }
+static Value fn_セーブ一覧スロット(int argc, Value* args) { const RPG_SaveInfo* s=rpg_save_catalog_get(ARG_INT(0)); return NUM(s?s->slot:-1); }
+static Value fn_セーブ一覧日時(int argc, Value* args)   { const RPG_SaveInfo* s=rpg_save_catalog_get(ARG_INT(0)); return NUM(s?(double)s->timestamp:0); }
+static Value fn_セーブ一覧プレイ時間(int argc, Value* args){ const RPG_SaveInfo* s=rpg_save_catalog_get(ARG_INT(0)); return NUM(s?s->playtime:0); }
+static Value fn_セーブ一覧ゴールド(int argc, Value* args) { const RPG_SaveInfo* s=rpg_save_catalog_get(ARG_INT(0)); return NUM(s?s->gold:0); }
+static Value fn_セーブ一覧場所(int argc, Value* args)   { const RPG_SaveInfo* s=rpg_save_catalog_get(ARG_INT(0)); return STR(s?s->location:""); }
+static Value fn_セーブ一覧人数(int argc, Value* args)   { const RPG_SaveInfo* s=rpg_save_catalog_get(ARG_INT(0)); return NUM(s?s->party_count:0); }
+static Value fn_セーブ一覧レベル(int argc, Value* args) {
+    const RPG_SaveInfo* s = rpg_save_catalog_get(ARG_INT(0));
+    int m = ARG_INT(1);
+    return NUM((s && m >= 0 && m < s->party_count) ? s->party_level[m] : 0);
+}
 
 /* ── ゴールド ────────────────────────────────────────────*/
 static Value fn_ゴールド取得(int argc, Value* args) { return NUM(rpg_gold_get()); }
@@ -162,10 +388,95 @@ static Value fn_ゴールド設定(int argc, Value* args) { rpg_gold_set(ARG_INT
 static Value fn_ゴールド加算(int argc, Value* args) { rpg_gold_add(ARG_INT(0)); return NUL; }
 static Value fn_ゴールド消費(int argc, Value* args) { return BVAL(rpg_gold_spend(ARG_INT(0))); }
 
+#if RPG_WITH_SHOP
 /* ── ショップ ────────────────────────────────────────────*/
 static Value fn_アイテム購入(int argc, Value* args) { return BVAL(rpg_shop_buy(ARG_INT(0),ARG_INT(1))); }
 static Value fn_アイテム売却(int argc, Value* args) { return BVAL(rpg_shop_sell(ARG_INT(0),ARG_INT(1))); }
 
+/* ── 取引 ────────────────────────────────────────────────
+ * 取引開始() → 取引購入/売却/ゴールド/アイテム追加/アイテム削除 を積み、
+ * 取引確定() でまとめて適用 (0=成功, それ以外は RPG_TxnResult)。
+ */
+static RPG_Txn g_txn;
+static Value fn_取引開始(int argc, Value* args)         { (void)argc;(void)args; rpg_txn_begin(&g_txn); return NUL; }
+static Value fn_取引購入(int argc, Value* args)         { return BVAL(rpg_txn_buy(&g_txn, ARG_INT(0), ARG_INT(1))); }
+static Value fn_取引売却(int argc, Value* args)         { return BVAL(rpg_txn_sell(&g_txn, ARG_INT(0), ARG_INT(1))); }
+static Value fn_取引ゴールド(int argc, Value* args) {
+    /* NaN や範囲外の double を整数へキャストすると未定義動作なので先に弾く。
+     * 所持金は int なので ±INT_MAX を超える増減はどのみち成立しない */
+    double v = ARG_NUM(0);
+    if (!(v >= -(double)INT_MAX && v <= (double)INT_MAX)) {
+        g_txn.error = RPG_TXN_ERR_ARG; g_txn.error_index = g_txn.count;
+        return BVAL(false);
+    }
+    return BVAL(rpg_txn_gold(&g_txn, (int64_t)v));
+}
+static Value fn_取引アイテム追加(int argc, Value* args) { return BVAL(rpg_txn_item_add(&g_txn, ARG_INT(0), ARG_INT(1))); }
+static Value fn_取引アイテム削除(int argc, Value* args) { return BVAL(rpg_txn_item_remove(&g_txn, ARG_INT(0), ARG_INT(1))); }
+static Value fn_取引検証(int argc, Value* args)         { (void)argc;(void)args; return NUM(rpg_txn_validate(&g_txn)); }
+static Value fn_取引確定(int argc, Value* args)         { (void)argc;(void)args; return NUM(rpg_txn_commit(&g_txn)); }
+static Value fn_取引取消(int argc, Value* args)         { (void)argc;(void)args; rpg_txn_rollback(&g_txn); return NUL; }
+static Value fn_取引金額(int argc, Value* args)         { (void)argc;(void)args; return NUM((double)rpg_txn_gold_delta(&g_txn)); }
+static Value fn_取引エラー位置(int argc, Value* args)   { (void)argc;(void)args; return NUM(g_txn.error_index); }
+#endif /* RPG_WITH_SHOP */
+
+/* ── 抽選テーブル ────────────────────────────────────────
+ * フラグ引数は "" で無条件、"!キー" でフラグが偽のときだけ有効。
+ * テーブル検証(id, 回数) で行ごとの当選回数を集計し、
+ * テーブル検証結果(行) で参照する。
+ */
+static int g_table_hits[RPG_TABLE_ROWS];
+static int g_table_hit_len = 0;
+
+static Value fn_テーブル初期化(int argc, Value* args) { rpg_table_clear(ARG_INT(0)); return NUL; }
+static Value fn_テーブル敵追加(int argc, Value* args) {
+    int enemy[RPG_PARTY_MAX + 1] = {0};
+    for (int i = 3, n = 0; i < argc && n < RPG_PARTY_MAX; ++i) {
+        int id = ARG_INT(i);
+        if (id == 0) break;
+        enemy[n++] = id;
+    }
+    return NUM(rpg_table_add_enemies(ARG_INT(0), ARG_INT(1), enemy, ARG_STR(2)));
+}
+static Value fn_テーブルアイテム追加(int argc, Value* args) {
+    return NUM(rpg_table_add_item(ARG_INT(0), ARG_INT(1), ARG_INT(2), ARG_INT(3), ARG_INT(4),
+                                  argc > 5 ? ARG_STR(5) : NULL));
+}
+static Value fn_テーブルゴールド追加(int argc, Value* args) {
+    return NUM(rpg_table_add_gold(ARG_INT(0), ARG_INT(1), ARG_INT(2), ARG_INT(3),
+                                  argc > 4 ? ARG_STR(4) : NULL));
+}
+static Value fn_テーブルなし追加(int argc, Value* args) {
+    return NUM(rpg_table_add_none(ARG_INT(0), ARG_INT(1), argc > 2 ? ARG_STR(2) : NULL));
+}
+static Value fn_テーブル抽選(int argc, Value* args)   { return NUM(rpg_table_roll(ARG_INT(0))); }
+static Value fn_テーブルシード(int argc, Value* args) { rpg_table_seed((uint64_t)ARG_NUM(0)); return NUL; }
+#if RPG_WITH_BATTLE
+/* 敵グループの行が当たったら現在のパーティでバトルを開始する */
+static Value fn_エンカウント(int argc, Value* args) {
+    int party[RPG_PARTY_MAX + 1] = {0};
+    int n = rpg_party_size();
+    if (n > RPG_PARTY_MAX) n = RPG_PARTY_MAX;
+    for (int i = 0; i < n; ++i) party[i] = rpg_party_get(i);
+    int row = rpg_encounter_roll(ARG_INT(0), &g_battle, party);
+    if (row >= 0 && rpg_table_row_kind(ARG_INT(0), row) == RPG_ROW_ENEMIES) g_battle_init = true;
+    return NUM(row);
+}
+#endif
+static Value fn_ドロップ適用(int argc, Value* args) {
+    int gold = 0;
+    rpg_loot_apply(ARG_INT(0), argc > 1 ? ARG_INT(1) : 1, &gold);
+    return NUM(gold);
+}
+static Value fn_テーブル検証(int argc, Value* args) {
+    g_table_hit_len = rpg_table_roll_batch(ARG_INT(0), ARG_INT(1), g_table_hits);
+    return NUM(g_table_hit_len);
+}
+static Value fn_テーブル検証結果(int argc, Value* args) {
+    int i = ARG_INT(0);
+    return (i >= 0 && i < g_table_hit_len) ? NUM(g_table_hits[i]) : NUM(0);
+}
+
 /* ── 状態異常 ────────────────────────────────────────────*/
 static Value fn_状態異常追加(int argc, Value* args) { rpg_actor_add_status(ARG_INT(0),(RPG_Status)ARG_INT(1)); return NUL; }
 static Value fn_状態異常取得(int argc, Value* args) { return NUM(rpg_actor_get_status(ARG_INT(0))); }
@@ -203,7 +514,7 @@ static Value fn_MP回復(int argc, Value* args) { rpg_actor_heal_mp(ARG_INT(0),A
  * インベントリ更新() でキャッシュを構築し件数を返す。
  * その後 インベントリアイテムID(i), インベントリ数量取得(i) で参照。
  */
-#define INV_BUF_MAX 64
+#define INV_BUF_MAX RPG_MAX_INVENTORY
 static int g_inv_ids[INV_BUF_MAX];
 static int g_inv_cnts[INV_BUF_MAX];
 static int g_inv_len = 0;
@@ -241,11 +552,36 @@ static Value fn_アイテム使用(int argc, Value* args) {
     return BVAL(rpg_item_use(ARG_INT(0), ARG_INT(1)));
 }
 
+#if RPG_WITH_BATTLE
 /* 敵AI */
 static Value fn_敵自動行動(int argc, Value* args) {
     return NUM(rpg_battle_enemy_auto_action(&g_battle, ARG_INT(0)));
 }
 
+/* パーティ AI
+ * AI計画() で全員分の行動を決めて内部配列に取り込み、AI計画行動(i) などで参照する。
+ */
+static RPG_AIChoice g_ai_plan[RPG_PARTY_MAX];
+static int          g_ai_plan_len = 0;
+
+static Value fn_パーティ自動行動(int argc, Value* args) {
+    (void)argc;(void)args;
+    return NUM(g_battle_init ? rpg_ai_party_turn(&g_battle) : 0);
+}
+static Value fn_AI重み設定(int argc, Value* args) { return BVAL(rpg_ai_set_weight(ARG_STR(0), (float)ARG_NUM(1))); }
+static Value fn_AI計画(int argc, Value* args) {
+    (void)argc;(void)args;
+    g_ai_plan_len = g_battle_init ? rpg_ai_plan(&g_battle, g_ai_plan, RPG_PARTY_MAX) : 0;
+    return NUM(g_ai_plan_len);
+}
+static const RPG_AIChoice* ai_plan_at(int i) { return (i >= 0 && i < g_ai_plan_len) ? &g_ai_plan[i] : NULL; }
+static Value fn_AI計画アクター(int argc, Value* args)     { const RPG_AIChoice* c = ai_plan_at(ARG_INT(0)); return NUM(c ? c->actor_id : 0); }
+static Value fn_AI計画行動(int argc, Value* args)         { const RPG_AIChoice* c = ai_plan_at(ARG_INT(0)); return NUM(c ? (int)c->act : -1); }
+static Value fn_AI計画対象(int argc, Value* args)         { const RPG_AIChoice* c = ai_plan_at(ARG_INT(0)); return NUM(c ? c->target_id : 0); }
+static Value fn_AI計画パラメータ(int argc, Value* args)   { const RPG_AIChoice* c = ai_plan_at(ARG_INT(0)); return NUM(c ? c->param : 0); }
+#endif /* RPG_WITH_BATTLE */
+
+#if RPG_WITH_NOVEL
 /* ノベル: 背景 */
 static Value fn_ノベル背景設定(int argc, Value* args)  { rpg_novel_set_bg(ARG_STR(0)); return NUL; }
 static Value fn_ノベル背景取得(int argc, Value* args)  { (void)argc;(void)args; return hajimu_string(rpg_novel_get_bg()); }
@@ -273,90 +609,309 @@ static Value fn_ノベルログ追加(int argc, Value* args) {
 static Value fn_ノベルログ件数(int argc, Value* args) { (void)argc;(void)args; return NUM(rpg_novel_backlog_count()); }
 static Value fn_ノベルログ話者(int argc, Value* args)  { return hajimu_string(rpg_novel_backlog_speaker(ARG_INT(0))); }
 static Value fn_ノベルログテキスト(int argc, Value* args){ return hajimu_string(rpg_novel_backlog_text(ARG_INT(0))); }
+static Value fn_ノベルログクリア(int argc, Value* args)  { (void)argc;(void)args; rpg_novel_backlog_clear(); return NUL; }
+static Value fn_ノベルログ検索(int argc, Value* args) {
+    /* (語句, 開始位置, 方向) 方向<0 で古い方へ。開始位置<0 は端から */
+    return NUM(rpg_novel_backlog_find(ARG_STR(0), argc>1?ARG_INT(1):-1, argc>2?ARG_INT(2):1));
+}
+static Value fn_ノベルログ退避設定(int argc, Value* args) {
+    return BVAL(rpg_novel_backlog_set_spill(ARG_STR(0), argc>1?ARG_INT(1):4));
+}
+
+/* ノベル: バックログのページ取得
+ * ノベルログページ取得(開始, 件数) でページを複製して件数を返す。
+ * その後 ノベルログページ話者(i), ノベルログページテキスト(i) で参照。
+ */
+#define LOG_PAGE_MAX 64
+static char*  g_log_page_buf = NULL;
+static size_t g_log_page_cap = 0;
+static size_t g_log_page_off[LOG_PAGE_MAX][2];
+static int    g_log_page_len = 0;
+
+static Value fn_ノベルログページ取得(int argc, Value* args) {
+    RPG_BacklogLine lines[LOG_PAGE_MAX];
+    int n = ARG_INT(1);
+    if (n > LOG_PAGE_MAX) n = LOG_PAGE_MAX;
+    n = rpg_novel_backlog_range(ARG_INT(0), n, lines);
+    size_t need = 0;
+    for (int i = 0; i < n; ++i) need += strlen(lines[i].speaker) + strlen(lines[i].text) + 2;
+    if (need > g_log_page_cap) {
+        char* nb = realloc(g_log_page_buf, need);
+        if (!nb) { g_log_page_len = 0; return NUM(0); }
+        g_log_page_buf = nb; g_log_page_cap = need;
+    }
+    size_t off = 0;
+    for (int i = 0; i < n; ++i) {
+        size_t sl = strlen(lines[i].speaker) + 1, tl = strlen(lines[i].text) + 1;
+        memcpy(g_log_page_buf + off, lines[i].speaker, sl); g_log_page_off[i][0] = off; off += sl;
+        memcpy(g_log_page_buf + off, lines[i].text,    tl); g_log_page_off[i][1] = off; off += tl;
+    }
+    g_log_page_len = n;
+    return NUM(n);
+}
+static Value fn_ノベルログページ話者(int argc, Value* args) {
+    int i = ARG_INT(0);
+    return (i >= 0 && i < g_log_page_len) ? STR(g_log_page_buf + g_log_page_off[i][0]) : STR("");
+}
+static Value fn_ノベルログページテキスト(int argc, Value* args) {
+    int i = ARG_INT(0);
+    return (i >= 0 && i < g_log_page_len) ? STR(g_log_page_buf + g_log_page_off[i][1]) : STR("");
+}
+
+/* ── シナリオ ───────────────────────────────────────────
+ * シナリオ読込(テキスト) / シナリオファイル読込(パス) でコンパイルし、
+ * シナリオ実行() を入力待ちのたびに呼ぶ。ダイアログと選択肢は
+ * メッセージ系・選択肢系関数と同じシングルトンを使う。
+ */
+static RPG_Scenario* g_scenario = NULL;
+static char g_scenario_err[256];
+
+static Value scenario_replace(RPG_Scenario* sc) {
+    if (!sc) return BVAL(false);
+    rpg_scenario_free(g_scenario);
+    g_scenario = sc;
+    return BVAL(true);
+}
+static Value fn_シナリオ読込(int argc, Value* args) {
+    return scenario_replace(rpg_scenario_compile(ARG_STR(0), g_scenario_err, sizeof(g_scenario_err)));
+}
+static Value fn_シナリオファイル読込(int argc, Value* args) {
+    return scenario_replace(rpg_scenario_load(ARG_STR(0), g_scenario_err, sizeof(g_scenario_err)));
+}
+static Value fn_シナリオ実行(int argc, Value* args) {
+    (void)argc;(void)args;
+    return NUM(rpg_scenario_run(g_scenario, dlg(), rpg_global_choice()));
+}
+static Value fn_シナリオジャンプ(int argc, Value* args) { return BVAL(rpg_scenario_goto(g_scenario, ARG_STR(0))); }
+static Value fn_シナリオ位置取得(int argc, Value* args) { (void)argc;(void)args; return NUM(rpg_scenario_tell(g_scenario)); }
+static Value fn_シナリオ位置設定(int argc, Value* args) { return BVAL(rpg_scenario_seek(g_scenario, (uint32_t)ARG_INT(0))); }
+static Value fn_シナリオエラー(int argc, Value* args)   { (void)argc;(void)args; return STR(g_scenario_err); }
+#endif /* RPG_WITH_NOVEL */
+
+/* ── プロファイル ────────────────────────────────────────
+ * HAJIMU_RPG_PROFILE=1 で起動したときだけ計測ラッパーが入る (下の計測モード参照)。
+ */
+static bool g_prof_wrapped = false;
+
+static Value fn_プロファイル有効(int argc, Value* args) { (void)argc;(void)args; return BVAL(g_prof_wrapped); }
+static Value fn_プロファイル開始(int argc, Value* args) {
+    (void)argc;(void)args;
+    if (g_prof_wrapped) rpg_prof_enable(true);
+    return BVAL(g_prof_wrapped);
+}
+static Value fn_プロファイル停止(int argc, Value* args)   { (void)argc;(void)args; rpg_prof_enable(false); return NUL; }
+static Value fn_プロファイルリセット(int argc, Value* args){ (void)argc;(void)args; rpg_prof_reset(); return NUL; }
+static Value fn_プロファイル表示(int argc, Value* args)   { (void)argc;(void)args; rpg_prof_print(); return NUL; }
+static Value fn_プロファイルJSON出力(int argc, Value* args){ return BVAL(rpg_prof_write_json(ARG_STR(0))); }
+
+/* ── トレース ───────────────────────────────────────────*/
+static Value fn_トレース開始(int argc, Value* args) { (void)argc;(void)args; rpg_trace_enable(true);  return NUL; }
+static Value fn_トレース停止(int argc, Value* args) { (void)argc;(void)args; rpg_trace_enable(false); return NUL; }
+static Value fn_トレース出力(int argc, Value* args) { return BVAL(rpg_trace_write(ARG_STR(0))); }
 
 /* ── プラグイン登録 ─────────────────────────────────────*/
-#define FN(name, mn, mx) { #name, fn_##name, mn, mx }
-
-static HajimuPluginFunc funcs[] = {
-    /* データベース */
-    FN(キャラ登録,    7, 7), FN(アイテム登録, 6, 6), FN(スキル登録,  6, 6),
-    FN(キャラ名取得,  1, 1), FN(キャラHP取得,  1, 1), FN(キャラ最大HP取得, 1, 1),
-    FN(キャラMP取得,  1, 1), FN(キャラ最大MP取得, 1, 1),
-    FN(キャラATK取得, 1, 1), FN(キャラDEF取得, 1, 1), FN(キャラSPD取得, 1, 1),
-    FN(キャラLv取得,  1, 1), FN(キャラEXP取得, 1, 1), FN(キャラ生存確認, 1, 1),
-    FN(キャラHP設定,  2, 2), FN(経験値付与,    2, 2),
-    /* インベントリ */
-    FN(アイテム追加,   2, 2), FN(アイテム削除,   2, 2),
-    FN(アイテム所持数, 1, 1), FN(アイテム所持確認, 1, 1), FN(アイテム名取得, 1, 1),
-    /* バトル */
-    FN(バトル開始,     2, 8), FN(バトルアクション, 4, 4),
-    FN(バトル状態,     0, 0), FN(バトルメッセージ, 0, 0),
-    FN(バトル次アクター, 0, 0), FN(ダメージ計算, 2, 2),
-    FN(バトルターン,   0, 0),   FN(最後ダメージ, 0, 0),
-    /* ダイアログ */
-    FN(メッセージ追加,   1, 2), FN(メッセージ更新,  1, 1),
-    FN(メッセージ次へ,   0, 0), FN(メッセージ空,    0, 0),
-    FN(メッセージ速度設定, 1, 1),
-    FN(現在メッセージ取得, 0, 0), FN(現在話者取得,  0, 0), FN(メッセージ完了, 0, 0),
-    /* フラグ・変数 */
-    FN(フラグ設定, 2, 2), FN(フラグ取得, 1, 1),
-    FN(変数設定,   2, 2), FN(変数取得,   1, 1),
-    /* セーブ/ロード */
-    FN(セーブ,   1, 1), FN(ロード,   1, 1),
-    FN(セーブ存在確認, 1, 1), FN(セーブ削除, 1, 1),
-    /* ゴールド */
-    FN(ゴールド取得, 0, 0), FN(ゴールド設定, 1, 1),
-    FN(ゴールド加算, 1, 1), FN(ゴールド消費, 1, 1),
-    /* ショップ */
-    FN(アイテム購入, 2, 2), FN(アイテム売却, 2, 2),
-    /* 状態異常 */
-    FN(状態異常追加,   2, 2), FN(状態異常取得,   1, 1),
-    FN(状態異常確認,   2, 2), FN(状態異常回復,   2, 2),
-    FN(状態異常全回復, 1, 1), FN(状態異常経過,   1, 1),
-    /* 選択肢 */
-    FN(選択肢初期化, 0, 0), FN(選択肢追加, 1, 1), FN(選択肢選択, 1, 1),
-    FN(選択肢アクティブ, 0, 0), FN(選択済, 0, 0),
-    FN(選択肢テキスト, 1, 1), FN(選択肢数, 0, 0),
-    /* 装備 */
-    FN(装備設定, 3, 3), FN(装備取得, 2, 2), FN(装備ステータス適用, 1, 1),
-    /* スキル習得/忘却 */
-    FN(スキル習得,    2, 2), FN(スキル忘却,    2, 2), FN(スキル習得確認, 2, 2),
-    /* HP/MP 回復 */
-    FN(HP回復, 2, 2), FN(MP回復, 2, 2),
-    /* インベントリ一覧 */
-    FN(インベントリ更新,      0, 0),
-    FN(インベントリアイテムID, 1, 1),
-    FN(インベントリ数量取得,   1, 1),
-    /* v1.3.0 パーティ */
-    FN(パーティクリア,     0, 0),
-    FN(パーティ追加,       1, 1),
-    FN(パーティ除外,       1, 1),
-    FN(パーティ人数,       0, 0),
-    FN(パーティ取得,       1, 1),
-    FN(パーティ確認,       1, 1),
-    /* v1.3.0 アクター/アイテム */
-    FN(キャラステータス設定, 3, 3),
-    FN(アイテム使用,         2, 2),
-    /* v1.3.0 敵AI */
-    FN(敵自動行動,           1, 1),
-    /* v1.3.0 ノベル */
-    FN(ノベル背景設定,         1, 1),
-    FN(ノベル背景取得,         0, 0),
-    FN(ノベルキャラ設定,       2, 3),
-    FN(ノベルキャラパス,       1, 1),
-    FN(ノベルキャラ表情,       1, 1),
-    FN(ノベルキャラクリア,     1, 1),
-    FN(ノベルオート設定,       1, 1),
-    FN(ノベルオート取得,       0, 0),
-    FN(ノベルスキップ設定,     1, 1),
-    FN(ノベルスキップ取得,     0, 0),
-    FN(ノベルオート間隔設定,   1, 1),
-    FN(ノベルオート間隔取得,   0, 0),
-    FN(ノベルログ追加,         2, 2),
-    FN(ノベルログ件数,         0, 0),
-    FN(ノベルログ話者,         1, 1),
-    FN(ノベルログテキスト,     1, 1),
-};
+/* X(関数名, 最小引数, 最大引数)
+ * モジュールごとの表は RPG_WITH_* が 0 なら空になり、その関数は登録されない。 */
+#if RPG_WITH_BATTLE
+#define BATTLE_FUNCS(X) \
+    /* バトル */ \
+    X(経験値付与, 2, 2) \
+    X(バトル開始, 2, 8) X(バトルアクション, 4, 4) \
+    X(バトル状態, 0, 0) X(バトルメッセージ, 0, 0) \
+    X(バトル次アクター, 0, 0) X(ダメージ計算, 2, 2) \
+    X(バトルターン, 0, 0)   X(最後ダメージ, 0, 0) X(バトルシード, 1, 1) \
+    /* ダメージ式 */ \
+    X(ダメージ式設定, 1, 2) X(ダメージ式計算, 2, 3) \
+    X(ダメージ式一括, 2, 18) X(ダメージ式結果, 1, 1) \
+    /* ダメージ分布 / 撃破確率 */ \
+    X(ダメージ確率, 4, 4) X(ダメージ期待値, 2, 3) \
+    X(撃破確率, 4, 4) X(パーティ撃破確率, 2, 3) \
+    /* エンカウント */ \
+    X(エンカウント, 1, 1) \
+    /* v1.3.0 敵AI */ \
+    X(敵自動行動, 1, 1) \
+    /* パーティ AI */ \
+    X(パーティ自動行動, 0, 0) X(AI重み設定, 2, 2) X(AI計画, 0, 0) \
+    X(AI計画アクター, 1, 1) X(AI計画行動, 1, 1) X(AI計画対象, 1, 1) X(AI計画パラメータ, 1, 1)
+#else
+#define BATTLE_FUNCS(X)
+#endif
+#if RPG_WITH_DIALOG
+#define DIALOG_FUNCS(X) \
+    /* ダイアログ */ \
+    X(メッセージ追加, 1, 2) X(メッセージ更新, 1, 1) \
+    X(メッセージ一括追加, 1, 2) X(メッセージクリア, 0, 0) \
+    X(メッセージ次へ, 0, 0) X(メッセージ空, 0, 0) \
+    X(メッセージ速度設定, 1, 1) \
+    X(現在メッセージ取得, 0, 0) X(現在話者取得, 0, 0) X(メッセージ完了, 0, 0)
+#else
+#define DIALOG_FUNCS(X)
+#endif
+#if RPG_WITH_SHOP
+#define SHOP_FUNCS(X) \
+    /* ショップ */ \
+    X(アイテム購入, 2, 2) X(アイテム売却, 2, 2) \
+    /* 取引 */ \
+    X(取引開始, 0, 0) X(取引購入, 2, 2) X(取引売却, 2, 2) X(取引ゴールド, 1, 1) \
+    X(取引アイテム追加, 2, 2) X(取引アイテム削除, 2, 2) \
+    X(取引検証, 0, 0) X(取引確定, 0, 0) X(取引取消, 0, 0) \
+    X(取引金額, 0, 0) X(取引エラー位置, 0, 0)
+#else
+#define SHOP_FUNCS(X)
+#endif
+#if RPG_WITH_NOVEL
+#define NOVEL_FUNCS(X) \
+    /* v1.3.0 ノベル */ \
+    X(ノベル背景設定, 1, 1) \
+    X(ノベル背景取得, 0, 0) \
+    X(ノベルキャラ設定, 2, 3) \
+    X(ノベルキャラパス, 1, 1) \
+    X(ノベルキャラ表情, 1, 1) \
+    X(ノベルキャラクリア, 1, 1) \
+    X(ノベルオート設定, 1, 1) \
+    X(ノベルオート取得, 0, 0) \
+    X(ノベルスキップ設定, 1, 1) \
+    X(ノベルスキップ取得, 0, 0) \
+    X(ノベルオート間隔設定, 1, 1) \
+    X(ノベルオート間隔取得, 0, 0) \
+    X(ノベルログ追加, 2, 2) \
+    X(ノベルログ件数, 0, 0) \
+    X(ノベルログ話者, 1, 1) \
+    X(ノベルログテキスト, 1, 1) \
+    X(ノベルログクリア, 0, 0) \
+    X(ノベルログ検索, 1, 3) \
+    X(ノベルログ退避設定, 1, 2) \
+    X(ノベルログページ取得, 2, 2) \
+    X(ノベルログページ話者, 1, 1) \
+    X(ノベルログページテキスト, 1, 1) \
+    /* シナリオ */ \
+    X(シナリオ読込, 1, 1) \
+    X(シナリオファイル読込, 1, 1) \
+    X(シナリオ実行, 0, 0) \
+    X(シナリオジャンプ, 1, 1) \
+    X(シナリオ位置取得, 0, 0) \
+    X(シナリオ位置設定, 1, 1) \
+    X(シナリオエラー, 0, 0)
+#else
+#define NOVEL_FUNCS(X)
+#endif
+
+#define PLUGIN_FUNCS(X) \
+    /* データベース */ \
+    X(キャラ登録, 7, 7) X(アイテム登録, 6, 6) X(スキル登録, 6, 6) \
+    X(キャラ名取得, 1, 1) X(キャラHP取得, 1, 1) X(キャラ最大HP取得, 1, 1) \
+    X(キャラMP取得, 1, 1) X(キャラ最大MP取得, 1, 1) \
+    X(キャラATK取得, 1, 1) X(キャラDEF取得, 1, 1) X(キャラSPD取得, 1, 1) \
+    X(キャラLv取得, 1, 1) X(キャラEXP取得, 1, 1) X(キャラ生存確認, 1, 1) \
+    X(キャラHP設定, 2, 2) \
+    /* インベントリ */ \
+    X(アイテム追加, 2, 2) X(アイテム削除, 2, 2) \
+    X(アイテム所持数, 1, 1) X(アイテム所持確認, 1, 1) X(アイテム名取得, 1, 1) \
+    /* DB 検索 */ \
+    X(アイテム検索種別, 1, 1) X(アイテム検索価格, 2, 3) X(アイテム名検索, 1, 1) \
+    X(スキル検索対象, 1, 1) X(スキル検索MP, 2, 3) X(検索結果, 1, 1) \
+    BATTLE_FUNCS(X) \
+    DIALOG_FUNCS(X) \
+    /* フラグ・変数 */ \
+    X(フラグ設定, 2, 2) X(フラグ取得, 1, 1) \
+    X(変数設定, 2, 2) X(変数取得, 1, 1) \
+    /* 変更監視 */ \
+    X(フラグ監視, 1, 1) X(変数監視, 1, 1) X(アクター監視, 1, 1) X(監視解除, 1, 1) X(監視取得, 0, 0) \
+    X(監視イベントID, 1, 1) X(監視イベント種別, 1, 1) X(監視イベントキー, 1, 1) \
+    X(監視イベントアクター, 1, 1) X(監視イベント旧値, 1, 1) X(監視イベント新値, 1, 1) \
+    /* クエスト */ \
+    X(クエスト定義, 3, 4) X(クエスト開始, 1, 1) X(クエスト完了, 1, 1) X(クエスト状態, 1, 1) \
+    X(クエスト名, 1, 1) X(クエスト更新, 0, 0) X(クエスト新規, 1, 1) X(クエスト結果, 1, 1) \
+    /* セーブ/ロード */ \
+    X(セーブ, 1, 1) X(ロード, 1, 1) \
+    X(セーブ存在確認, 1, 1) X(セーブ削除, 1, 1) \
+    X(セーブ場所設定, 1, 1) X(プレイ時間設定, 1, 1) X(セーブ圧縮設定, 1, 1) \
+    X(メモリ使用量, 0, 1) X(メモリ表示, 0, 0) \
+    X(スナップショット保存, 0, 0) X(スナップショット復元, 1, 1) X(スナップショット戻す, 0, 1) \
+    X(スナップショット削除, 1, 1) X(スナップショット数, 0, 0) X(スナップショット上限, 1, 1) \
+    X(状態ハッシュ, 0, 0) X(状態ハッシュ検査, 0, 0) \
+    X(セーブ一覧件数, 0, 0) X(セーブ一覧更新, 0, 0) X(セーブ一覧スロット, 1, 1) \
+    X(セーブ一覧日時, 1, 1) X(セーブ一覧プレイ時間, 1, 1) X(セーブ一覧ゴールド, 1, 1) \
+    X(セーブ一覧場所, 1, 1) X(セーブ一覧人数, 1, 1) X(セーブ一覧レベル, 2, 2) \
+    /* ゴールド */ \
+    X(ゴールド取得, 0, 0) X(ゴールド設定, 1, 1) \
+    X(ゴールド加算, 1, 1) X(ゴールド消費, 1, 1) \
+    SHOP_FUNCS(X) \
+    /* 抽選テーブル */ \
+    X(テーブル初期化, 1, 1) X(テーブル敵追加, 4, 7) \
+    X(テーブルアイテム追加, 5, 6) X(テーブルゴールド追加, 4, 5) X(テーブルなし追加, 2, 3) \
+    X(テーブル抽選, 1, 1) X(テーブルシード, 1, 1) \
+    X(ドロップ適用, 1, 2) \
+    X(テーブル検証, 2, 2) X(テーブル検証結果, 1, 1) \
+    /* 状態異常 */ \
+    X(状態異常追加, 2, 2) X(状態異常取得, 1, 1) \
+    X(状態異常確認, 2, 2) X(状態異常回復, 2, 2) \
+    X(状態異常全回復, 1, 1) X(状態異常経過, 1, 1) \
+    /* 選択肢 */ \
+    X(選択肢初期化, 0, 0) X(選択肢追加, 1, 1) X(選択肢選択, 1, 1) \
+    X(選択肢アクティブ, 0, 0) X(選択済, 0, 0) \
+    X(選択肢テキスト, 1, 1) X(選択肢数, 0, 0) \
+    /* 装備 */ \
+    X(装備設定, 3, 3) X(装備取得, 2, 2) X(装備ステータス適用, 1, 1) \
+    /* スキル習得/忘却 */ \
+    X(スキル習得, 2, 2) X(スキル忘却, 2, 2) X(スキル習得確認, 2, 2) \
+    /* HP/MP 回復 */ \
+    X(HP回復, 2, 2) X(MP回復, 2, 2) \
+    /* インベントリ一覧 */ \
+    X(インベントリ更新, 0, 0) \
+    X(インベントリアイテムID, 1, 1) \
+    X(インベントリ数量取得, 1, 1) \
+    /* v1.3.0 パーティ */ \
+    X(パーティクリア, 0, 0) \
+    X(パーティ追加, 1, 1) \
+    X(パーティ除外, 1, 1) \
+    X(パーティ人数, 0, 0) \
+    X(パーティ取得, 1, 1) \
+    X(パーティ確認, 1, 1) \
+    /* v1.3.0 アクター/アイテム */ \
+    X(キャラステータス設定, 3, 3) \
+    X(アイテム使用, 2, 2) \
+    NOVEL_FUNCS(X) \
+    /* プロファイル */ \
+    X(プロファイル有効, 0, 0) \
+    X(プロファイル開始, 0, 0) \
+    X(プロファイル停止, 0, 0) \
+    X(プロファイルリセット, 0, 0) \
+    X(プロファイル表示, 0, 0) \
+    X(プロファイルJSON出力, 1, 1) \
+    /* トレース */ \
+    X(トレース開始, 0, 0) \
+    X(トレース停止, 0, 0) \
+    X(トレース出力, 1, 1)
+
+#define FN(name, mn, mx) { #name, fn_##name, mn, mx },
+
+static HajimuPluginFunc funcs[] = { PLUGIN_FUNCS(FN) };
+
+/* ── 計測モード ──────────────────────────────────────────
+ * 環境変数 HAJIMU_RPG_PROFILE が設定されていると、各関数を計測用の
+ * ラッパー経由で登録し、呼び出し回数とレイテンシを記録する。
+ * 未設定なら funcs[] をそのまま登録するため計測コストは掛からない。
+ */
+#define PROF_WRAP(name, mn, mx)                                   \
+    static int prof_id_##name = -1;                               \
+    static Value prof_##name(int argc, Value* args) {             \
+        if (!rpg_prof_enabled()) return fn_##name(argc, args);    \
+        uint64_t t0 = rpg_prof_now();                             \
+        Value v = fn_##name(argc, args);                          \
+        rpg_prof_record(prof_id_##name, rpg_prof_now() - t0);     \
+        return v;                                                 \
+    }
+#define PROF_FN(name, mn, mx)  { #name, prof_##name, mn, mx },
+#define PROF_REG(name, mn, mx) prof_id_##name = rpg_prof_register(#name);
+
+PLUGIN_FUNCS(PROF_WRAP)
+static HajimuPluginFunc prof_funcs[] = { PLUGIN_FUNCS(PROF_FN) };
+
+static bool prof_requested(void) {
+    const char* env = getenv("HAJIMU_RPG_PROFILE");
+    return env && *env && strcmp(env, "0") != 0;
+}
 
 HAJIMU_PLUGIN_EXPORT HajimuPluginInfo* hajimu_plugin_init(void) {
     static HajimuPluginInfo info = {
@@ -367,5 +922,11 @@ HAJIMU_PLUGIN_EXPORT HajimuPluginInfo* hajimu_plugin_init(void) {
         .functions      = funcs,
         .function_count = sizeof(funcs) / sizeof(funcs[0]),
     };
+    if (prof_requested() && info.functions != prof_funcs) {
+        PLUGIN_FUNCS(PROF_REG)
+        g_prof_wrapped = true;
+        rpg_prof_enable(true);
+        info.functions = prof_funcs;
+    }
     return &info;
 }
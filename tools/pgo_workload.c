@@ -0,0 +1,426 @@
+/**
+ * tools/pgo_workload.c — PGO 用の代表ワークロード / ベンチマーク
+ *
+ * はじむ本体の代わりにプラグイン (.hjp) を読み込み、関数表を経由して
+ * バトル・ダイアログ・フラグ/クエスト・インベントリ・セーブ/ロードを回し、
+ * 区間ごとの所要時間を表示する。RPG_PGO=GENERATE でビルドしたプラグインに
+ * 対して実行するとプロファイルが書き出される (README「LTO / PGO」参照)。
+ *
+ *   rpg_workload build/engine_rpg.hjp [倍率] [区間,...]
+ *
+ * 区間 (battle dialog state inventory save lockstep) を指定するとそれだけを回す。
+ * RPG_WITH_* で外したモジュールの区間は関数が無いので飛ばす。
+ *
+ * lockstep は同じシードのバトル列 (ドロップ抽選込み) を 2 回回して
+ * バトルごとの状態ハッシュを比べ、最後のハッシュを表示する。別のビルドの
+ * 表示と突き合わせればビルド間の一致も確かめられる (make lockstep)。不一致なら終了コード 1。
+ * セーブは一時ディレクトリを HOME にして書くので、利用者のセーブには触れない。
+ *
+ * Copyright (c) 2026 Reo Shiozawa — MIT License
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "hajimu_plugin.h"
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ── ホスト側の値コンストラクタ (本来ははじむ本体が提供する) ──*/
+Value hajimu_number(double v) { Value r; memset(&r, 0, sizeof(r)); r.type = VALUE_NUMBER; r.number = v;  return r; }
+Value hajimu_bool(bool v)     { Value r; memset(&r, 0, sizeof(r)); r.type = VALUE_BOOL;   r.boolean = v; return r; }
+Value hajimu_null(void)       { Value r; memset(&r, 0, sizeof(r)); r.type = VALUE_NULL;   return r; }
+Value hajimu_string(const char* s) {
+    Value r;
+    memset(&r, 0, sizeof(r));
+    r.type = VALUE_STRING;
+    r.string.data = (char*)(s ? s : "");
+    return r;
+}
+
+#define N(v) hajimu_number((double)(v))
+#define S(v) hajimu_string(v)
+#define B(v) hajimu_bool(v)
+
+/* ── 関数表 ─────────────────────────────────────────────*/
+static HajimuPluginInfo* g_info;
+
+static HajimuPluginFn fn(const char* name) {
+    for (int i = 0; i < g_info->function_count; ++i)
+        if (strcmp(g_info->functions[i].name, name) == 0) return g_info->functions[i].fn;
+    return NULL;
+}
+
+/* 区間に必要な関数をまとめて引く。1 つでも無ければ false (区間ごと飛ばす) */
+static bool need(HajimuPluginFn* out[], const char* names[], int n) {
+    for (int i = 0; i < n; ++i)
+        if (!(*out[i] = fn(names[i]))) return false;
+    return true;
+}
+
+/* ── 計時 ───────────────────────────────────────────────*/
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double g_total_ms = 0;
+
+static void report(const char* phase, long ops, double ms) {
+    g_total_ms += ms;
+    printf("  %-10s %9ld ops  %9.2f ms  %8.3f us/op\n", phase, ops, ms, ops ? ms * 1e3 / ops : 0.0);
+}
+
+static void skipped(const char* phase) { printf("  %-10s (モジュール無効のため省略)\n", phase); }
+
+static bool g_failed = false;
+
+static const char* g_only = NULL;   /* 区間の指定 (NULL なら全部) */
+
+static bool selected(const char* phase) {
+    if (!g_only) return true;
+    size_t n = strlen(phase);
+    for (const char* p = g_only; (p = strstr(p, phase)) != NULL; p += n)
+        if ((p == g_only || p[-1] == ',') && (p[n] == '\0' || p[n] == ',')) return true;
+    return false;
+}
+
+/* ── 区間 ───────────────────────────────────────────────*/
+#define PARTY_N 3   /* バトル開始 は 8 引数まで (3 人 + 区切り + 敵 4) */
+#define ENEMY_N 4
+#define ENEMY_ID0 11
+
+static void setup_world(void) {
+    HajimuPluginFn actor = fn("キャラ登録"), item = fn("アイテム登録"), skill = fn("スキル登録");
+    HajimuPluginFn add = fn("アイテム追加"), flag = fn("フラグ設定"), var = fn("変数設定");
+    char name[32];
+    for (int i = 1; i <= 40; ++i) {
+        snprintf(name, sizeof(name), "キャラ%d", i);
+        Value a[7] = { N(i), S(name), N(100 + i), N(30), N(12 + i % 7), N(6 + i % 5), N(5 + i % 11) };
+        actor(7, a);
+    }
+    for (int i = 1; i <= 64; ++i) {
+        snprintf(name, sizeof(name), "アイテム%d", i);
+        Value a[6] = { N(i), S(name), S("説明"), N(i % 3), N(10 + i), N(20 + i * 5) };
+        item(6, a);
+        if (i <= 8) { Value c[2] = { N(i), N(i % 9 + 1) }; add(2, c); }
+    }
+    HajimuPluginFn seed = fn("バトルシード");
+    if (seed) { Value a[1] = { N(1) }; seed(1, a); }   /* 全区間を通して再現できるように */
+    for (int i = 1; i <= 32; ++i) {
+        snprintf(name, sizeof(name), "スキル%d", i);
+        Value a[6] = { N(i), S(name), S("説明"), N(i % 8), N(10 + i), N(i % 4) };
+        skill(6, a);
+    }
+    for (int i = 0; i < 128; ++i) {
+        snprintf(name, sizeof(name), "world.flag%d", i);
+        Value f[2] = { S(name), B(i % 3 == 0) };
+        flag(2, f);
+        snprintf(name, sizeof(name), "world.var%d", i);
+        Value v[2] = { S(name), N(i * 7) };
+        var(2, v);
+    }
+}
+
+static void phase_battle(int scale) {
+    HajimuPluginFn actor, start, state, party, enemy, formula, hp;
+    HajimuPluginFn* outs[] = { &actor, &start, &state, &party, &enemy, &formula, &hp };
+    const char* names[] = { "キャラ登録", "バトル開始", "バトル状態", "パーティ自動行動",
+                            "敵自動行動", "ダメージ式計算", "キャラHP取得" };
+    if (!need(outs, names, 7)) { skipped("battle"); return; }
+    HajimuPluginFn set_formula = fn("ダメージ式設定");
+    Value fa[1] = { S("vary(max(a.atk*3 - t.def*2, 1), 10)") };
+    set_formula(1, fa);
+
+    long ops = 0;
+    double t0 = now_ms();
+    for (int b = 0; b < 400 * scale; ++b) {
+        /* 参加者を毎回登録し直して HP を戻す */
+        for (int i = 0; i < PARTY_N + ENEMY_N; ++i) {
+            int id = i < PARTY_N ? i + 1 : ENEMY_ID0 + i - PARTY_N;
+            Value a[7] = { N(id), S(i < PARTY_N ? "味方" : "敵"), N(i < PARTY_N ? 160 : 120), N(40),
+                           N(14 + i), N(8 + i % 3), N(6 + i) };
+            actor(7, a);
+        }
+        Value args[PARTY_N + ENEMY_N + 1];
+        int n = 0;
+        for (int i = 0; i < PARTY_N; ++i) args[n++] = N(i + 1);
+        args[n++] = N(0);
+        for (int i = 0; i < ENEMY_N; ++i) args[n++] = N(ENEMY_ID0 + i);
+        start(n, args);
+        for (int round = 0; round < 100 && state(0, NULL).number == 0; ++round) {
+            party(0, NULL);
+            for (int i = 0; i < ENEMY_N; ++i) { Value e[1] = { N(ENEMY_ID0 + i) }; enemy(1, e); }
+            for (int i = 0; i < ENEMY_N; ++i) {
+                Value d[2] = { N(1), N(ENEMY_ID0 + i) };
+                formula(2, d);
+                Value h[1] = { N(ENEMY_ID0 + i) };
+                hp(1, h);
+            }
+            ops++;
+        }
+    }
+    report("battle", ops, now_ms() - t0);
+}
+
+static void phase_dialog(int scale) {
+    HajimuPluginFn push, update, text, done, next, empty;
+    HajimuPluginFn* outs[] = { &push, &update, &text, &done, &next, &empty };
+    const char* names[] = { "メッセージ一括追加", "メッセージ更新", "現在メッセージ取得",
+                            "メッセージ完了", "メッセージ次へ", "メッセージ空" };
+    if (!need(outs, names, 6)) { skipped("dialog"); return; }
+    static const char* script =
+        "勇者\tここが魔王の城か……\n"
+        "魔法使い\t油断しないで。結界の気配がするわ\n"
+        "門番たちがこちらに気づいたようだ\n"
+        "勇者\t行くぞ！\n"
+        "門番\tここから先へは通さん！";
+    HajimuPluginFn log = fn("ノベルログ追加");
+    long ops = 0;
+    double t0 = now_ms();
+    for (int r = 0; r < 1500 * scale; ++r) {
+        Value a[2] = { S(script), S("ナレーター") };
+        push(2, a);
+        while (!empty(0, NULL).boolean) {
+            Value dt[1] = { N(1.0 / 60) };
+            while (!done(0, NULL).boolean) { update(1, dt); text(0, NULL); ops++; }
+            if (log) { Value l[2] = { S("話者"), S("バックログに残る台詞") }; log(2, l); }
+            next(0, NULL);
+        }
+    }
+    report("dialog", ops, now_ms() - t0);
+}
+
+static void phase_state(int scale) {
+    HajimuPluginFn fset, fget, vset, vget, qdef, qupd, wflag, wget;
+    HajimuPluginFn* outs[] = { &fset, &fget, &vset, &vget, &qdef, &qupd, &wflag, &wget };
+    const char* names[] = { "フラグ設定", "フラグ取得", "変数設定", "変数取得",
+                            "クエスト定義", "クエスト更新", "フラグ監視", "監視取得" };
+    if (!need(outs, names, 8)) { skipped("state"); return; }
+    char key[64], cond[96];
+    for (int q = 1; q <= 64; ++q) {
+        snprintf(cond, sizeof(cond), "%s", q == 1 ? "" : "done:1");
+        snprintf(key, sizeof(key), "var:world.var%d >= %d", q % 128, 200 + q);
+        Value a[4] = { N(q), S("クエスト"), S(cond), S(key) };
+        qdef(4, a);
+    }
+    HajimuPluginFn qstart = fn("クエスト開始");
+    Value q1[1] = { N(1) };
+    qupd(0, NULL);
+    if (qstart) qstart(1, q1);
+    Value w[1] = { S("world.flag1*") };
+    wflag(1, w);
+    long ops = 0;
+    double t0 = now_ms();
+    for (int i = 0; i < 60000 * scale; ++i) {
+        snprintf(key, sizeof(key), "world.flag%d", i % 128);
+        Value f[2] = { S(key), B((i / 128) & 1) };
+        fset(2, f);
+        fget(1, f);
+        snprintf(key, sizeof(key), "world.var%d", (i * 7) % 128);
+        Value v[2] = { S(key), N(i % 500) };
+        vset(2, v);
+        vget(1, v);
+        if (i % 16 == 0) { qupd(0, NULL); wget(0, NULL); }
+        ops++;
+    }
+    report("state", ops, now_ms() - t0);
+}
+
+static void phase_inventory(int scale) {
+    HajimuPluginFn add, del, count, list, gold;
+    HajimuPluginFn* outs[] = { &add, &del, &count, &list, &gold };
+    const char* names[] = { "アイテム追加", "アイテム削除", "アイテム所持数", "インベントリ更新", "ゴールド設定" };
+    if (!need(outs, names, 5)) { skipped("inventory"); return; }
+    HajimuPluginFn buy = fn("アイテム購入"), sell = fn("アイテム売却");
+    long ops = 0;
+    double t0 = now_ms();
+    for (int i = 0; i < 40000 * scale; ++i) {
+        Value g[1] = { N(100000) };
+        if (i % 64 == 0) gold(1, g);
+        Value a[2] = { N(i % 12 + 1), N(1 + i % 3) };   /* 容量を絞ったビルドでも溢れない範囲 */
+        add(2, a);
+        count(1, a);
+        del(2, a);
+        if (buy)  buy(2, a);
+        if (sell) sell(2, a);
+        if (i % 32 == 0) list(0, NULL);
+        ops++;
+    }
+    report("inventory", ops, now_ms() - t0);
+}
+
+static void phase_save(int scale) {
+    HajimuPluginFn save, load, snap, undo, hash, fset;
+    HajimuPluginFn* outs[] = { &save, &load, &snap, &undo, &hash, &fset };
+    const char* names[] = { "セーブ", "ロード", "スナップショット保存", "スナップショット戻す",
+                            "状態ハッシュ", "フラグ設定" };
+    if (!need(outs, names, 6)) { skipped("save"); return; }
+    long ops = 0;
+    double t0 = now_ms();
+    for (int i = 0; i < 100 * scale; ++i) {
+        Value s[1] = { N(90) };
+        save(1, s);
+        load(1, s);
+        snap(0, NULL);
+        Value f[2] = { S("world.flag3"), B(i & 1) };
+        fset(2, f);
+        undo(0, NULL);
+        hash(0, NULL);
+        ops++;
+    }
+    report("save", ops, now_ms() - t0);
+}
+
+/* 同じシードのバトル列 (ダメージ式・スキル・AI・敵 AI・経験値・ドロップ) を回し、
+ * バトルごとの状態ハッシュを hashes[] に書く */
+#define LOCKSTEP_BATTLES 50
+#define LOCKSTEP_BLOCK   25   /* この数ごとにパーティを登録し直す (間はレベルが上がっていく) */
+#define LOCKSTEP_TABLE   9    /* ドロップ表 */
+
+static void lockstep_run(int n, char (*hashes)[17]) {
+    HajimuPluginFn actor = fn("キャラ登録"), learn = fn("スキル習得"), start = fn("バトル開始");
+    HajimuPluginFn state = fn("バトル状態"), party = fn("パーティ自動行動"), enemy = fn("敵自動行動");
+    HajimuPluginFn heal = fn("HP回復"), mp = fn("MP回復"), exp = fn("経験値付与"), hash = fn("状態ハッシュ");
+    HajimuPluginFn flag = fn("フラグ設定"), drop = fn("ドロップ適用");
+    static const int k_skills[] = { 4, 5, 8 };
+    for (int b = 0; b < n; ++b) {
+        if (b % LOCKSTEP_BLOCK == 0) {
+            for (int i = 0; i < PARTY_N; ++i) {
+                Value a[7] = { N(i + 1), S("味方"), N(150 + 20 * i), N(60), N(13 + 3 * i), N(9 + i), N(5 + 4 * i) };
+                actor(7, a);
+                for (int k = 0; k < 3; ++k) { Value l[2] = { N(i + 1), N(k_skills[k]) }; learn(2, l); }
+            }
+        }
+        for (int i = 0; i < PARTY_N; ++i) {   /* 戦闘不能も起こす */
+            Value h[2] = { N(i + 1), N(9999) };
+            heal(2, h);
+            mp(2, h);
+        }
+        for (int i = 0; i < ENEMY_N; ++i) {
+            Value a[7] = { N(ENEMY_ID0 + i), S("敵"), N(70 + (b * 13 + i * 29) % 90), N(20),
+                           N(10 + (b + i) % 9), N(5 + (b * 3 + i) % 7), N(4 + (b + 2 * i) % 12) };
+            actor(7, a);
+        }
+        Value args[PARTY_N + ENEMY_N + 1];
+        int m = 0;
+        for (int i = 0; i < PARTY_N; ++i) args[m++] = N(i + 1);
+        args[m++] = N(0);
+        for (int i = 0; i < ENEMY_N; ++i) args[m++] = N(ENEMY_ID0 + i);
+        start(m, args);
+        for (int round = 0; round < 100 && state(0, NULL).number == 0; ++round) {
+            party(0, NULL);
+            for (int i = 0; i < ENEMY_N; ++i) { Value e[1] = { N(ENEMY_ID0 + i) }; enemy(1, e); }
+        }
+        Value x[2] = { N(1 + b % PARTY_N), N(20) };
+        exp(2, x);
+        /* 条件付きの行を出し入れしてエイリアス表を作り直させながらドロップを引く */
+        Value f[2] = { S("lockstep_rare"), B(b % 3 == 0) };
+        flag(2, f);
+        Value d[2] = { N(LOCKSTEP_TABLE), N(4) };
+        drop(2, d);
+        snprintf(hashes[b], 17, "%s", hash(0, NULL).string.data);
+    }
+}
+
+static void phase_lockstep(int scale) {
+    HajimuPluginFn seed, snap, undo, set_formula, tclear, titem, tgold, tnone, tseed;
+    HajimuPluginFn* outs[] = { &seed, &snap, &undo, &set_formula, &tclear, &titem, &tgold, &tnone, &tseed };
+    const char* names[] = { "バトルシード", "スナップショット保存", "スナップショット戻す", "ダメージ式設定",
+                            "テーブル初期化", "テーブルアイテム追加", "テーブルゴールド追加",
+                            "テーブルなし追加", "テーブルシード" };
+    if (!need(outs, names, 9)) { skipped("lockstep"); return; }
+    /* 固定小数点の乗除・sqrt・10 進の定数を通る式 */
+    static const char* k_formulas[][2] = {
+        { "vary(max(a.atk*3 - t.def*2, 1), 10)", "0" },
+        { "vary(power * (1 + a.lv / 10) + sqrt(a.atk * 7) - t.def, 15)", "4" },
+        { "rand(power / 3, power) + a.atk * 1.25 - t.def / 2", "5" },
+        { "max(floor(a.atk * a.spd / (t.def + 1.5)) % 40, 3) + power * 0.35", "8" },
+    };
+    for (int i = 0; i < 4; ++i) {
+        Value f[2] = { S(k_formulas[i][0]), N(atoi(k_formulas[i][1])) };
+        set_formula(2, f);
+    }
+    /* 重みの合計が 2 の冪にならない表 (閾値の割り算が端数を持つ) */
+    Value tc[1] = { N(LOCKSTEP_TABLE) };
+    tclear(1, tc);
+    for (int i = 0; i < 4; ++i) {
+        static const int k_weights[] = { 7, 13, 29, 3 };
+        Value r[5] = { N(LOCKSTEP_TABLE), N(k_weights[i]), N(1 + i), N(1), N(1 + i % 3) };
+        titem(5, r);
+    }
+    Value rg[4] = { N(LOCKSTEP_TABLE), N(10), N(5), N(40) };
+    tgold(4, rg);
+    Value rn[2] = { N(LOCKSTEP_TABLE), N(1) };
+    tnone(2, rn);
+    Value rr[6] = { N(LOCKSTEP_TABLE), N(5), N(12), N(1), N(1), S("lockstep_rare") };
+    titem(6, rr);
+    int n = LOCKSTEP_BATTLES * scale;
+    char (*first)[17] = calloc((size_t)n, sizeof(*first));
+    char (*second)[17] = calloc((size_t)n, sizeof(*second));
+    if (!first || !second) { free(first); free(second); return; }
+    Value sv[1] = { N(12345) };
+    double t0 = now_ms();
+    snap(0, NULL);
+    seed(1, sv);
+    tseed(1, sv);
+    lockstep_run(n, first);
+    undo(0, NULL);
+    seed(1, sv);
+    tseed(1, sv);
+    lockstep_run(n, second);
+    report("lockstep", 2L * n, now_ms() - t0);
+    for (int b = 0; b < n; ++b) {
+        if (strcmp(first[b], second[b]) == 0) continue;
+        printf("  lockstep   バトル %d で不一致: %s != %s\n", b, first[b], second[b]);
+        g_failed = true;
+        break;
+    }
+    printf("  lockstep   hash %s\n", second[n - 1]);
+    free(first);
+    free(second);
+}
+
+/* ── 本体 ───────────────────────────────────────────────*/
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "使い方: %s engine_rpg.hjp [倍率] [区間,...]\n", argv[0]);
+        return 2;
+    }
+    int scale = argc > 2 ? atoi(argv[2]) : 1;
+    if (scale < 1) scale = 1;
+    if (argc > 3) g_only = argv[3];
+
+    /* セーブ先は一時ディレクトリ ($HOME/.hajimu/saves) */
+    char home[] = "/tmp/rpg_workload_XXXXXX", dir[64];
+    if (!mkdtemp(home)) { perror("mkdtemp"); return 1; }
+    snprintf(dir, sizeof(dir), "%s/.hajimu", home);
+    mkdir(dir, 0755);
+    setenv("HOME", home, 1);
+
+    void* lib = dlopen(argv[1], RTLD_NOW);
+    if (!lib) { fprintf(stderr, "読み込み失敗: %s\n", dlerror()); return 1; }
+    HajimuPluginInfo* (*init)(void) = (HajimuPluginInfo* (*)(void))dlsym(lib, "hajimu_plugin_init");
+    if (!init || !(g_info = init())) { fprintf(stderr, "hajimu_plugin_init がない\n"); return 1; }
+
+    printf("%s: %d 関数, 倍率 %d\n", argv[1], g_info->function_count, scale);
+    setup_world();
+    if (selected("battle"))    phase_battle(scale);
+    if (selected("dialog"))    phase_dialog(scale);
+    if (selected("state"))     phase_state(scale);
+    if (selected("inventory")) phase_inventory(scale);
+    if (selected("save"))      phase_save(scale);
+    if (selected("lockstep"))  phase_lockstep(scale);
+    printf("  %-10s %9s      %9.2f ms\n", "total", "", g_total_ms);
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/saves/save_90.dat", dir);     unlink(path);
+    snprintf(path, sizeof(path), "%s/saves/catalog.dat", dir);     unlink(path);
+    snprintf(path, sizeof(path), "%s/saves", dir);                 rmdir(path);
+    rmdir(dir);
+    rmdir(home);
+    return g_failed ? 1 : 0;
+}